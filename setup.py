@@ -51,23 +51,44 @@ module = Extension(
         "src/Automaton.c",
         "src/Automaton.h",
         "src/Automaton_pickle.c",
+        "src/Automaton_minimize.c",
+        "src/Automaton_compact.c",
+        "src/Automaton_keyid.c",
+        "src/Automaton_spans.c",
+        "src/Automaton_masks.c",
+        "src/Automaton_alphabet.c",
+        "src/Automaton_roottable.c",
+        "src/Automaton_cache.c",
+        "src/Automaton_prefilter.c",
+        "src/Automaton_many.c",
+        "src/Automaton_optimize.c",
         "src/AutomatonItemsIter.c",
         "src/AutomatonItemsIter.h",
         "src/AutomatonSearchIter.c",
         "src/AutomatonSearchIter.h",
         "src/AutomatonSearchIterLong.c",
         "src/AutomatonSearchIterLong.h",
+        "src/AutomatonSet.c",
+        "src/AutomatonSet.h",
+        "src/AutomatonSetSearchIter.c",
+        "src/AutomatonSetSearchIter.h",
         "src/trie.c",
         "src/trie.h",
         "src/slist.c",
         "src/utils.c",
         "src/trienode.c",
         "src/trienode.h",
+        "src/nodemap.c",
+        "src/nodemap.h",
+        "src/nodemasks.c",
+        "src/nodemasks.h",
+        "src/valuetable.c",
+        "src/valuetable.h",
+        "src/valuecolumn.c",
+        "src/valuecolumn.h",
         "src/msinttypes/stdint.h",
         "src/inline_doc.h",
         "src/pickle/pickle.h",
-        "src/pickle/pickle_data.h",
-        "src/pickle/pickle_data.c",
         "src/custompickle/custompickle.h",
         "src/custompickle/custompickle.c",
         "src/custompickle/pyhelpers.h",
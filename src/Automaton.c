@@ -16,6 +16,17 @@
 
 static PyTypeObject automaton_type;
 
+/* incremented together with a version of any automaton; lets an AutomatonSet
+   look at versions of its automatons only when something has changed */
+static unsigned long automaton_changes = 0;
+
+
+static void
+automaton_bump_version(Automaton* automaton) {
+    automaton->version += 1;
+    automaton_changes  += 1;
+}
+
 
 static bool
 check_store(const int store) {
@@ -23,18 +34,56 @@ check_store(const int store) {
         case STORE_LENGTH:
         case STORE_INTS:
         case STORE_ANY:
+        case STORE_BYTES:
+        case STORE_INT64:
+        case STORE_FLOAT:
+        case STORE_KEY_ID:
+        case STORE_MULTI_INTS:
             return true;
 
         default:
             PyErr_SetString(
                 PyExc_ValueError,
-                "store value must be one of ahocorasick.STORE_LENGTH, STORE_INTS or STORE_ANY"
+                "store value must be one of ahocorasick.STORE_LENGTH, STORE_INTS, STORE_ANY, "
+                "STORE_BYTES, STORE_INT64, STORE_FLOAT, STORE_KEY_ID or STORE_MULTI_INTS"
             );
             return false;
     } // switch
 }
 
 
+static bool
+check_engine(const int engine) {
+    switch (engine) {
+        case ENGINE_AUTO:
+        case ENGINE_TRIE:
+        case ENGINE_LETTERS:
+        case ENGINE_BIGRAMS:
+        case ENGINE_SHIFTS:
+            return true;
+
+        default:
+            PyErr_SetString(
+                PyExc_ValueError,
+                "engine value must be one of ahocorasick.ENGINE_AUTO, ENGINE_TRIE, "
+                "ENGINE_LETTERS, ENGINE_BIGRAMS or ENGINE_SHIFTS"
+            );
+            return false;
+    }
+}
+
+
+static bool
+check_cache_size(const Py_ssize_t size) {
+    if (size < 0 or size > AUTOMATON_CACHE_MAX_SIZE) {
+        PyErr_Format(PyExc_ValueError, "cache size must be in range 0 .. %d", AUTOMATON_CACHE_MAX_SIZE);
+        return false;
+    }
+
+    return true;
+}
+
+
 static bool
 check_kind(const int kind) {
     switch (kind) {
@@ -89,6 +138,36 @@ automaton_create() {
     automaton->stats.version = -1;
 
     automaton->root = NULL;
+    automaton->minimized = false;
+    automaton->pool = NULL;
+    automaton->pool_size = 0;
+    automaton->edges_pool = NULL;
+    automaton->edges_pool_size = 0;
+    valuetable_init(&automaton->values);
+    valuecolumn_init(&automaton->column, false);
+    automaton->key_letters = NULL;
+    automaton->key_offsets = NULL;
+    automaton->key_count = 0;
+    automaton->key_table_version = -1;
+    nodemasks_init(&automaton->key_masks);
+    nodemasks_init(&automaton->chain_masks);
+    automaton->pool_chain_masks = NULL;
+    automaton->chain_masks_version = -1;
+    automaton->engine = ENGINE_AUTO;
+    automaton->prefilter.version = -1;
+    automaton->prefilter.bigrams = NULL;
+    automaton->prefilter.shifts = NULL;
+    automaton->prefilter.root_table = NULL;
+    automaton->prefilter.root_pages = 0;
+    automaton->prefilter.letter_pages = NULL;
+    automaton->prefilter.letter_classes = NULL;
+    automaton->prefilter.class_pages = 0;
+    automaton->prefilter.alphabet_size = 0;
+    automaton->prefilter.cache = NULL;
+    automaton->prefilter.cache_bits = 0;
+    automaton->prefilter.cache_hits = 0;
+    automaton->prefilter.cache_misses = 0;
+    automaton->cache_size = 0;
 
     return (PyObject*)automaton;
 }
@@ -104,7 +183,14 @@ automaton_new(PyTypeObject* self, PyObject* args, PyObject* kwargs) {
         return NULL;
 
 
-    if (UNLIKELY(PyTuple_Size(args) == 7)) {
+    if (UNLIKELY(PyTuple_Size(args) == 2 and F(PyObject_CheckBuffer)(PyTuple_GET_ITEM(args, 0)))) {
+
+        // unpickle: (data, values)
+        if (!automaton_unpickle3(automaton, PyTuple_GET_ITEM(args, 0), PyTuple_GET_ITEM(args, 1))) {
+            goto error;
+        }
+    }
+    else if (UNLIKELY(PyTuple_Size(args) == 7)) {
 
         int             word_count;
         int             longest_word;
@@ -125,6 +211,12 @@ automaton_new(PyTypeObject* self, PyObject* args, PyObject* kwargs) {
             goto error;
         }
 
+        // the legacy format has no place for native value columns
+        if (store_is_column(store)) {
+            PyErr_SetString(PyExc_ValueError, "Unable to load from pickle.");
+            goto error;
+        }
+
         if (!PyList_CheckExact(bytes_list)) {
             PyErr_SetString(PyExc_TypeError, "Expected list");
             goto error;
@@ -170,6 +262,7 @@ automaton_new(PyTypeObject* self, PyObject* args, PyObject* kwargs) {
         PyErr_Clear();
         automaton->store    = store;
         automaton->key_type = key_type;
+        valuecolumn_init(&automaton->column, store_column_is_bytes(store));
     }
 
 //ok:
@@ -199,16 +292,267 @@ automaton_len(PyObject* self) {
 
 
 static PyObject*
-automaton_add_word(PyObject* self, PyObject* args) {
+automaton_build_value(Automaton* automaton, TrieNode* node) {
+
+    PyObject* value;
+    PyObject* item;
+    uint64_t bits;
+    double number;
+    size_t count;
+    size_t i;
+
+    ASSERT(node->eow);
+
+    switch (automaton->store) {
+        case STORE_ANY:
+            value = automaton_get_value(automaton, node);
+            Py_INCREF(value);
+            return value;
+
+        case STORE_BYTES:
+            return F(PyBytes_FromStringAndSize)(
+                valuecolumn_get_bytes(&automaton->column, node->output),
+                valuecolumn_get_length(&automaton->column, node->output)
+            );
+
+        case STORE_INT64:
+            bits = valuecolumn_get(&automaton->column, node->output);
+            return F(PyLong_FromLongLong)((long long)(int64_t)bits);
+
+        case STORE_FLOAT:
+            bits = valuecolumn_get(&automaton->column, node->output);
+            memcpy(&number, &bits, sizeof(double));
+            return F(PyFloat_FromDouble)(number);
+
+        case STORE_MULTI_INTS:
+            count = automaton_payload_count(automaton, node);
+            value = F(PyTuple_New)((Py_ssize_t)count);
+            if (UNLIKELY(value == NULL)) {
+                return NULL;
+            }
+
+            for (i=0; i < count; i++) {
+                item = automaton_build_payload(automaton, node, i);
+                if (UNLIKELY(item == NULL)) {
+                    Py_DECREF(value);
+                    return NULL;
+                }
+
+                PyTuple_SET_ITEM(value, i, item);
+            }
+
+            return value;
+
+        default:
+            return F(PyLong_FromSsize_t)((Py_ssize_t)node->output);
+    } // switch
+}
+
+
+static PyObject*
+automaton_build_payload(Automaton* automaton, TrieNode* node, size_t index) {
+
+    int64_t integer;
+
+    ASSERT(index < automaton_payload_count(automaton, node));
+
+    // integers are packed in the arena, they may be unaligned
+    memcpy(&integer, valuecolumn_get_bytes(&automaton->column, node->output) + index * sizeof(int64_t), sizeof(int64_t));
+    return F(PyLong_FromLongLong)((long long)integer);
+}
+
+
+static void
+automaton_remove_value(Automaton* automaton, TrieNode* node) {
+
+    ASSERT(node->eow);
+
+    if (automaton->store == STORE_ANY) {
+        Py_DECREF(valuetable_remove(&automaton->values, node->output));
+    } else if (store_is_column(automaton->store)) {
+        valuecolumn_remove(&automaton->column, node->output);
+    }
+
+    automaton_remove_key_mask(automaton, node);
+}
+
+
+/* converts a value of a column store into a 64-bit word; for STORE_BYTES
+   the word is the length of a byte string */
+static bool
+automaton_parse_column_value(Automaton* automaton, PyObject* py_value, uint64_t* bits) {
+
+    long long integer;
+    double number;
+
+    switch (automaton->store) {
+        case STORE_BYTES:
+            if (not PyBytes_Check(py_value)) {
+                PyErr_SetString(PyExc_TypeError, "A bytes value is required.");
+                return false;
+            }
+
+            if (UNLIKELY((size_t)PyBytes_GET_SIZE(py_value) > VALUECOLUMN_MAX_LENGTH)) {
+                PyErr_SetString(PyExc_ValueError, "A bytes value is too long.");
+                return false;
+            }
+
+            *bits = (uint64_t)PyBytes_GET_SIZE(py_value);
+            return true;
+
+        case STORE_MULTI_INTS:
+        case STORE_INT64:
+            if (not PyLong_Check(py_value)) {
+                PyErr_SetString(PyExc_TypeError, "An integer value is required.");
+                return false;
+            }
+
+            integer = F(PyLong_AsLongLong)(py_value);
+            if (integer == -1 and PyErr_Occurred()) {
+                return false;
+            }
+
+            *bits = (uint64_t)integer;
+            return true;
+
+        case STORE_FLOAT:
+            number = F(PyFloat_AsDouble)(py_value);
+            if (number == -1.0 and PyErr_Occurred()) {
+                return false;
+            }
+
+            memcpy(bits, &number, sizeof(double));
+            return true;
+
+        default:
+            return true;
+    } // switch
+}
+
+
+/* makes room for count values having in total length bytes (STORE_BYTES),
+   then assigning them can't fail */
+static bool
+automaton_reserve_values(Automaton* automaton, size_t count, size_t length) {
+
+    if (automaton->store == STORE_ANY) {
+        return valuetable_reserve(&automaton->values, count);
+    }
+
+    if (store_is_column(automaton->store)) {
+        return valuecolumn_reserve(&automaton->column, count, length);
+    }
+
+    return true;
+}
+
+
+/* length of bytes needed to append count integers to payloads of a key
+   one by one (STORE_MULTI_INTS): each append copies the current payloads */
+static bool
+automaton_multi_length(Automaton* automaton, const TRIE_LETTER_TYPE* word, size_t wordlen, size_t count, size_t* length) {
+
+    TrieNode* node = NULL;
+    size_t old = 0;
+
+    if (automaton->kind != EMPTY) {
+        node = trie_find(automaton->root, word, wordlen);
+    }
+
+    if (node != NULL and node->eow) {
+        old = valuecolumn_get_length(&automaton->column, node->output);
+    }
+
+    if (UNLIKELY(count > (VALUECOLUMN_MAX_LENGTH - old) / sizeof(int64_t))) {
+        PyErr_SetString(PyExc_ValueError, "Too many integers associated with a key.");
+        return false;
+    }
+
+    *length = count * old + sizeof(int64_t) * count * (count + 1) / 2;
+    return true;
+}
+
+
+static void
+automaton_set_output(Automaton* automaton, TrieNode* node, bool new_word, PyObject* py_value, Py_ssize_t integer, uint64_t bits) {
+
+    size_t index;
+
+    // a slot has been already reserved by the caller
+    switch (automaton->store) {
+        case STORE_ANY:
+            if (not new_word and node->eow) {
+                valuetable_replace(&automaton->values, node->output, py_value);
+            } else {
+                valuetable_add(&automaton->values, py_value, &index);
+                node->output = index;
+            }
+            break;
+
+        case STORE_BYTES:
+            if (not new_word and node->eow) {
+                valuecolumn_replace_bytes(&automaton->column, node->output, PyBytes_AS_STRING(py_value), (size_t)bits);
+            } else {
+                valuecolumn_add_bytes(&automaton->column, PyBytes_AS_STRING(py_value), (size_t)bits, &index);
+                node->output = index;
+            }
+            break;
+
+        case STORE_MULTI_INTS:
+            if (not new_word and node->eow) {
+                valuecolumn_append_bytes(&automaton->column, node->output, (const char*)&bits, sizeof(int64_t));
+            } else {
+                valuecolumn_add_bytes(&automaton->column, (const char*)&bits, sizeof(int64_t), &index);
+                node->output = index;
+            }
+            break;
+
+        case STORE_INT64:
+        case STORE_FLOAT:
+            if (not new_word and node->eow) {
+                valuecolumn_replace(&automaton->column, node->output, bits);
+            } else {
+                valuecolumn_add(&automaton->column, bits, &index);
+                node->output = index;
+            }
+            break;
+
+        case STORE_KEY_ID:
+            // an existing key keeps its id
+            if (new_word) {
+                node->output = integer;
+            }
+            break;
+
+        default:
+            node->output = integer;
+    } // switch
+}
+
+
+static PyObject*
+automaton_add_word(PyObject* self, PyObject* args, PyObject* kwargs) {
 #define automaton ((Automaton*)self)
     // argument
     PyObject* py_value = NULL;
     struct Input input;
 
     Py_ssize_t integer = 0;
+    uint64_t bits = 0;
+    uint64_t mask = 0;
+    bool use_mask;
+    size_t length;
     TrieNode* node;
     bool new_word;
 
+    if (!automaton_check_not_minimized(automaton) or !automaton_release_edges_pool(automaton)) {
+        return NULL;
+    }
+
+    if (!automaton_parse_mask_kwarg(kwargs, &mask, &use_mask)) {
+        return NULL;
+    }
+
     if (!prepare_input_from_tuple(self, args, 0, &input)) {
         return NULL;
     }
@@ -246,6 +590,26 @@ automaton_add_word(PyObject* self, PyObject* args) {
             integer = input.wordlen;
             break;
 
+        case STORE_KEY_ID:
+            // a temporary id, make_automaton numerates keys again
+            integer = automaton->count;
+            break;
+
+        case STORE_BYTES:
+        case STORE_INT64:
+        case STORE_FLOAT:
+        case STORE_MULTI_INTS:
+            py_value = F(PyTuple_GetItem)(args, 1);
+            if (not py_value) {
+                PyErr_SetString(PyExc_ValueError, "A value object is required as second argument.");
+                goto py_exception;
+            }
+
+            if (not automaton_parse_column_value(automaton, py_value, &bits)) {
+                goto py_exception;
+            }
+            break;
+
         default:
             PyErr_SetString(PyExc_SystemError, "Invalid value for this key: see documentation for supported values.");
             goto py_exception;
@@ -254,6 +618,21 @@ automaton_add_word(PyObject* self, PyObject* args) {
     node = NULL;
     new_word = false;
 
+    length = 0;
+    if (automaton->store == STORE_BYTES) {
+        length = (size_t)bits;
+    } else if (automaton->store == STORE_MULTI_INTS) {
+        if (not automaton_multi_length(automaton, input.word, input.wordlen, 1, &length)) {
+            goto py_exception;
+        }
+    }
+
+    if (UNLIKELY(!automaton_reserve_values(automaton, 1, length))
+        or (use_mask and UNLIKELY(!nodemasks_reserve(&automaton->key_masks, 1)))) {
+        PyErr_NoMemory();
+        goto py_exception;
+    }
+
     if (input.wordlen > 0) {
         node = trie_add_word(automaton, input.word, input.wordlen, &new_word);
 
@@ -266,22 +645,13 @@ automaton_add_word(PyObject* self, PyObject* args) {
     destroy_input(&input);
 
     if (node) {
-        switch (automaton->store) {
-            case STORE_ANY:
-                if (not new_word and node->eow)
-                    // replace
-                    Py_DECREF(node->output.object);
-
-                Py_INCREF(py_value);
-                node->output.object = py_value;
-                break;
-
-            default:
-                node->output.integer = integer;
-        } // switch
+        automaton_set_output(automaton, node, new_word, py_value, integer, bits);
+        if (use_mask) {
+            automaton_add_key_mask(automaton, node, mask); // space is reserved
+        }
 
         if (new_word) {
-            automaton->version += 1; // change version only when new word appeared
+            automaton_bump_version(automaton); // change version only when new word appeared
             if (input.wordlen > automaton->longest_word)
                 automaton->longest_word = (int)input.wordlen;
 
@@ -297,13 +667,313 @@ automaton_add_word(PyObject* self, PyObject* args) {
 py_exception:
     destroy_input(&input);
     return NULL;
+#undef automaton
+}
+
+
+typedef struct AddWordsItem {
+    struct Input    input;
+    PyObject*       py_value;   ///< borrowed reference (STORE_ANY, STORE_BYTES)
+    Py_ssize_t      integer;    ///< value (STORE_INTS, STORE_LENGTH)
+    uint64_t        bits;       ///< value or length of bytes (STORE_BYTES, STORE_INT64, STORE_FLOAT)
+    bool            has_value;  ///< value was given explicitly
+    TrieNode*       node;       ///< node assigned to the key
+    bool            new_word;
+} AddWordsItem;
+
+
+static int
+add_words_item_cmp(const void* a, const void* b) {
+
+    const AddWordsItem* A = *(const AddWordsItem**)a;
+    const AddWordsItem* B = *(const AddWordsItem**)b;
+    const Py_ssize_t n = (A->input.wordlen < B->input.wordlen) ? A->input.wordlen : B->input.wordlen;
+    Py_ssize_t i;
+
+    for (i=0; i < n; i++) {
+        if (A->input.word[i] != B->input.word[i]) {
+            return (A->input.word[i] < B->input.word[i]) ? -1 : +1;
+        }
+    }
+
+    if (A->input.wordlen != B->input.wordlen) {
+        return (A->input.wordlen < B->input.wordlen) ? -1 : +1;
+    }
+
+    // keep the input order of duplicated keys
+    return (A < B) ? -1 : (A > B);
+}
+
+
+static bool
+add_words_same_key(const AddWordsItem* A, const AddWordsItem* B) {
+
+    return A->input.wordlen == B->input.wordlen
+       and memcmp(A->input.word, B->input.word, A->input.wordlen * sizeof(TRIE_LETTER_TYPE)) == 0;
+}
+
+
+static bool
+add_words_prepare_item(Automaton* automaton, PyObject* object, AddWordsItem* item) {
+
+    PyObject* key;
+
+    item->py_value  = NULL;
+    item->integer   = 0;
+    item->bits      = 0;
+    item->has_value = false;
+    item->node      = NULL;
+    item->new_word  = false;
+
+    if (automaton->store == STORE_LENGTH or automaton->store == STORE_KEY_ID) {
+        key = object;
+    } else {
+        if (not PyTuple_Check(object) or PyTuple_GET_SIZE(object) != 2) {
+            // a key of KEY_SEQUENCE is a tuple itself, a bare key would be
+            // ambiguous with a pair, thus the pair is always required
+            if (store_has_index(automaton->store) or automaton->key_type == KEY_SEQUENCE) {
+                PyErr_SetString(PyExc_TypeError, "A (key, value) tuple is expected.");
+                return false;
+            }
+
+            key = object;
+        } else {
+            key = PyTuple_GET_ITEM(object, 0);
+            item->py_value  = PyTuple_GET_ITEM(object, 1);
+            item->has_value = true;
+        }
+    }
+
+    if (automaton->store == STORE_INTS and item->has_value) {
+        if (F(PyNumber_Check)(item->py_value)) {
+            item->integer = F(PyNumber_AsSsize_t)(item->py_value, PyExc_ValueError);
+            if (item->integer == -1 and PyErr_Occurred())
+                return false;
+        }
+        else {
+            PyErr_SetString(PyExc_TypeError, "An integer value is required as second item of a tuple.");
+            return false;
+        }
+    }
+
+    if (store_is_column(automaton->store) and not automaton_parse_column_value(automaton, item->py_value, &item->bits)) {
+        return false;
+    }
+
+    if (not prepare_input((PyObject*)automaton, key, &item->input)) {
+        return false;
+    }
+
+    if (automaton->store == STORE_LENGTH) {
+        item->integer = item->input.wordlen;
+    }
+
+    return true;
+}
+
+
+static PyObject*
+automaton_add_words(PyObject* self, PyObject* args, PyObject* kwargs) {
+#define automaton ((Automaton*)self)
+    PyObject* iterable;
+    PyObject* sequence;
+    PyObject** objects;
+    PyObject* result = NULL;
+    AddWordsItem* items = NULL;
+    AddWordsItem** sorted = NULL;
+    TrieNode** path = NULL;
+    AddWordsItem* prev;
+    AddWordsItem* item;
+    Py_ssize_t n;
+    Py_ssize_t prepared = 0;
+    Py_ssize_t count;
+    Py_ssize_t added;
+    Py_ssize_t longest;
+    Py_ssize_t i;
+    Py_ssize_t k;
+    Py_ssize_t prefix;
+    Py_ssize_t j;
+    size_t length;
+    size_t run;
+    uint64_t mask = 0;
+    bool use_mask;
+    bool failed = false;
+
+    if (not F(PyArg_ParseTuple)(args, "O", &iterable)) {
+        return NULL;
+    }
+
+    if (not automaton_parse_mask_kwarg(kwargs, &mask, &use_mask)) {
+        return NULL;
+    }
+
+    if (!automaton_check_not_minimized(automaton) or !automaton_release_edges_pool(automaton)) {
+        return NULL;
+    }
+
+    sequence = F(PySequence_Fast)(iterable, "An iterable is expected.");
+    if (sequence == NULL) {
+        return NULL;
+    }
+
+    n       = PySequence_Fast_GET_SIZE(sequence);
+    objects = PySequence_Fast_ITEMS(sequence);
+    if (n == 0) {
+        Py_DECREF(sequence);
+        return F(Py_BuildValue)("i", 0);
+    }
+
+    items  = (AddWordsItem*)memory_alloc(n * sizeof(AddWordsItem));
+    sorted = (AddWordsItem**)memory_alloc(n * sizeof(AddWordsItem*));
+    if (items == NULL or sorted == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    // 1. extract all keys and values; nothing is modified in case of error
+    longest = 0;
+    length = 0;
+    k = 0;
+    for (i=0; i < n; i++) {
+        item = &items[prepared];
+        if (not add_words_prepare_item(automaton, objects[i], item)) {
+            goto error;
+        }
+
+        prepared += 1;
+        if (item->input.wordlen > 0) {
+            sorted[k++] = item;
+            if (item->input.wordlen > longest)
+                longest = item->input.wordlen;
+
+            if (automaton->store == STORE_BYTES)
+                length += (size_t)item->bits;
+        }
+    }
+
+    if (k == 0) {
+        added = 0;
+        goto done;
+    }
+
+    // 2. sort keys, so each subtree of the root is built at once and the path
+    //    of a key shared with the previous one is never looked up again
+    qsort(sorted, k, sizeof(AddWordsItem*), add_words_item_cmp);
+
+    if (automaton->store == STORE_MULTI_INTS) {
+        // integers of a repeated key are appended one by one
+        for (i=0; i < k; i = j) {
+            j = i + 1;
+            while (j < k and add_words_same_key(sorted[i], sorted[j]))
+                j += 1;
+
+            if (not automaton_multi_length(automaton, sorted[i]->input.word, sorted[i]->input.wordlen, j - i, &run)) {
+                goto error;
+            }
+
+            length += run;
+        }
+    }
+
+    path = (TrieNode**)memory_alloc((longest + 1) * sizeof(TrieNode*));
+    if (path == NULL or !automaton_reserve_values(automaton, k, length)
+        or (use_mask and !nodemasks_reserve(&automaton->key_masks, k))) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    prev = NULL;
+    for (i=0; i < k; i++) {
+        item = sorted[i];
+
+        prefix = 0;
+        if (prev != NULL) {
+            const Py_ssize_t m = (prev->input.wordlen < item->input.wordlen) ? prev->input.wordlen : item->input.wordlen;
+            while (prefix < m and prev->input.word[prefix] == item->input.word[prefix])
+                prefix += 1;
+        }
+
+        item->node = trie_add_word_with_path(automaton, item->input.word, item->input.wordlen, prefix, path, &item->new_word);
+        if (item->node == NULL) {
+            PyErr_NoMemory();
+            failed = true;
+            break;
+        }
+
+        prev = item;
+    }
+
+    // 3. assign values in the input order, exactly as subsequent calls
+    //    to add_word would do; also done for keys added before a failure
+    count = automaton->count;
+    for (i=0; i < k; i++) {
+        if (sorted[i]->new_word)
+            count -= 1;
+    }
+
+    added = 0;
+    for (i=0; i < prepared; i++) {
+        item = &items[i];
+        if (item->node == NULL) {
+            continue;
+        }
+
+        if (automaton->store == STORE_INTS and not item->has_value) {
+            item->integer = count + 1;
+        }
+
+        if (automaton->store == STORE_KEY_ID) {
+            item->integer = count;
+        }
+
+        automaton_set_output(automaton, item->node, item->new_word, item->py_value, item->integer, item->bits);
+        if (use_mask) {
+            automaton_add_key_mask(automaton, item->node, mask); // space is reserved
+        }
+
+        if (item->new_word) {
+            count += 1;
+            added += 1;
+            if (item->input.wordlen > automaton->longest_word)
+                automaton->longest_word = (int)item->input.wordlen;
+        }
+    }
+
+    if (added > 0) {
+        automaton_bump_version(automaton); // change version only when new words appeared
+    }
+
+    if (failed) {
+        goto error;
+    }
+
+done:
+    result = F(Py_BuildValue)("n", added);
+
+error:
+    for (i=0; i < prepared; i++) {
+        destroy_input(&items[i].input);
+    }
+
+    memory_safefree(path);
+    memory_safefree(sorted);
+    memory_safefree(items);
+    Py_DECREF(sequence);
+
+    return result;
+#undef automaton
 }
 
+
 static TristateResult
 automaton_remove_word_aux(PyObject* self, PyObject* args, PyObject** value) {
 #define automaton ((Automaton*)self)
     struct Input input;
 
+    if (!automaton_check_not_minimized(automaton) or !automaton_release_edges_pool(automaton)) {
+        return MEMORY_ERROR;
+    }
+
     if (!prepare_input_from_tuple(self, args, 0, &input)) {
         return MEMORY_ERROR;
     }
@@ -321,11 +991,13 @@ automaton_remove_word_aux(PyObject* self, PyObject* args, PyObject** value) {
     } else {
         return (*value != NULL) ? TRUE : FALSE;
     }
+#undef automaton
 }
 
 
 static PyObject*
 automaton_remove_word(PyObject* self, PyObject* args) {
+#define automaton ((Automaton*)self)
     PyObject* value;
 
     switch (automaton_remove_word_aux(self, args, &value)) {
@@ -334,12 +1006,8 @@ automaton_remove_word(PyObject* self, PyObject* args) {
             break;
 
         case TRUE:
-            if (automaton->store == STORE_ANY) {
-                // value is meaningful
-                Py_DECREF(value);
-            }
-
-            automaton->version += 1;
+            Py_DECREF(value);
+            automaton_bump_version(automaton);
             automaton->count   -= 1;
             Py_RETURN_TRUE;
             break;
@@ -348,11 +1016,13 @@ automaton_remove_word(PyObject* self, PyObject* args) {
         default:
             return NULL;
     }
+#undef automaton
 }
 
 
 static PyObject*
 automaton_pop(PyObject* self, PyObject* args) {
+#define automaton ((Automaton*)self)
     PyObject* value;
 
     switch (automaton_remove_word_aux(self, args, &value)) {
@@ -361,7 +1031,7 @@ automaton_pop(PyObject* self, PyObject* args) {
             return NULL;
 
         case TRUE:
-            automaton->version += 1;
+            automaton_bump_version(automaton);
             automaton->count   -= 1;
             return value; // there's no need to increase refcount, the value was removed
 
@@ -369,34 +1039,23 @@ automaton_pop(PyObject* self, PyObject* args) {
         default:
             return NULL;
     }
+#undef automaton
 }
 
 
 static void
-clear_aux(TrieNode* node, KeysStore store) {
+clear_aux(Automaton* automaton, TrieNode* node) {
 
     unsigned i;
 
     if (node) {
-        switch (store) {
-            case STORE_INTS:
-            case STORE_LENGTH:
-                // nop
-                break;
-
-            case STORE_ANY:
-                if (node->eow && node->output.object)
-                    Py_DECREF(node->output.object);
-                break;
-        }
-
         for (i=0; i < node->n; i++) {
             TrieNode* child = trienode_get_ith_unsafe(node, i);
             if (child != node) // avoid self-loops!
-                clear_aux(child, store);
+                clear_aux(automaton, child);
         }
 
-        trienode_free(node);
+        trie_free_node(automaton, node);
     }
 #undef automaton
 }
@@ -405,12 +1064,30 @@ clear_aux(TrieNode* node, KeysStore store) {
 static PyObject*
 automaton_clear(PyObject* self, PyObject* args) {
 #define automaton ((Automaton*)self)
-    clear_aux(automaton->root, automaton->store);
+    if (automaton->minimized)
+        automaton_clear_minimized(automaton);
+    else
+        clear_aux(automaton, automaton->root);
+
+    memory_safefree(automaton->pool);
+    memory_safefree(automaton->edges_pool);
+    automaton->pool = NULL;
+    automaton->pool_size = 0;
+    automaton->edges_pool = NULL;
+    automaton->edges_pool_size = 0;
+    automaton->minimized = false;
     automaton->count = 0;
     automaton->longest_word = 0;
     automaton->kind = EMPTY;
     automaton->root = NULL;
-    automaton->version += 1;
+    automaton_bump_version(automaton);
+
+    // nodes keep only indices, values are released at once
+    valuetable_clear(&automaton->values);
+    valuecolumn_clear(&automaton->column);
+    automaton_free_key_table(automaton);
+    automaton_free_masks(automaton);
+    automaton_free_prefilter(automaton);
 
     Py_RETURN_NONE;
 #undef automaton
@@ -525,11 +1202,19 @@ automaton_get(PyObject* self, PyObject* args) {
         switch (automaton->store) {
             case STORE_INTS:
             case STORE_LENGTH:
-                return F(Py_BuildValue)("i", node->output.integer);
+            case STORE_KEY_ID:
+                return F(Py_BuildValue)("n", (Py_ssize_t)node->output);
 
             case STORE_ANY:
-                Py_INCREF(node->output.object);
-                return node->output.object;
+                py_def = automaton_get_value(automaton, node);
+                Py_INCREF(py_def);
+                return py_def;
+
+            case STORE_BYTES:
+            case STORE_INT64:
+            case STORE_FLOAT:
+            case STORE_MULTI_INTS:
+                return automaton_build_value(automaton, node);
 
             default:
                 PyErr_SetNone(PyExc_ValueError);
@@ -558,18 +1243,46 @@ typedef struct AutomatonQueueItem {
 
 
 static PyObject*
-automaton_make_automaton(PyObject* self, PyObject* args) {
+automaton_make_automaton(PyObject* self, PyObject* args, PyObject* kwargs) {
 #define automaton ((Automaton*)self)
 
+    static char *kwlist[] = {"engine", "cache", NULL};
+
     AutomatonQueueItem* item;
     List queue;
     unsigned i;
+    int engine;
+    Py_ssize_t cache_size;
 
     TrieNode* node;
     TrieNode* child;
     TrieNode* state;
     TRIE_LETTER_TYPE letter;
 
+    // settings which aren't given are kept; args are NULL when called internally
+    engine     = (int)automaton->engine;
+    cache_size = (Py_ssize_t)automaton->cache_size;
+    if (args != NULL) {
+        if (!F(PyArg_ParseTupleAndKeywords)(args, kwargs, "|in", kwlist, &engine, &cache_size)) {
+            return NULL;
+        }
+
+        if (!check_engine(engine) or !check_cache_size(cache_size)) {
+            return NULL;
+        }
+    }
+
+    if (automaton->engine != (AutomatonEngine)engine or automaton->cache_size != (size_t)cache_size) {
+        automaton->engine = (AutomatonEngine)engine;
+        automaton->cache_size = (size_t)cache_size;
+
+        // iterators of a built automaton stay valid, thus the prefilter
+        // is rebuilt at once for the current version
+        automaton->prefilter.version = -1;
+        if (automaton->kind == AHOCORASICK) {
+            automaton_update_prefilter(automaton);
+        }
+    }
 
     if (automaton->kind != TRIE)
         Py_RETURN_FALSE;
@@ -637,8 +1350,21 @@ automaton_make_automaton(PyObject* self, PyObject* args) {
     }
 
     automaton->kind = AHOCORASICK;
-    automaton->version += 1;
+    automaton_bump_version(automaton);
     list_delete(&queue);
+
+    if (automaton->key_masks.count > 0) {
+        automaton_prune_key_masks(automaton);
+    }
+
+    if (not automaton_prepare_chain_masks(automaton)) {
+        return NULL;
+    }
+
+    if (automaton->store == STORE_KEY_ID and not automaton_build_key_table(automaton)) {
+        return NULL;
+    }
+
     Py_RETURN_NONE;
 #undef automaton
 
@@ -649,8 +1375,22 @@ no_mem:
 }
 
 
+/* a callback of find_all() may modify the automaton, then nodes being
+   visited are no longer valid and the search can't continue */
+static bool
+automaton_check_callback_version(const Automaton* automaton, const int version) {
+
+    if (UNLIKELY(automaton->version != version)) {
+        PyErr_SetString(PyExc_ValueError, "underlaying automaton has changed by the callback, search can't continue");
+        return false;
+    }
+
+    return true;
+}
+
+
 static PyObject*
-automaton_find_all(PyObject* self, PyObject* args) {
+automaton_find_all(PyObject* self, PyObject* args, PyObject* kwargs) {
 #define automaton ((Automaton*)self)
 
     struct Input input;
@@ -658,14 +1398,22 @@ automaton_find_all(PyObject* self, PyObject* args) {
     Py_ssize_t end;
     PyObject* callback;
     PyObject* callback_ret;
+    uint64_t mask = 0;
+    bool use_mask;
 
     Py_ssize_t i;
+    size_t k;
     TrieNode* state;
     TrieNode* tmp;
+    int version;
 
     if (automaton->kind != AHOCORASICK)
         Py_RETURN_NONE;
 
+    if (not automaton_parse_search_mask(automaton, kwargs, &mask, &use_mask)) {
+        return NULL;
+    }
+
     // arg 1
     if (!prepare_input_from_tuple(self, args, 0, &input)) {
         return NULL;
@@ -690,23 +1438,62 @@ automaton_find_all(PyObject* self, PyObject* args) {
         return NULL;
     }
 
+    automaton_update_prefilter(automaton);
+    version = automaton->version;
+
     state = automaton->root;
     for (i=start; i < end; i++) {
-        state = tmp = ahocorasick_next(state, automaton->root, input.word[i]);
+        if (state == automaton->root) {
+            i = automaton_skip_root(automaton, input.word, i, end);
+            if (i == end) {
+                break;
+            }
+        }
+
+        state = tmp = automaton_next(automaton, state, input.word[i]);
+        if (use_mask and (automaton_chain_mask(automaton, state) & mask) == 0) {
+            continue;
+        }
 
         // return output
         while (tmp) {
+            if (use_mask and tmp->eow and (automaton_key_mask(automaton, tmp) & mask) == 0) {
+                // skip the key
+            } else
+            if (tmp->eow and automaton->store == STORE_MULTI_INTS) {
+                // the callback is called for each integer
+                for (k=0; k < automaton_payload_count(automaton, tmp); k++) {
+                    callback_ret = F(PyObject_CallFunction)(callback, "iN", i, automaton_build_payload(automaton, tmp, k));
+                    if (callback_ret == NULL) {
+                        destroy_input(&input);
+                        return NULL;
+                    } else
+                        Py_DECREF(callback_ret);
+
+                    if (not automaton_check_callback_version(automaton, version)) {
+                        destroy_input(&input);
+                        return NULL;
+                    }
+                }
+            } else
             if (tmp->eow) {
                 if (automaton->store == STORE_ANY)
-                    callback_ret = F(PyObject_CallFunction)(callback, "iO", i, tmp->output.object);
+                    callback_ret = F(PyObject_CallFunction)(callback, "iO", i, automaton_get_value(automaton, tmp));
+                else if (store_is_column(automaton->store))
+                    callback_ret = F(PyObject_CallFunction)(callback, "iN", i, automaton_build_value(automaton, tmp));
                 else
-                    callback_ret = F(PyObject_CallFunction)(callback, "ii", i, tmp->output.integer);
+                    callback_ret = F(PyObject_CallFunction)(callback, "in", i, (Py_ssize_t)tmp->output);
 
                 if (callback_ret == NULL) {
                     destroy_input(&input);
                     return NULL;
                 } else
                     Py_DECREF(callback_ret);
+
+                if (not automaton_check_callback_version(automaton, version)) {
+                    destroy_input(&input);
+                    return NULL;
+                }
             }
 
             tmp = tmp->fail;
@@ -832,6 +1619,17 @@ automaton_items_create(PyObject* self, PyObject* args, const ItemsType type) {
 
     if (iter) {
         iter->type = type;
+
+        // all keys are read from the key table rather than from the trie
+        if (type == ITER_KEYS and wordlen == 0 and matchtype == MATCH_AT_LEAST_PREFIX and automaton->store == STORE_KEY_ID and automaton->kind == AHOCORASICK) {
+            if (not automaton_check_key_table(automaton)) {
+                Py_DECREF(iter);
+                return NULL;
+            }
+
+            iter->key_id = 0;
+        }
+
         return (PyObject*)iter;
     }
     else
@@ -873,11 +1671,16 @@ automaton_items(PyObject* self, PyObject* args) {
 
 
 static PyObject*
-automaton_iter(PyObject* self, PyObject* args, PyObject* keywds) {
+automaton_iter_impl(PyObject* self, PyObject* args, PyObject* keywds, bool spans) {
 #define automaton ((Automaton*)self)
-    static char *kwlist[] = {"string", "start", "end", "ignore_white_space", NULL};
+    static char *kwlist[] = {"string", "start", "end", "ignore_white_space", "mask", NULL};
+    // positions of skipped white spaces are not known, thus a span can't be found
+    static char *kwlist_spans[] = {"string", "start", "end", "mask", NULL};
 
     PyObject* object;
+    PyObject* py_mask = NULL;
+    uint64_t mask = 0;
+    bool use_mask = false;
     Py_ssize_t start, start_tmp = -1;
     Py_ssize_t end, end_tmp = -1;
     int ignore_white_space_tmp = -1;
@@ -890,8 +1693,30 @@ automaton_iter(PyObject* self, PyObject* args, PyObject* keywds) {
         return NULL;
     }
 
-    if (!F(PyArg_ParseTupleAndKeywords)(args, keywds, "O|iii", kwlist, &object, &start_tmp, &end_tmp, &ignore_white_space_tmp)) {
-        return NULL;
+    if (spans) {
+        if (!automaton_check_spans(automaton)) {
+            return NULL;
+        }
+
+        if (!F(PyArg_ParseTupleAndKeywords)(args, keywds, "O|ii$O", kwlist_spans, &object, &start_tmp, &end_tmp, &py_mask)) {
+            return NULL;
+        }
+    } else {
+        if (!F(PyArg_ParseTupleAndKeywords)(args, keywds, "O|iii$O", kwlist, &object, &start_tmp, &end_tmp, &ignore_white_space_tmp, &py_mask)) {
+            return NULL;
+        }
+    }
+
+    if (py_mask != NULL) {
+        if (!automaton_parse_mask(py_mask, &mask)) {
+            return NULL;
+        }
+
+        // without masks of keys every key matches every mask
+        use_mask = (automaton->key_masks.count > 0);
+        if (use_mask and !automaton_check_chain_masks(automaton)) {
+            return NULL;
+        }
     }
 
     if (ignore_white_space_tmp == 1) {
@@ -955,17 +1780,28 @@ automaton_iter(PyObject* self, PyObject* args, PyObject* keywds) {
         end = end_tmp;
     }
 
+    automaton_update_prefilter(automaton);
+
     return automaton_search_iter_new(
         automaton,
         object,
         (int)start,
         (int)end,
-        ignore_white_space
+        ignore_white_space,
+        spans,
+        mask,
+        use_mask
     );
 #undef automaton
 }
 
 
+static PyObject*
+automaton_iter(PyObject* self, PyObject* args, PyObject* keywds) {
+    return automaton_iter_impl(self, args, keywds, false);
+}
+
+
 static PyObject*
 automaton_iter_long(PyObject* self, PyObject* args) {
 #define automaton ((Automaton*)self)
@@ -1058,7 +1894,32 @@ get_stats_aux(TrieNode* node, AutomatonStatistics* stats, int depth) {
         get_stats_aux(trienode_get_ith_unsafe(node, i), stats, depth + 1);
 }
 
-static void
+static bool
+get_stats_minimized(Automaton* automaton) {
+
+    TrieNode** nodes;
+    size_t count;
+    size_t i;
+
+    nodes = automaton_collect_nodes(automaton, &count, false);
+    if (nodes == NULL)
+        return false;
+
+    for (i=0; i < count; i++) {
+        automaton->stats.nodes_count += 1;
+        automaton->stats.links_count += nodes[i]->n;
+        automaton->stats.total_size  += trienode_get_size(nodes[i]);
+    }
+
+    // paths are not changed by minimization
+    automaton->stats.words_count  = automaton->count;
+    automaton->stats.longest_word = automaton->longest_word;
+
+    memory_free(nodes);
+    return true;
+}
+
+static bool
 get_stats(Automaton* automaton) {
     automaton->stats.nodes_count    = 0;
     automaton->stats.words_count    = 0;
@@ -1067,10 +1928,15 @@ get_stats(Automaton* automaton) {
     automaton->stats.sizeof_node    = sizeof(TrieNode);
     automaton->stats.total_size     = 0;
 
-    if (automaton->kind != EMPTY)
+    if (automaton->minimized) {
+        if (!get_stats_minimized(automaton))
+            return false;
+    }
+    else if (automaton->kind != EMPTY)
         get_stats_aux(automaton->root, &automaton->stats, 0);
 
     automaton->stats.version        = automaton->version;
+    return true;
 }
 
 
@@ -1081,16 +1947,24 @@ automaton_get_stats(PyObject* self, PyObject* args) {
     PyObject* dict;
 
     if (automaton->stats.version != automaton->version)
-        get_stats(automaton);
+        if (!get_stats(automaton))
+            return NULL;
+
+    automaton_update_prefilter(automaton);
 
     dict = F(Py_BuildValue)(
-        "{s:k,s:k,s:k,s:k,s:i,s:k}",
+        "{s:k,s:k,s:k,s:k,s:i,s:k,s:i,s:k,s:k,s:k,s:k}",
         "nodes_count",  automaton->stats.nodes_count,
         "words_count",  automaton->stats.words_count,
         "longest_word", automaton->stats.longest_word,
         "links_count",  automaton->stats.links_count,
         "sizeof_node",  automaton->stats.sizeof_node,
-        "total_size",   automaton->stats.total_size
+        "total_size",   automaton->stats.total_size,
+        "engine",       (int)automaton->prefilter.engine,
+        "alphabet_size", (unsigned long)automaton->prefilter.alphabet_size,
+        "cache_size",   (unsigned long)(automaton->prefilter.cache != NULL ? (size_t)1 << automaton->prefilter.cache_bits : 0),
+        "cache_hits",   (unsigned long)automaton->prefilter.cache_hits,
+        "cache_misses", (unsigned long)automaton->prefilter.cache_misses
     );
     return dict;
 #undef automaton
@@ -1164,7 +2038,24 @@ automaton_dump(PyObject* self, PyObject* args) {
     if (dump.edges == NULL or dump.fail == NULL or dump.nodes == NULL)
         goto error;
 
-    trie_traverse(automaton->root, dump_aux, &dump);
+    if (automaton->minimized) {
+        TrieNode** nodes;
+        size_t count;
+        size_t i;
+
+        nodes = automaton_collect_nodes(automaton, &count, false);
+        if (nodes == NULL)
+            goto error;
+
+        for (i=0; i < count and dump_aux(nodes[i], 0, &dump); i++) {
+            // nop
+        }
+
+        memory_free(nodes);
+    }
+    else
+        trie_traverse(automaton->root, dump_aux, &dump);
+
     if (dump.error)
         goto error;
     else
@@ -1187,24 +2078,65 @@ automaton___sizeof__(PyObject* self, PyObject* args) {
 
     if (automaton->kind != EMPTY) {
         if (automaton->stats.version != automaton->version) {
-            get_stats(automaton);
+            if (!get_stats(automaton))
+                return NULL;
         }
 
         size += automaton->stats.total_size;
     }
 
+    size += valuecolumn_memory(&automaton->column);
+    size += nodemasks_memory(&automaton->key_masks) + nodemasks_memory(&automaton->chain_masks);
+    if (automaton->pool_chain_masks != NULL) {
+        size += automaton->pool_size * sizeof(uint64_t);
+    }
+
+    if (automaton->prefilter.bigrams != NULL) {
+        size += AUTOMATON_BIGRAMS_SIZE;
+    }
+    if (automaton->prefilter.shifts != NULL) {
+        size += AUTOMATON_SHIFTS_SIZE;
+    }
+    if (automaton->prefilter.root_table != NULL) {
+        size += AUTOMATON_ROOT_PAGES * sizeof(TrieNode**)
+              + automaton->prefilter.root_pages * AUTOMATON_ROOT_PAGE_SIZE * sizeof(TrieNode*);
+    }
+    if (automaton->prefilter.letter_pages != NULL) {
+        size += AUTOMATON_ROOT_PAGES * sizeof(uint16_t)
+              + automaton->prefilter.class_pages * AUTOMATON_ROOT_PAGE_SIZE * sizeof(uint16_t);
+    }
+    if (automaton->prefilter.cache != NULL) {
+        size += ((size_t)1 << automaton->prefilter.cache_bits) * sizeof(AutomatonCacheEntry);
+    }
+    if (automaton->key_offsets != NULL) {
+        size += (automaton->key_count + 1) * sizeof(size_t)
+              + automaton->key_offsets[automaton->key_count] * sizeof(TRIE_LETTER_TYPE);
+    }
+
     return Py_BuildValue("i", size);
 #undef automaton
 }
 
 
 #include "Automaton_pickle.c"
+#include "Automaton_minimize.c"
+#include "Automaton_compact.c"
+#include "Automaton_keyid.c"
+#include "Automaton_spans.c"
+#include "Automaton_masks.c"
+#include "Automaton_alphabet.c"
+#include "Automaton_roottable.c"
+#include "Automaton_cache.c"
+#include "Automaton_prefilter.c"
+#include "Automaton_many.c"
+#include "Automaton_optimize.c"
 
 
 #define method(name, kind) {#name, (PyCFunction)automaton_##name, kind, automaton_##name##_doc}
 static
 PyMethodDef automaton_methods[] = {
-    method(add_word,        METH_VARARGS),
+    method(add_word,        METH_VARARGS|METH_KEYWORDS),
+    method(add_words,       METH_VARARGS|METH_KEYWORDS),
     method(remove_word,     METH_VARARGS),
     method(pop,             METH_VARARGS),
     method(clear,           METH_NOARGS),
@@ -1212,9 +2144,16 @@ PyMethodDef automaton_methods[] = {
     method(match,           METH_VARARGS),
     method(longest_prefix,  METH_VARARGS),
     method(get,             METH_VARARGS),
-    method(make_automaton,  METH_NOARGS),
-    method(find_all,        METH_VARARGS),
+    method(make_automaton,  METH_VARARGS|METH_KEYWORDS),
+    method(minimize,        METH_NOARGS),
+    method(compact,         METH_NOARGS),
+    method(optimize,        METH_VARARGS),
+    method(key_of,          METH_VARARGS),
+    method(find_all,        METH_VARARGS|METH_KEYWORDS),
     method(iter,            METH_VARARGS|METH_KEYWORDS),
+    method(iter_spans,      METH_VARARGS|METH_KEYWORDS),
+    method(find_all_spans,  METH_VARARGS|METH_KEYWORDS),
+    method(search_many,     METH_VARARGS|METH_KEYWORDS),
 	method(iter_long,		METH_VARARGS),
     method(keys,            METH_VARARGS),
     method(values,          METH_VARARGS),
@@ -1222,8 +2161,10 @@ PyMethodDef automaton_methods[] = {
     method(get_stats,       METH_NOARGS),
     method(dump,            METH_NOARGS),
     method(__reduce__,      METH_VARARGS),
+    method(__reduce_ex__,   METH_VARARGS),
     method(__sizeof__,      METH_VARARGS),
-    method(save,            METH_VARARGS),
+    method(save,            METH_VARARGS | METH_KEYWORDS),
+    method(save_bytes,      METH_VARARGS | METH_KEYWORDS),
 
     {NULL, NULL, 0, NULL}
 };
@@ -1249,7 +2190,15 @@ PyMemberDef automaton_members[] = {
         T_INT,
         offsetof(Automaton, store),
         READONLY,
-        "Read-only attribute set when creating an Automaton().\nType of values accepted by this Automaton.\nOne of ahocorasick.STORE_ANY, STORE_INTS or STORE_LEN."
+        "Read-only attribute set when creating an Automaton().\nType of values accepted by this Automaton.\nOne of ahocorasick.STORE_ANY, STORE_INTS, STORE_LENGTH, STORE_BYTES, STORE_INT64, STORE_FLOAT, STORE_KEY_ID or STORE_MULTI_INTS."
+    },
+
+    {
+        "minimized",
+        T_BOOL,
+        offsetof(Automaton, minimized),
+        READONLY,
+        "Read-only attribute maintained automatically.\nTrue when equivalent nodes were merged by minimize(); such automaton can't be modified."
     },
 
     {NULL}
@@ -12,6 +12,9 @@
 
 #include "common.h"
 #include "trie.h"
+#include "valuetable.h"
+#include "valuecolumn.h"
+#include "nodemasks.h"
 
 typedef enum {
     EMPTY       = 0,
@@ -27,9 +30,24 @@ check_kind(const int kind);
 typedef enum {
     STORE_INTS   = 10,
     STORE_LENGTH = 20,
-    STORE_ANY    = 30
+    STORE_ANY    = 30,
+    STORE_BYTES  = 40,
+    STORE_INT64  = 50,
+    STORE_FLOAT  = 60,
+    STORE_KEY_ID = 70,
+    STORE_MULTI_INTS = 80
 } KeysStore;
 
+/* values are kept in the automaton's value column */
+#define store_is_column(store) ((store) == STORE_BYTES or (store) == STORE_INT64 or (store) == STORE_FLOAT or (store) == STORE_MULTI_INTS)
+
+/* values in the column are byte strings; payloads of STORE_MULTI_INTS
+   are kept as arrays of 64-bit integers */
+#define store_column_is_bytes(store) ((store) == STORE_BYTES or (store) == STORE_MULTI_INTS)
+
+/* output of a node is an index of its value */
+#define store_has_index(store) ((store) == STORE_ANY or store_is_column(store))
+
 
 static bool
 check_store(const int store);
@@ -45,6 +63,22 @@ static bool
 check_key_type(const int key_type);
 
 
+typedef enum {
+    ENGINE_AUTO     = 0,
+    ENGINE_TRIE     = 1,
+    ENGINE_LETTERS  = 2,
+    ENGINE_BIGRAMS  = 3,
+    ENGINE_SHIFTS   = 4
+} AutomatonEngine;
+
+
+static bool
+check_engine(const int engine);
+
+static bool
+check_cache_size(const Py_ssize_t size);
+
+
 struct Input {
     Py_ssize_t          wordlen;
     TRIE_LETTER_TYPE*   word;
@@ -65,6 +99,46 @@ typedef struct AutomatonStatistics {
 } AutomatonStatistics;
 
 
+#define AUTOMATON_BIGRAMS_SIZE (65536 / 8)
+#define AUTOMATON_SHIFTS_SIZE 65536
+
+#if TRIE_LETTER_SIZE == 4
+#   define AUTOMATON_ROOT_LETTERS 0x110000  // all code points
+#else
+#   define AUTOMATON_ROOT_LETTERS 0x10000
+#endif
+#define AUTOMATON_ROOT_PAGE_SIZE 256
+#define AUTOMATON_ROOT_PAGES (AUTOMATON_ROOT_LETTERS / AUTOMATON_ROOT_PAGE_SIZE)
+
+#define AUTOMATON_CACHE_MAX_SIZE (1 << 24)
+
+typedef struct AutomatonCacheEntry {
+    TrieNode*   node;       ///< source state, NULL if the entry is empty
+    TrieNode*   target;     ///< target state, resolved through fail links
+    TRIE_LETTER_TYPE letter;
+} AutomatonCacheEntry;
+
+typedef struct AutomatonPrefilter {
+    int         version;            ///< version of automaton for which the prefilter was built, -1 if there's none
+    AutomatonEngine engine;         ///< engine skipping positions in the root state, never ENGINE_AUTO
+    uint8_t     root_letters[32];   ///< bitmap of letters leaving the root, indexed by the lowest 8 bits of letters
+    uint8_t     root_words[32];     ///< bitmap of letters being one-letter keys
+    uint8_t*    bigrams;            ///< bitmap of the first two letters of keys, indexed by the lowest 8 bits of both letters; NULL when it would not filter enough
+    int         min_length;         ///< length of the shortest key, at most AUTOMATON_SHIFTS_MAX_LENGTH
+    uint8_t*    shifts;             ///< shift table of blocks of three letters (Wu-Manber); NULL when keys are short
+    TrieNode*** root_table;         ///< children of the root indexed by letter, AUTOMATON_ROOT_PAGES pages of AUTOMATON_ROOT_PAGE_SIZE children, missing pages are NULL; NULL when the root has few edges
+    size_t      root_pages;         ///< number of allocated pages of the root table
+    uint16_t*   letter_pages;       ///< for each AUTOMATON_ROOT_PAGE_SIZE letters the index of their page of classes; NULL when letters aren't classified
+    uint16_t*   letter_classes;     ///< pages of classes of letters; 0 is the class of letters absent in keys, the page 0 has only such letters
+    size_t      class_pages;        ///< number of pages of classes
+    size_t      alphabet_size;      ///< number of distinct letters of keys, 0 when letters aren't classified
+    AutomatonCacheEntry* cache;     ///< transitions taken by searching, 2^cache_bits entries; NULL when there's no cache
+    unsigned    cache_bits;
+    size_t      cache_hits;         ///< number of transitions found in the cache
+    size_t      cache_misses;       ///< number of transitions resolved and saved in the cache
+} AutomatonPrefilter;
+
+
 typedef struct Automaton {
     PyObject_HEAD
 
@@ -74,12 +148,51 @@ typedef struct Automaton {
     int             count;  ///< number of distinct words
     int             longest_word;   ///< length of the longest word
     TrieNode*       root;   ///< root of a trie
+    bool            minimized;  ///< equivalent nodes are merged, the trie is a read-only DAG
+    TrieNode*       pool;       ///< nodes allocated in a single block (by load or compact) or NULL
+    size_t          pool_size;  ///< number of nodes in the pool
+    Pair*           edges_pool; ///< edges of all nodes allocated in a single block (by compact) or NULL
+    size_t          edges_pool_size;    ///< number of edges in the edges pool
+    ValueTable      values;     ///< values of keys (STORE_ANY), nodes keep indices in this table
+    ValueColumn     column;     ///< values of keys (STORE_BYTES, STORE_INT64, STORE_FLOAT, STORE_MULTI_INTS), nodes keep indices in this column
+    TRIE_LETTER_TYPE* key_letters;  ///< all keys concatenated in order of their ids (STORE_KEY_ID)
+    size_t*         key_offsets;    ///< the key with id i is key_letters[key_offsets[i]:key_offsets[i + 1]]
+    size_t          key_count;      ///< number of keys in the key table
+    int             key_table_version;  ///< version of automaton for which the key table was built, -1 if there's no table
+    NodeMasks       key_masks;      ///< category masks of keys; a key without a mask matches every mask
+    NodeMasks       chain_masks;    ///< for states recognizing any key, OR of masks of all keys on the output chain; nodes out of the pool
+    uint64_t*       pool_chain_masks;   ///< as chain_masks, for nodes of the pool, indexed as the pool; NULL if there's no pool
+    int             chain_masks_version;    ///< version of automaton for which chain masks were computed, -1 if there are none
+    AutomatonEngine engine;         ///< engine requested by make_automaton; ENGINE_AUTO selects it from statistics of keys
+    size_t          cache_size;     ///< number of entries of the transition cache requested by make_automaton, 0 if there's no cache
+    AutomatonPrefilter prefilter;   ///< skips positions where no key starts
 
     int             version;    ///< current version of automaton, incremented by add_word, clean and make_automaton; used to lazy invalidate iterators
 
     AutomatonStatistics stats;  ///< statistics
 } Automaton;
 
+/* borrowed reference to the value of a node (STORE_ANY) */
+#define automaton_get_value(automaton, node) valuetable_get(&(automaton)->values, (node)->output)
+
+/* returns a new reference to the value of a node, for column
+   stores a Python object is created */
+static PyObject*
+automaton_build_value(Automaton* automaton, TrieNode* node);
+
+/* releases the value of a node, the node is not modified */
+static void
+automaton_remove_value(Automaton* automaton, TrieNode* node);
+
+/* number of integers associated with a node (STORE_MULTI_INTS) */
+#define automaton_payload_count(automaton, node) \
+    (valuecolumn_get_length(&(automaton)->column, (node)->output) / sizeof(int64_t))
+
+/* returns a new reference to the index-th integer associated with
+   a node (STORE_MULTI_INTS) */
+static PyObject*
+automaton_build_payload(Automaton* automaton, TrieNode* node, size_t index);
+
 /*------------------------------------------------------------------------*/
 
 static bool
@@ -89,6 +202,9 @@ automaton_unpickle(
     PyObject* values
 );
 
+static bool
+automaton_unpickle3(Automaton* automaton, PyObject* data, PyObject* values);
+
 static PyObject*
 automaton_create(void);
 
@@ -106,7 +222,163 @@ automaton_len(PyObject* self);
 
 /* add_word */
 static PyObject*
-automaton_add_word(PyObject* self, PyObject* args);
+automaton_add_word(PyObject* self, PyObject* args, PyObject* kwargs);
+
+/* add_words */
+static PyObject*
+automaton_add_words(PyObject* self, PyObject* args, PyObject* kwargs);
+
+/* minimize() */
+static PyObject*
+automaton_minimize(PyObject* self, PyObject* args);
+
+/* sets AttributeError when the automaton is minimized */
+static bool
+automaton_check_not_minimized(Automaton* automaton);
+
+/* returns all nodes in BFS order, each node is listed once also
+   in a minimized automaton; children of a node are visited in order
+   of their letters if sort_edges is set; the array has to be freed
+   by the caller */
+static TrieNode**
+automaton_collect_nodes(Automaton* automaton, size_t* count, bool sort_edges);
+
+/* frees all nodes of a minimized automaton */
+static void
+automaton_clear_minimized(Automaton* automaton);
+
+/* compact() */
+static PyObject*
+automaton_compact(PyObject* self, PyObject* args);
+
+/* moves nodes into the pool in given order, the root has to be the first */
+static bool
+automaton_compact_nodes(Automaton* automaton, TrieNode** nodes, size_t count);
+
+/* key_of() */
+static PyObject*
+automaton_key_of(PyObject* self, PyObject* args);
+
+/* makes sure that the key table is up to date (STORE_KEY_ID), otherwise
+   sets an exception */
+static bool
+automaton_check_key_table(Automaton* automaton);
+
+/* numerates keys in sorted order and builds the key table */
+static bool
+automaton_build_key_table(Automaton* automaton);
+
+/* returns a new key object made of letters, as keys() does */
+static PyObject*
+automaton_build_key(const TRIE_LETTER_TYPE* letters, size_t length);
+
+static void
+automaton_free_key_table(Automaton* automaton);
+
+/* iter_spans() */
+static PyObject*
+automaton_iter_spans(PyObject* self, PyObject* args, PyObject* keywds);
+
+/* find_all_spans() */
+static PyObject*
+automaton_find_all_spans(PyObject* self, PyObject* args, PyObject* kwargs);
+
+/* search_many() */
+static PyObject*
+automaton_search_many(PyObject* self, PyObject* args, PyObject* kwargs);
+
+/* optimize() */
+static PyObject*
+automaton_optimize(PyObject* self, PyObject* args);
+
+/* sets AttributeError when depths of nodes are not known */
+static bool
+automaton_check_spans(Automaton* automaton);
+
+/* builds tuple (start, end, value) for a match of key ending in node;
+   payload selects an integer of STORE_MULTI_INTS */
+static bool
+automaton_build_span(Automaton* automaton, TrieNode* node, Py_ssize_t end, size_t payload, PyObject** result);
+
+/* parses the keyword argument mask, the only one accepted;
+   use_mask is false when it's not given */
+static bool
+automaton_parse_mask_kwarg(PyObject* kwargs, uint64_t* mask, bool* use_mask);
+
+/* parses the keyword argument mask of a search and makes sure that
+   masks of states are up to date; use_mask is false when filtering
+   is not needed */
+static bool
+automaton_parse_search_mask(Automaton* automaton, PyObject* kwargs, uint64_t* mask, bool* use_mask);
+
+/* converts a category mask, it must be a non-zero 64-bit integer */
+static bool
+automaton_parse_mask(PyObject* object, uint64_t* mask);
+
+/* adds bits of mask to the mask of the key ending in node */
+static bool
+automaton_add_key_mask(Automaton* automaton, TrieNode* node, uint64_t mask);
+
+/* the mask of the key ending in node, all bits are set if it has none */
+static uint64_t
+automaton_key_mask(const Automaton* automaton, TrieNode* node);
+
+/* makes sure that masks of states are up to date, otherwise sets an exception */
+static bool
+automaton_check_chain_masks(Automaton* automaton);
+
+/* computes masks of states of an automaton having masks of keys, thus
+   searching doesn't do this; otherwise sets an exception */
+static bool
+automaton_prepare_chain_masks(Automaton* automaton);
+
+/* the entry of the array of masks of pooled nodes, NULL if node is not in the pool */
+static uint64_t*
+automaton_pool_chain_mask(Automaton* automaton, TrieNode* node);
+
+/* OR of masks of keys recognized in a state, 0 if there are none */
+static uint64_t
+automaton_chain_mask(Automaton* automaton, TrieNode* node);
+
+/* the key ending in node is removed */
+static void
+automaton_remove_key_mask(Automaton* automaton, TrieNode* node);
+
+/* drops masks of removed keys */
+static void
+automaton_prune_key_masks(Automaton* automaton);
+
+static void
+automaton_free_chain_masks(Automaton* automaton);
+
+static void
+automaton_free_masks(Automaton* automaton);
+
+/* makes sure that the prefilter, the root table, classes of letters and the transition cache are built for the current version of automaton */
+static void
+automaton_update_prefilter(Automaton* automaton);
+
+static void
+automaton_free_prefilter(Automaton* automaton);
+
+/* returns the first index not less than index where a key may start,
+   or end; valid only in the root state of an Aho-Corasick automaton */
+static Py_ssize_t PURE
+automaton_skip_root(const Automaton* automaton, const TRIE_LETTER_TYPE* word, Py_ssize_t index, const Py_ssize_t end);
+
+/* returns node linked by edge labeled with letter including paths going
+   through fail links; valid when the prefilter is up to date */
+static TrieNode*
+automaton_next(Automaton* automaton, TrieNode* node, const TRIE_LETTER_TYPE letter);
+
+/* iter() and iter_spans() */
+static PyObject*
+automaton_iter_impl(PyObject* self, PyObject* args, PyObject* keywds, bool spans);
+
+/* copies edges stored in the edges pool into separate allocations,
+   so they can be modified */
+static bool
+automaton_release_edges_pool(Automaton* automaton);
 
 /* clear() */
 static PyObject*
@@ -130,11 +402,11 @@ automaton_get(PyObject* self, PyObject* args);
 
 /* make_automaton() */
 static PyObject*
-automaton_make_automaton(PyObject* self, PyObject* args);
+automaton_make_automaton(PyObject* self, PyObject* args, PyObject* kwargs);
 
 /* find_all() */
 static PyObject*
-automaton_find_all(PyObject* self, PyObject* args);
+automaton_find_all(PyObject* self, PyObject* args, PyObject* kwargs);
 
 /* keys() */
 static PyObject*
@@ -51,6 +51,7 @@ automaton_items_iter_new(
     iter->use_wildcard = use_wildcard;
     iter->wildcard = wildcard;
     iter->matchtype = matchtype;
+    iter->key_id = -1;
     list_init(&iter->stack);
 
     Py_INCREF((PyObject*)iter->automaton);
@@ -135,6 +136,17 @@ automaton_items_iter_next(PyObject* self) {
         return NULL;
     }
 
+    if (iter->key_id >= 0) {
+        const size_t* offsets = iter->automaton->key_offsets;
+
+        if ((size_t)iter->key_id >= iter->automaton->key_count)
+            return NULL; /* Stop iteration */
+
+        iter->key_id += 1;
+        return automaton_build_key(iter->automaton->key_letters + offsets[iter->key_id - 1],
+                                   offsets[iter->key_id] - offsets[iter->key_id - 1]);
+    }
+
     while (true) {
         StackItem* top = (StackItem*)list_pop_first(&iter->stack);
         if (top == NULL)
@@ -232,13 +244,20 @@ automaton_items_iter_next(PyObject* self) {
                 case ITER_VALUES:
                     switch (iter->automaton->store) {
                         case STORE_ANY:
-                            val = iter->state->output.object;
+                            val = automaton_get_value(iter->automaton, iter->state);
                             Py_INCREF(val);
                             break;
 
+                        case STORE_BYTES:
+                        case STORE_INT64:
+                        case STORE_FLOAT:
+                        case STORE_MULTI_INTS:
+                            return automaton_build_value(iter->automaton, iter->state);
+
                         case STORE_LENGTH:
                         case STORE_INTS:
-                            return F(Py_BuildValue)("i", iter->state->output.integer);
+                        case STORE_KEY_ID:
+                            return F(Py_BuildValue)("n", (Py_ssize_t)iter->state->output);
 
                         default:
                             PyErr_SetString(PyExc_SystemError, "Incorrect 'store' attribute.");
@@ -260,22 +279,40 @@ automaton_items_iter_next(PyObject* self) {
 #else
                                 "(s#O)", /*key*/ iter->char_buffer + 1, depth,
 #endif
-                                /*val*/ iter->state->output.object
+                                /*val*/ automaton_get_value(iter->automaton, iter->state)
+                            );
+
+                        case STORE_BYTES:
+                        case STORE_INT64:
+                        case STORE_FLOAT:
+                        case STORE_MULTI_INTS:
+                            return F(Py_BuildValue)(
+#ifdef PY3K
+    #ifdef AHOCORASICK_UNICODE
+                                "(u#N)", /*key*/ iter->buffer + 1, depth,
+    #else
+                                "(y#N)", /*key*/ iter->buffer + 1, depth,
+    #endif
+#else
+                                "(s#N)", /*key*/ iter->char_buffer + 1, depth,
+#endif
+                                /*val*/ automaton_build_value(iter->automaton, iter->state)
                             );
 
                         case STORE_LENGTH:
                         case STORE_INTS:
+                        case STORE_KEY_ID:
                             return F(Py_BuildValue)(
 #ifdef PY3K
     #ifdef AHOCORASICK_UNICODE
-                                "(u#i)", /*key*/ iter->buffer + 1, depth,
+                                "(u#n)", /*key*/ iter->buffer + 1, depth,
     #else
-                                "(y#i)", /*key*/ iter->buffer + 1, depth,
+                                "(y#n)", /*key*/ iter->buffer + 1, depth,
     #endif
 #else
-                                "(s#i)", /*key*/ iter->char_buffer + 1, depth,
+                                "(s#n)", /*key*/ iter->char_buffer + 1, depth,
 #endif
-                                /*val*/ iter->state->output.integer
+                                /*val*/ (Py_ssize_t)iter->state->output
                             );
 
                         default:
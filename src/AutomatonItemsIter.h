@@ -48,6 +48,7 @@ typedef struct AutomatonItemsIter {
     bool use_wildcard;
     TRIE_LETTER_TYPE wildcard;  ///< wildcard char
     PatternMatchType matchtype; ///< how pattern have to be handled
+    Py_ssize_t  key_id;         ///< the next id when keys are read from the key table (STORE_KEY_ID), otherwise -1
 } AutomatonItemsIter;
 
 
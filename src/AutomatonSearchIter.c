@@ -68,7 +68,10 @@ automaton_search_iter_new(
     PyObject* object,
     int start,
     int end,
-    bool ignore_white_space
+    bool ignore_white_space,
+    bool spans,
+    uint64_t mask,
+    bool use_mask
 ) {
     AutomatonSearchIter* iter;
 #ifdef VARIABLE_LEN_CHARCODES
@@ -85,8 +88,12 @@ automaton_search_iter_new(
 
     iter->state = automaton->root;
     iter->output= NULL;
+    iter->payload = 0;
     iter->shift = 0;
     iter->ignore_white_space = ignore_white_space;
+    iter->spans = spans;
+    iter->mask  = mask;
+    iter->use_mask = use_mask;
 
     init_input(&iter->input);
 
@@ -158,14 +165,24 @@ static int
 automaton_build_output(PyObject* self, PyObject** result) {
     TrieNode* node;
     Py_ssize_t idx = 0;
+    size_t payload = 0;
 
-    while (iter->output && !iter->output->eow) {
+    while (iter->output && (!iter->output->eow or (iter->use_mask and (automaton_key_mask(iter->automaton, iter->output) & iter->mask) == 0))) {
         iter->output = iter->output->fail;
     }
 
     if (iter->output) {
         node = iter->output;
-        iter->output = iter->output->fail;
+        if (iter->automaton->store == STORE_MULTI_INTS) {
+            // a node is yielded once for each integer
+            payload = iter->payload++;
+            if (iter->payload == automaton_payload_count(iter->automaton, node)) {
+                iter->payload = 0;
+                iter->output  = iter->output->fail;
+            }
+        } else {
+            iter->output = iter->output->fail;
+        }
 
 #ifdef VARIABLE_LEN_CHARCODES
         idx = iter->shift;
@@ -177,14 +194,29 @@ automaton_build_output(PyObject* self, PyObject** result) {
 #else
         idx = iter->index + iter->shift;
 #endif
+        if (iter->spans) {
+            return automaton_build_span(iter->automaton, node, idx, payload, result) ? OutputValue : OutputError;
+        }
+
         switch (iter->automaton->store) {
             case STORE_LENGTH:
             case STORE_INTS:
-                *result = F(Py_BuildValue)("ii", idx, node->output.integer);
+            case STORE_KEY_ID:
+                *result = F(Py_BuildValue)("in", idx, (Py_ssize_t)node->output);
                 return OutputValue;
 
             case STORE_ANY:
-                *result = F(Py_BuildValue)("iO", idx, node->output.object);
+                *result = F(Py_BuildValue)("iO", idx, automaton_get_value(iter->automaton, node));
+                return OutputValue;
+
+            case STORE_BYTES:
+            case STORE_INT64:
+            case STORE_FLOAT:
+                *result = F(Py_BuildValue)("iN", idx, automaton_build_value(iter->automaton, node));
+                return OutputValue;
+
+            case STORE_MULTI_INTS:
+                *result = F(Py_BuildValue)("iN", idx, automaton_build_payload(iter->automaton, node, payload));
                 return OutputValue;
 
             default:
@@ -274,16 +306,29 @@ return_output:
     }
 #endif
     while (iter->index < iter->end) {
+#ifndef VARIABLE_LEN_CHARCODES
+        // skipped white spaces must not be fed to the automaton
+        if (iter->state == iter->automaton->root and not iter->ignore_white_space) {
+            iter->index = automaton_skip_root(iter->automaton, iter->input.word, iter->index, iter->end);
+            if (iter->index == iter->end) {
+                break;
+            }
+        }
+#endif
         // process single char
-        iter->state = ahocorasick_next(
+        iter->state = automaton_next(
+                        iter->automaton,
                         iter->state,
-                        iter->automaton->root,
                         iter->input.word[iter->index]
                         );
 
         ASSERT(iter->state);
 
         iter->output = iter->state;
+        if (iter->use_mask and (automaton_chain_mask(iter->automaton, iter->state) & iter->mask) == 0) {
+            iter->output = NULL;
+        }
+
         goto return_output;
 
 #ifdef VARIABLE_LEN_CHARCODES
@@ -358,6 +403,7 @@ automaton_search_iter_set(PyObject* self, PyObject* args) {
         iter->state  = iter->automaton->root;
         iter->shift  = 0;
         iter->output = NULL;
+        iter->payload = 0;
 #ifdef VARIABLE_LEN_CHARCODES
         iter->position = -1;
         iter->expected = pyaho_UCS2_Any;
@@ -31,11 +31,15 @@ typedef struct AutomatonSearchIter {
     struct Input input;     ///< input string
     TrieNode*   state;      ///< current state of automaton
     TrieNode*   output;     ///< current node, i.e. yielded value
+    size_t      payload;    ///< the next integer of output node to yield (STORE_MULTI_INTS)
 
     Py_ssize_t  index;      ///< current index in data
     Py_ssize_t  shift;      ///< shift + index => output index
     Py_ssize_t  end;        ///< end index
     bool        ignore_white_space; ///< ignore input string white spaces using iswspace() function
+    bool        spans;      ///< yield (start, end, value) rather than (end, value)
+    bool        use_mask;   ///< yield only keys matching mask
+    uint64_t    mask;       ///< category mask
 #ifdef VARIABLE_LEN_CHARCODES
     int         position;       ///< position in string
     UCS2ExpectedChar expected;
@@ -49,7 +53,10 @@ automaton_search_iter_new(
     PyObject* object,
     int start,
     int end,
-    bool ignore_white_space
+    bool ignore_white_space,
+    bool spans,
+    uint64_t mask,
+    bool use_mask
 );
 
 #endif
@@ -74,10 +74,17 @@ automaton_build_output_iter_long(PyObject* self) {
     switch (iter->automaton->store) {
         case STORE_LENGTH:
         case STORE_INTS:
-            return Py_BuildValue("ii", iter->shift + iter->last_index, iter->last_node->output.integer);
+        case STORE_KEY_ID:
+            return Py_BuildValue("in", iter->shift + iter->last_index, (Py_ssize_t)iter->last_node->output);
 
         case STORE_ANY:
-            return Py_BuildValue("iO", iter->shift + iter->last_index, iter->last_node->output.object);
+            return Py_BuildValue("iO", iter->shift + iter->last_index, automaton_get_value(iter->automaton, iter->last_node));
+
+        case STORE_BYTES:
+        case STORE_INT64:
+        case STORE_FLOAT:
+        case STORE_MULTI_INTS:
+            return Py_BuildValue("iN", iter->shift + iter->last_index, automaton_build_value(iter->automaton, iter->last_node));
 
         default:
             PyErr_SetString(PyExc_ValueError, "inconsistent internal state!");
@@ -0,0 +1,508 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    AutomatonSet implementation
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+#include "AutomatonSet.h"
+
+static PyTypeObject automaton_set_type;
+
+
+static PyObject*
+automaton_set_new(PyTypeObject* self, PyObject* args, PyObject* kwargs) {
+
+    AutomatonSet* set;
+    PyObject* iterable;
+    PyObject* automatons;
+    Automaton* automaton;
+    Py_ssize_t count;
+    Py_ssize_t i;
+
+    if (not F(PyArg_ParseTuple)(args, "O", &iterable)) {
+        return NULL;
+    }
+
+    automatons = F(PySequence_Tuple)(iterable);
+    if (automatons == NULL) {
+        return NULL;
+    }
+
+    count = PyTuple_GET_SIZE(automatons);
+    for (i=0; i < count; i++) {
+        automaton = (Automaton*)PyTuple_GET_ITEM(automatons, i);
+        if (not PyObject_TypeCheck(automaton, &automaton_type)) {
+            PyErr_SetString(PyExc_TypeError, "AutomatonSet accepts only Automaton objects.");
+            goto error;
+        }
+
+        if (automaton->key_type != ((Automaton*)PyTuple_GET_ITEM(automatons, 0))->key_type) {
+            PyErr_SetString(PyExc_ValueError, "All automatons must have the same key type.");
+            goto error;
+        }
+    }
+
+    set = (AutomatonSet*)F(PyObject_New)(AutomatonSet, &automaton_set_type);
+    if (UNLIKELY(set == NULL)) {
+        goto error;
+    }
+
+    set->automatons    = automatons;
+    set->key_type      = (count > 0) ? ((Automaton*)PyTuple_GET_ITEM(automatons, 0))->key_type : KEY_STRING;
+    set->merged        = NULL;
+    set->entries       = NULL;
+    set->entries_count = 0;
+    set->version       = 0;
+    set->versions      = (int*)memory_alloc((count > 0 ? count : 1) * sizeof(int));
+    if (UNLIKELY(set->versions == NULL)) {
+        Py_DECREF(set);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    return (PyObject*)set;
+
+error:
+    Py_DECREF(automatons);
+    return NULL;
+}
+
+
+static void
+automaton_set_release(AutomatonSet* set) {
+
+    Py_CLEAR(set->merged);
+    memory_safefree(set->entries);
+    set->entries = NULL;
+    set->entries_count = 0;
+}
+
+
+#define set ((AutomatonSet*)self)
+
+static void
+automaton_set_del(PyObject* self) {
+    automaton_set_release(set);
+    memory_safefree(set->versions);
+    Py_DECREF(set->automatons);
+    PyObject_Del(self);
+}
+
+#undef set
+
+
+static bool
+automaton_set_add_keys(AutomatonSet* set, Py_ssize_t index, size_t capacity) {
+
+    // keys are enumerated by depth-first traversal; also works for
+    // a minimized automaton, where a node is reached once per key
+    Automaton* automaton = (Automaton*)PyTuple_GET_ITEM(set->automatons, index);
+    TRIE_LETTER_TYPE* letters = NULL;
+    TrieNode** nodes = NULL;
+    unsigned* edges = NULL;
+    TrieNode* node;
+    TrieNode* child;
+    TrieNode* merged;
+    AutomatonSetEntry* entry;
+    size_t size;
+    size_t depth;
+    bool new_word;
+
+    size    = (size_t)automaton->longest_word + 1;
+    letters = (TRIE_LETTER_TYPE*)memory_alloc(size * sizeof(TRIE_LETTER_TYPE));
+    nodes   = (TrieNode**)memory_alloc(size * sizeof(TrieNode*));
+    edges   = (unsigned*)memory_alloc(size * sizeof(unsigned));
+    if (UNLIKELY(letters == NULL or nodes == NULL or edges == NULL)) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    nodes[0] = automaton->root;
+    edges[0] = 0;
+    depth = 0;
+    while (true) {
+        node = nodes[depth];
+        if (edges[depth] == node->n) {
+            if (depth == 0) {
+                break;
+            }
+
+            depth -= 1;
+            continue;
+        }
+
+        child = node->next[edges[depth]].child;
+        letters[depth] = node->next[edges[depth]].letter;
+        edges[depth] += 1;
+
+        if (UNLIKELY(depth + 1 >= size)) {
+            PyErr_SetString(PyExc_ValueError, "inconsistent internal state!");
+            goto error;
+        }
+
+        if (child->eow) {
+            if (UNLIKELY(set->entries_count == capacity)) {
+                PyErr_SetString(PyExc_ValueError, "inconsistent internal state!");
+                goto error;
+            }
+
+            merged = trie_add_word(set->merged, letters, depth + 1, &new_word);
+            if (UNLIKELY(merged == NULL)) {
+                PyErr_NoMemory();
+                goto error;
+            }
+
+            // automatons are added from the last one, thus an entry
+            // is put in front of entries of the next automatons
+            entry = &set->entries[set->entries_count];
+            entry->automaton = index;
+            entry->node      = child;
+            entry->next      = new_word ? AUTOMATON_SET_NO_ENTRY : merged->output;
+            merged->output   = set->entries_count;
+            set->entries_count += 1;
+
+            if ((int)(depth + 1) > set->merged->longest_word) {
+                set->merged->longest_word = (int)(depth + 1);
+            }
+        }
+
+        depth += 1;
+        nodes[depth] = child;
+        edges[depth] = 0;
+    }
+
+    memory_free(edges);
+    memory_free(nodes);
+    memory_free(letters);
+    return true;
+
+error:
+    memory_safefree(edges);
+    memory_safefree(nodes);
+    memory_safefree(letters);
+    return false;
+}
+
+
+static bool
+automaton_set_build(AutomatonSet* set) {
+
+    Automaton* automaton;
+    PyObject* result;
+    Py_ssize_t count;
+    Py_ssize_t i;
+    size_t capacity;
+
+    automaton_set_release(set);
+    set->version += 1;
+
+    count = PyTuple_GET_SIZE(set->automatons);
+    capacity = 0;
+    for (i=0; i < count; i++) {
+        automaton = (Automaton*)PyTuple_GET_ITEM(set->automatons, i);
+        if (automaton->kind != EMPTY) {
+            capacity += automaton->count;
+        }
+    }
+
+    set->merged = (Automaton*)automaton_create();
+    if (UNLIKELY(set->merged == NULL)) {
+        return false;
+    }
+
+    // nodes keep indices of entries
+    set->merged->store    = STORE_INTS;
+    set->merged->key_type = set->key_type;
+
+    if (capacity > 0) {
+        set->entries = (AutomatonSetEntry*)memory_alloc(capacity * sizeof(AutomatonSetEntry));
+        if (UNLIKELY(set->entries == NULL)) {
+            PyErr_NoMemory();
+            goto error;
+        }
+    }
+
+    for (i=count; i > 0; i--) {
+        automaton = (Automaton*)PyTuple_GET_ITEM(set->automatons, i - 1);
+        if (automaton->kind != EMPTY and not automaton_set_add_keys(set, i - 1, capacity)) {
+            goto error;
+        }
+    }
+
+    result = automaton_make_automaton((PyObject*)set->merged, NULL, NULL);
+    if (UNLIKELY(result == NULL)) {
+        goto error;
+    }
+
+    Py_DECREF(result);
+    automaton_update_prefilter(set->merged);
+
+    for (i=0; i < count; i++) {
+        set->versions[i] = ((Automaton*)PyTuple_GET_ITEM(set->automatons, i))->version;
+    }
+
+    return true;
+
+error:
+    automaton_set_release(set);
+    return false;
+}
+
+
+static bool PURE
+automaton_set_changed(AutomatonSet* set) {
+
+    Py_ssize_t i;
+
+    for (i=0; i < PyTuple_GET_SIZE(set->automatons); i++) {
+        if (set->versions[i] != ((Automaton*)PyTuple_GET_ITEM(set->automatons, i))->version) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+static bool
+automaton_set_update(AutomatonSet* set) {
+
+    if (set->merged != NULL and not automaton_set_changed(set)) {
+        return true;
+    }
+
+    return automaton_set_build(set);
+}
+
+
+static size_t
+automaton_set_payload_count(AutomatonSet* set, AutomatonSetEntry* entry) {
+
+    Automaton* automaton = (Automaton*)PyTuple_GET_ITEM(set->automatons, entry->automaton);
+
+    if (automaton->store == STORE_MULTI_INTS) {
+        return automaton_payload_count(automaton, entry->node);
+    }
+
+    return 1;
+}
+
+
+static PyObject*
+automaton_set_build_value(AutomatonSet* set, AutomatonSetEntry* entry, size_t payload) {
+
+    Automaton* automaton = (Automaton*)PyTuple_GET_ITEM(set->automatons, entry->automaton);
+    PyObject* value;
+
+    switch (automaton->store) {
+        case STORE_LENGTH:
+        case STORE_INTS:
+        case STORE_KEY_ID:
+            return F(PyLong_FromSsize_t)((Py_ssize_t)entry->node->output);
+
+        case STORE_ANY:
+            value = automaton_get_value(automaton, entry->node);
+            Py_INCREF(value);
+            return value;
+
+        case STORE_MULTI_INTS:
+            return automaton_build_payload(automaton, entry->node, payload);
+
+        default:
+            return automaton_build_value(automaton, entry->node);
+    }
+}
+
+
+#define set ((AutomatonSet*)self)
+
+static PyObject*
+automaton_set_iter(PyObject* self, PyObject* args) {
+
+    if (not automaton_set_update(set)) {
+        return NULL;
+    }
+
+    return automaton_set_search_iter_new(set, args);
+}
+
+
+static PyObject*
+automaton_set_find_all(PyObject* self, PyObject* args) {
+
+    struct Input input;
+    Py_ssize_t start;
+    Py_ssize_t end;
+    PyObject* callback;
+    PyObject* callback_ret;
+    PyObject* value;
+    AutomatonSetEntry* entry;
+    TrieNode* root;
+    TrieNode* state;
+    TrieNode* tmp;
+    size_t index;
+    size_t count;
+    size_t k;
+    Py_ssize_t i;
+    int version;
+    unsigned long changes;
+
+    if (not automaton_set_update(set)) {
+        return NULL;
+    }
+
+    // arg 1
+    init_input(&input);
+    if (not prepare_input_from_tuple((PyObject*)set->merged, args, 0, &input)) {
+        return NULL;
+    }
+
+    // arg 2
+    callback = F(PyTuple_GetItem)(args, 1);
+    if (callback == NULL) {
+        destroy_input(&input);
+        return NULL;
+    }
+    else
+    if (not F(PyCallable_Check)(callback)) {
+        PyErr_SetString(PyExc_TypeError, "The callback argument must be a callable such as a function.");
+        destroy_input(&input);
+        return NULL;
+    }
+
+    // parse start/end
+    if (pymod_parse_start_end(args, 2, 3, 0, input.wordlen, &start, &end)) {
+        destroy_input(&input);
+        return NULL;
+    }
+
+    if (set->merged->kind != AHOCORASICK) {
+        destroy_input(&input);
+        Py_RETURN_NONE;
+    }
+
+    root    = set->merged->root;
+    state   = root;
+    version = set->version;
+    changes = automaton_changes;
+    for (i=start; i < end; i++) {
+        if (state == root) {
+            i = automaton_skip_root(set->merged, input.word, i, end);
+            if (i == end) {
+                break;
+            }
+        }
+
+        state = tmp = automaton_next(set->merged, state, input.word[i]);
+
+        // return output of all automatons
+        while (tmp) {
+            if (tmp->eow) {
+                for (index = tmp->output; index != AUTOMATON_SET_NO_ENTRY; index = entry->next) {
+                    entry = &set->entries[index];
+                    count = automaton_set_payload_count(set, entry);
+                    for (k=0; k < count; k++) {
+                        value = automaton_set_build_value(set, entry, k);
+                        if (value == NULL) {
+                            destroy_input(&input);
+                            return NULL;
+                        }
+
+                        callback_ret = F(PyObject_CallFunction)(callback, "nnN", entry->automaton, i, value);
+                        if (callback_ret == NULL) {
+                            destroy_input(&input);
+                            return NULL;
+                        } else
+                            Py_DECREF(callback_ret);
+
+                        // values are read from the automatons, the merged one may be rebuilt;
+                        // automatons are checked only when any automaton has changed
+                        if (UNLIKELY(set->version != version or (automaton_changes != changes and automaton_set_changed(set)))) {
+                            PyErr_SetString(PyExc_ValueError, "underlaying automaton has changed by the callback, search can't continue");
+                            destroy_input(&input);
+                            return NULL;
+                        }
+                    }
+                }
+            }
+
+            tmp = tmp->fail;
+        }
+    }
+
+    destroy_input(&input);
+    Py_RETURN_NONE;
+}
+
+#undef set
+
+
+#define method(name, kind) {#name, (PyCFunction)automaton_set_##name, kind, automaton_set_##name##_doc}
+static
+PyMethodDef automaton_set_methods[] = {
+    method(iter,        METH_VARARGS),
+    method(find_all,    METH_VARARGS),
+
+    {NULL, NULL, 0, NULL}
+};
+#undef method
+
+
+static
+PyMemberDef automaton_set_members[] = {
+    {
+        "automatons",
+        T_OBJECT,
+        offsetof(AutomatonSet, automatons),
+        READONLY,
+        "Read-only attribute set when creating an AutomatonSet().\nTuple of searched automatons."
+    },
+
+    {NULL}
+};
+
+
+static PyTypeObject automaton_set_type = {
+    PY_OBJECT_HEAD_INIT
+    "ahocorasick.AutomatonSet",                 /* tp_name */
+    sizeof(AutomatonSet),                       /* tp_size */
+    0,                                          /* tp_itemsize? */
+    (destructor)automaton_set_del,              /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    0,                                          /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    PyObject_GenericGetAttr,                    /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    automaton_set_constructor_doc,              /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    0,                                          /* tp_iter */
+    0,                                          /* tp_iternext */
+    automaton_set_methods,                      /* tp_methods */
+    automaton_set_members,                      /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    automaton_set_new,                          /* tp_new */
+};
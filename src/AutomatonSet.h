@@ -0,0 +1,59 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    AutomatonSet const, struct & methods declarations.
+    This class searches several automatons in one pass over
+    the input: keys of all automatons are merged into a single
+    internal automaton, each key refers to automatons containing it.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#ifndef ahocorasick_AutomatonSet_h_included
+#define ahocorasick_AutomatonSet_h_included
+
+#include "common.h"
+#include "Automaton.h"
+
+#define AUTOMATON_SET_NO_ENTRY ((size_t)-1)
+
+typedef struct AutomatonSetEntry {
+    Py_ssize_t  automaton;  ///< index of an automaton containing the key
+    TrieNode*   node;       ///< node of the key in that automaton
+    size_t      next;       ///< the next entry of the same key or AUTOMATON_SET_NO_ENTRY
+} AutomatonSetEntry;
+
+
+typedef struct AutomatonSet {
+    PyObject_HEAD
+
+    PyObject*   automatons; ///< tuple of automatons
+    KeyType     key_type;   ///< key type shared by all automatons
+    int*        versions;   ///< versions of automatons the merged automaton was built for
+    Automaton*  merged;     ///< keys of all automatons or NULL if not built yet; the output of a node is its first entry
+    AutomatonSetEntry* entries; ///< entries of keys, in order of automatons for each key
+    size_t      entries_count;
+    int         version;    ///< incremented each time the merged automaton is rebuilt; used to lazy invalidate iterators
+} AutomatonSet;
+
+
+/* makes sure that the merged automaton reflects the current state of
+   all automatons, otherwise rebuilds it */
+static bool
+automaton_set_update(AutomatonSet* set);
+
+/* returns true if any automaton has changed since the merged automaton was built */
+static bool PURE
+automaton_set_changed(AutomatonSet* set);
+
+/* returns a new reference to the value of entry, as iter() of its automaton
+   reports it; payload selects an integer of STORE_MULTI_INTS */
+static PyObject*
+automaton_set_build_value(AutomatonSet* set, AutomatonSetEntry* entry, size_t payload);
+
+/* number of values reported for entry, more than one for STORE_MULTI_INTS */
+static size_t
+automaton_set_payload_count(AutomatonSet* set, AutomatonSetEntry* entry);
+
+#endif
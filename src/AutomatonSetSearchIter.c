@@ -0,0 +1,196 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    AutomatonSetSearchIter implementation
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+#include "AutomatonSetSearchIter.h"
+
+static PyTypeObject automaton_set_search_iter_type;
+
+
+static PyObject*
+automaton_set_search_iter_new(AutomatonSet* set, PyObject* args) {
+
+    AutomatonSetSearchIter* iter;
+    Py_ssize_t start;
+    Py_ssize_t end;
+
+    iter = (AutomatonSetSearchIter*)F(PyObject_New)(AutomatonSetSearchIter, &automaton_set_search_iter_type);
+    if (iter == NULL)
+        return NULL;
+
+    iter->set     = set;
+    iter->version = set->version;
+    iter->changes = automaton_changes;
+    iter->state   = set->merged->root;
+    iter->output  = NULL;
+    iter->entry   = AUTOMATON_SET_NO_ENTRY;
+    iter->payload = 0;
+
+    init_input(&iter->input);
+
+    Py_INCREF(iter->set);
+
+    if (!prepare_input_from_tuple((PyObject*)set->merged, args, 0, &iter->input)) {
+        goto error;
+    }
+
+    if (pymod_parse_start_end(args, 1, 2, 0, iter->input.wordlen, &start, &end)) {
+        goto error;
+    }
+
+    // -1 because the first instruction in next() increments index
+    iter->index = start - 1;
+    iter->end   = end;
+    if (set->merged->kind != AHOCORASICK) {
+        // there are no keys
+        iter->end = start;
+    }
+
+    return (PyObject*)iter;
+
+error:
+    Py_DECREF(iter);
+    return NULL;
+}
+
+#define iter ((AutomatonSetSearchIter*)self)
+
+static void
+automaton_set_search_iter_del(PyObject* self) {
+    Py_DECREF(iter->set);
+    destroy_input(&iter->input);
+    PyObject_Del(self);
+}
+
+
+static PyObject*
+automaton_set_search_iter_iter(PyObject* self) {
+    Py_INCREF(self);
+    return self;
+}
+
+
+static PyObject*
+automaton_set_search_iter_next(PyObject* self) {
+
+    AutomatonSetEntry* entry;
+    PyObject* value;
+    TrieNode* node;
+    size_t payload;
+
+    // automatons are checked only when any automaton has changed since the last call
+    if (iter->changes != automaton_changes) {
+        if (automaton_set_changed(iter->set)) {
+            goto changed;
+        }
+
+        iter->changes = automaton_changes;
+    }
+
+    if (iter->version != iter->set->version) {
+        goto changed;
+    }
+
+    while (true) {
+        // 1. entries of a key, i.e. matches in subsequent automatons
+        if (iter->entry != AUTOMATON_SET_NO_ENTRY) {
+            entry   = &iter->set->entries[iter->entry];
+            payload = iter->payload++;
+            if (iter->payload >= automaton_set_payload_count(iter->set, entry)) {
+                iter->payload = 0;
+                iter->entry   = entry->next;
+            }
+
+            value = automaton_set_build_value(iter->set, entry, payload);
+            if (value == NULL) {
+                return NULL;
+            }
+
+            return F(Py_BuildValue)("nnN", entry->automaton, iter->index, value);
+        }
+
+        // 2. keys on the output chain
+        if (iter->output != NULL) {
+            node = iter->output;
+            iter->output = node->fail;
+            if (node->eow) {
+                iter->entry = node->output;
+            }
+
+            continue;
+        }
+
+        // 3. process single char
+        iter->index += 1;
+        if (iter->state == iter->set->merged->root) {
+            iter->index = automaton_skip_root(iter->set->merged, iter->input.word, iter->index, iter->end);
+        }
+
+        if (iter->index >= iter->end) {
+            return NULL;    // StopIteration
+        }
+
+        iter->state = automaton_next(
+                        iter->set->merged,
+                        iter->state,
+                        iter->input.word[iter->index]
+                        );
+
+        ASSERT(iter->state);
+        iter->output = iter->state;
+    }
+
+changed:
+    PyErr_SetString(PyExc_ValueError, "underlaying automaton has changed, iterator is not valid anymore");
+    return NULL;
+}
+
+#undef iter
+
+
+static PyTypeObject automaton_set_search_iter_type = {
+    PY_OBJECT_HEAD_INIT
+    "ahocorasick.AutomatonSetSearchIter",       /* tp_name */
+    sizeof(AutomatonSetSearchIter),             /* tp_size */
+    0,                                          /* tp_itemsize? */
+    (destructor)automaton_set_search_iter_del,  /* tp_dealloc */
+    0,                                          /* tp_print */
+    0,                                          /* tp_getattr */
+    0,                                          /* tp_setattr */
+    0,                                          /* tp_reserved */
+    0,                                          /* tp_repr */
+    0,                                          /* tp_as_number */
+    0,                                          /* tp_as_sequence */
+    0,                                          /* tp_as_mapping */
+    0,                                          /* tp_hash */
+    0,                                          /* tp_call */
+    0,                                          /* tp_str */
+    PyObject_GenericGetAttr,                    /* tp_getattro */
+    0,                                          /* tp_setattro */
+    0,                                          /* tp_as_buffer */
+    Py_TPFLAGS_DEFAULT,                         /* tp_flags */
+    automaton_set_search_iter_doc,              /* tp_doc */
+    0,                                          /* tp_traverse */
+    0,                                          /* tp_clear */
+    0,                                          /* tp_richcompare */
+    0,                                          /* tp_weaklistoffset */
+    automaton_set_search_iter_iter,             /* tp_iter */
+    automaton_set_search_iter_next,             /* tp_iternext */
+    0,                                          /* tp_methods */
+    0,                                          /* tp_members */
+    0,                                          /* tp_getset */
+    0,                                          /* tp_base */
+    0,                                          /* tp_dict */
+    0,                                          /* tp_descr_get */
+    0,                                          /* tp_descr_set */
+    0,                                          /* tp_dictoffset */
+    0,                                          /* tp_init */
+    0,                                          /* tp_alloc */
+    0,                                          /* tp_new */
+};
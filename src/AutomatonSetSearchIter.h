@@ -0,0 +1,39 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    AutomatonSetSearchIter const, struct & methods declarations.
+    This class implements iterator walk over the merged automaton
+    of AutomatonSet. Object of this class is returned by 'iter'
+    method of AutomatonSet class.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#ifndef ahocorasick_AutomatonSetSearchIter_h_included
+#define ahocorasick_AutomatonSetSearchIter_h_included
+
+#include "common.h"
+#include "AutomatonSet.h"
+
+typedef struct AutomatonSetSearchIter {
+    PyObject_HEAD
+
+    AutomatonSet* set;
+    int         version;    ///< version of the set
+    unsigned long changes;  ///< value of automaton_changes when versions of automatons were last checked
+    struct Input input;     ///< input string
+    TrieNode*   state;      ///< current state of the merged automaton
+    TrieNode*   output;     ///< current node of the output chain
+    size_t      entry;      ///< the next entry of output node to yield or AUTOMATON_SET_NO_ENTRY
+    size_t      payload;    ///< the next integer of entry to yield (STORE_MULTI_INTS)
+
+    Py_ssize_t  index;      ///< current index in data
+    Py_ssize_t  end;        ///< end index
+} AutomatonSetSearchIter;
+
+
+static PyObject*
+automaton_set_search_iter_new(AutomatonSet* set, PyObject* args);
+
+#endif
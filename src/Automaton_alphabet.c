@@ -0,0 +1,155 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Alphabet --- classes of letters used by keys.
+
+    A dictionary usually uses a few hundred distinct letters, while
+    a text of the unicode build may contain any of 0x110000 code
+    points. Each letter of keys gets a small class id, all letters
+    absent in keys share the class 0. Classes are kept in a two-stage
+    table: the index of a page for the higher bits of a letter and
+    the class in the page for the lowest 8 bits; ranges without any
+    letter of keys share the page 0, thus a lookup never meets a
+    missing page.
+
+    A letter of class 0 leads from every state to the root; searching
+    doesn't walk the chain of fail links for such letters.
+
+    Classes are built together with the prefilter, for the current
+    version of the automaton.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+/* class ids are 16-bit, the class 0 is reserved */
+#define AUTOMATON_ALPHABET_MAX_SIZE 0xffff
+
+#define automaton_class_page(letter)    ((letter) / AUTOMATON_ROOT_PAGE_SIZE)
+#define automaton_class_index(letter)   ((letter) % AUTOMATON_ROOT_PAGE_SIZE)
+
+
+static void
+automaton_free_alphabet(AutomatonPrefilter* prefilter) {
+
+    memory_safefree(prefilter->letter_pages);
+    memory_safefree(prefilter->letter_classes);
+    prefilter->letter_pages   = NULL;
+    prefilter->letter_classes = NULL;
+    prefilter->class_pages    = 0;
+    prefilter->alphabet_size  = 0;
+}
+
+
+static bool
+automaton_alphabet_add_letters(AutomatonPrefilter* prefilter, TrieNode* node) {
+
+    TRIE_LETTER_TYPE letter;
+    uint16_t* classes;
+    uint16_t* id;
+    unsigned i;
+
+    for (i=0; i < node->n; i++) {
+        letter = trieletter_get_ith_unsafe(node, i);
+#if TRIE_LETTER_SIZE == 4
+        if (letter >= AUTOMATON_ROOT_LETTERS) {
+            // integer keys (KEY_SEQUENCE) may be outside the table
+            return false;
+        }
+#endif
+
+        if (prefilter->letter_pages[automaton_class_page(letter)] == 0) {
+            classes = (uint16_t*)memory_realloc(prefilter->letter_classes,
+                        (prefilter->class_pages + 1) * AUTOMATON_ROOT_PAGE_SIZE * sizeof(uint16_t));
+            if (UNLIKELY(classes == NULL)) {
+                return false;
+            }
+
+            memset(classes + prefilter->class_pages * AUTOMATON_ROOT_PAGE_SIZE, 0, AUTOMATON_ROOT_PAGE_SIZE * sizeof(uint16_t));
+            prefilter->letter_classes = classes;
+            prefilter->letter_pages[automaton_class_page(letter)] = (uint16_t)prefilter->class_pages;
+            prefilter->class_pages += 1;
+        }
+
+        id = &prefilter->letter_classes[prefilter->letter_pages[automaton_class_page(letter)] * AUTOMATON_ROOT_PAGE_SIZE
+                                         + automaton_class_index(letter)];
+        if (*id == 0) {
+            if (prefilter->alphabet_size == AUTOMATON_ALPHABET_MAX_SIZE) {
+                return false;
+            }
+
+            prefilter->alphabet_size += 1;
+            *id = (uint16_t)prefilter->alphabet_size;
+        }
+    }
+
+    return true;
+}
+
+
+static bool
+automaton_build_alphabet(Automaton* automaton) {
+
+    AutomatonPrefilter* prefilter = &automaton->prefilter;
+    TrieNode** nodes;
+    size_t count;
+    size_t i;
+    bool ok;
+
+    ASSERT(prefilter->letter_pages == NULL);
+
+    // nodes shared by a minimized automaton are visited once
+    nodes = automaton_collect_nodes(automaton, &count, false);
+    if (UNLIKELY(nodes == NULL)) {
+        // the alphabet is optional
+        PyErr_Clear();
+        return false;
+    }
+
+    prefilter->letter_pages   = (uint16_t*)memory_alloc(AUTOMATON_ROOT_PAGES * sizeof(uint16_t));
+    prefilter->letter_classes = (uint16_t*)memory_alloc(AUTOMATON_ROOT_PAGE_SIZE * sizeof(uint16_t));
+    if (UNLIKELY(prefilter->letter_pages == NULL or prefilter->letter_classes == NULL)) {
+        automaton_free_alphabet(prefilter);
+        memory_free(nodes);
+        return false;
+    }
+
+    // the page 0 is shared by letters absent in keys
+    memset(prefilter->letter_pages, 0, AUTOMATON_ROOT_PAGES * sizeof(uint16_t));
+    memset(prefilter->letter_classes, 0, AUTOMATON_ROOT_PAGE_SIZE * sizeof(uint16_t));
+    prefilter->class_pages = 1;
+
+    ok = true;
+    for (i=0; i < count and ok; i++) {
+        ok = automaton_alphabet_add_letters(prefilter, nodes[i]);
+    }
+
+    memory_free(nodes);
+    if (not ok) {
+        automaton_free_alphabet(prefilter);
+        return false;
+    }
+
+    return true;
+}
+
+
+static unsigned PURE
+automaton_letter_class(const AutomatonPrefilter* prefilter, const TRIE_LETTER_TYPE letter) {
+
+    ASSERT(prefilter->letter_pages != NULL);
+
+#if TRIE_LETTER_SIZE == 4
+    if (UNLIKELY(letter >= AUTOMATON_ROOT_LETTERS)) {
+        return 0;
+    }
+#endif
+
+    return prefilter->letter_classes[prefilter->letter_pages[automaton_class_page(letter)] * AUTOMATON_ROOT_PAGE_SIZE
+                                     + automaton_class_index(letter)];
+}
+
+#undef AUTOMATON_ALPHABET_MAX_SIZE
+#undef automaton_class_page
+#undef automaton_class_index
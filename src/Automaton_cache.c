@@ -0,0 +1,106 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Transition cache --- a lazy DFA of bounded size.
+
+    A full DFA, a transition for each state and each letter, is too
+    large for the unicode build; a text, however, usually takes
+    a small set of transitions again and again. When make_automaton
+    is given a cache size, transitions are saved in a hash table of
+    fixed size indexed by the state and the letter. An entry keeps the
+    target state already resolved through fail links, thus a repeated
+    transition neither scans edges nor walks the chain of fail links.
+    A colliding transition replaces the entry.
+
+    Searching holds the GIL, thus concurrent searches don't see an
+    entry being written; an entry is valid only when both the state
+    and the letter match.
+
+    The cache is built together with the prefilter, for the current
+    version of the automaton; counters of hits and misses are reset
+    then.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+static void
+automaton_free_cache(AutomatonPrefilter* prefilter) {
+
+    memory_safefree(prefilter->cache);
+    prefilter->cache        = NULL;
+    prefilter->cache_bits   = 0;
+    prefilter->cache_hits   = 0;
+    prefilter->cache_misses = 0;
+}
+
+
+static bool
+automaton_build_cache(Automaton* automaton) {
+
+    AutomatonPrefilter* prefilter = &automaton->prefilter;
+    size_t size;
+
+    ASSERT(prefilter->cache == NULL);
+
+    if (automaton->cache_size == 0) {
+        return true;
+    }
+
+    // the size is rounded up to a power of two
+    prefilter->cache_bits = 1;
+    while (((size_t)1 << prefilter->cache_bits) < automaton->cache_size) {
+        prefilter->cache_bits += 1;
+    }
+
+    size = (size_t)1 << prefilter->cache_bits;
+    prefilter->cache = (AutomatonCacheEntry*)memory_alloc(size * sizeof(AutomatonCacheEntry));
+    if (UNLIKELY(prefilter->cache == NULL)) {
+        prefilter->cache_bits = 0;
+        return false;
+    }
+
+    // no state is NULL, thus empty entries never match
+    memset(prefilter->cache, 0, size * sizeof(AutomatonCacheEntry));
+
+    return true;
+}
+
+
+static size_t PURE
+automaton_cache_index(const AutomatonPrefilter* prefilter, const TrieNode* node, const TRIE_LETTER_TYPE letter) {
+
+    // nodes are at least 8-byte aligned, Fibonacci hashing mixes the rest
+    const uint64_t key = ((uint64_t)(Py_uintptr_t)node >> 3) ^ ((uint64_t)letter << 32);
+
+    return (size_t)((key * 0x9e3779b97f4a7c15ull) >> (64 - prefilter->cache_bits));
+}
+
+
+static TrieNode*
+automaton_next(Automaton* automaton, TrieNode* node, const TRIE_LETTER_TYPE letter) {
+
+    AutomatonPrefilter* prefilter = &automaton->prefilter;
+    AutomatonCacheEntry* entry;
+    TrieNode* target;
+
+    if (prefilter->cache == NULL) {
+        return automaton_resolve_next(automaton, node, letter);
+    }
+
+    entry = &prefilter->cache[automaton_cache_index(prefilter, node, letter)];
+    if (entry->node == node and entry->letter == letter) {
+        prefilter->cache_hits += 1;
+        return entry->target;
+    }
+
+    prefilter->cache_misses += 1;
+    target = automaton_resolve_next(automaton, node, letter);
+
+    entry->node   = node;
+    entry->letter = letter;
+    entry->target = target;
+
+    return target;
+}
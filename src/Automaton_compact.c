@@ -0,0 +1,217 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Automaton compaction --- implementation of compact() method.
+
+    All nodes are moved into a single array (automaton's pool) in BFS
+    order and all edges into another one (edges pool). Searching only
+    reads both arrays, thus processes forked after compaction keep
+    sharing their pages.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+static bool
+automaton_release_edges_pool(Automaton* automaton) {
+
+    // Edges of a node can't be resized in place, thus before the first
+    // modification all of them are copied into separate allocations.
+    TrieNode** nodes;
+    Pair** copies;
+    size_t count;
+    size_t i;
+
+    if (automaton->edges_pool == NULL) {
+        return true;
+    }
+
+    nodes = automaton_collect_nodes(automaton, &count, false);
+    if (UNLIKELY(nodes == NULL)) {
+        return false;
+    }
+
+    copies = (Pair**)memory_alloc(count * sizeof(Pair*));
+    if (UNLIKELY(copies == NULL)) {
+        goto no_mem;
+    }
+
+    memset(copies, 0, count * sizeof(Pair*));
+    for (i=0; i < count; i++) {
+        if (nodes[i]->n == 0) {
+            continue;
+        }
+
+        copies[i] = (Pair*)memory_alloc(nodes[i]->n * sizeof(Pair));
+        if (UNLIKELY(copies[i] == NULL)) {
+            goto no_mem;
+        }
+
+        memcpy(copies[i], nodes[i]->next, nodes[i]->n * sizeof(Pair));
+    }
+
+    for (i=0; i < count; i++) {
+        if (nodes[i]->n > 0) {
+            nodes[i]->next = copies[i];
+        }
+    }
+
+    memory_free(copies);
+    memory_free(nodes);
+    memory_free(automaton->edges_pool);
+    automaton->edges_pool = NULL;
+    automaton->edges_pool_size = 0;
+
+    return true;
+
+no_mem:
+    if (copies != NULL) {
+        for (i=0; i < count; i++) {
+            memory_safefree(copies[i]);
+        }
+
+        memory_free(copies);
+    }
+
+    memory_free(nodes);
+    PyErr_NoMemory();
+    return false;
+}
+
+
+static bool
+automaton_compact_nodes(Automaton* automaton, TrieNode** nodes, size_t count) {
+
+    TrieNode* pool = NULL;
+    Pair* edges = NULL;
+    TrieNode* node;
+    TrieNode* dst;
+    NodeMap ids;
+    NodeMasks key_masks;
+    NodeMapItem* item;
+    size_t edges_count;
+    size_t i;
+    size_t k;
+    unsigned j;
+
+    ASSERT(nodes[0] == automaton->root);
+
+    // 1. allocate everything in advance
+    edges_count = 0;
+    for (i=0; i < count; i++) {
+        edges_count += nodes[i]->n;
+    }
+
+    pool = (TrieNode*)memory_alloc(count * sizeof(TrieNode));
+    if (edges_count > 0) {
+        edges = (Pair*)memory_alloc(edges_count * sizeof(Pair));
+    }
+
+    // masks of keys are moved to the new nodes
+    nodemasks_init(&key_masks);
+    if (automaton->key_masks.count > 0 and UNLIKELY(!nodemasks_reserve(&key_masks, automaton->key_masks.count))) {
+        memory_safefree(edges);
+        memory_safefree(pool);
+        PyErr_NoMemory();
+        return false;
+    }
+
+    if (UNLIKELY(pool == NULL or (edges_count > 0 and edges == NULL) or !nodemap_init(&ids, count))) {
+        nodemasks_free(&key_masks);
+        memory_safefree(edges);
+        memory_safefree(pool);
+        PyErr_NoMemory();
+        return false;
+    }
+
+    for (i=0; i < count; i++) {
+        item = nodemap_put(&ids, nodes[i]);
+        ASSERT(item); // map has been allocated for all nodes
+        item->value = (void*)(Py_uintptr_t)i;
+    }
+
+    // 2. copy nodes and edges, pointers are translated into the new arrays;
+    //    values are moved, not copied
+    k = 0;
+    for (i=0; i < count; i++) {
+        node = nodes[i];
+        dst  = &pool[i];
+
+        dst->output = node->output;
+        dst->eow    = node->eow;
+        dst->depth  = node->depth;
+        dst->n      = node->n;
+        dst->fail   = NULL;
+        dst->next   = NULL;
+
+        if (node->eow and automaton_key_mask(automaton, node) != ~(uint64_t)0) {
+            *nodemasks_put(&key_masks, dst) = automaton_key_mask(automaton, node); // space is reserved
+        }
+
+        // fail links of a trie may point to removed nodes, they're
+        // recalculated by make_automaton anyway
+        if (automaton->kind == AHOCORASICK and node->fail != NULL) {
+            dst->fail = &pool[(Py_uintptr_t)nodemap_get(&ids, node->fail)->value];
+        }
+
+        if (node->n > 0) {
+            dst->next = &edges[k];
+            for (j=0; j < node->n; j++) {
+                edges[k].letter = node->next[j].letter;
+                edges[k].child  = &pool[(Py_uintptr_t)nodemap_get(&ids, node->next[j].child)->value];
+                k += 1;
+            }
+        }
+    }
+
+    // 3. release the old structure
+    for (i=0; i < count; i++) {
+        trie_free_node(automaton, nodes[i]);
+    }
+
+    memory_safefree(automaton->pool);
+    memory_safefree(automaton->edges_pool);
+
+    automaton->root            = &pool[0];
+    automaton->pool            = pool;
+    automaton->pool_size       = count;
+    automaton->edges_pool      = edges;
+    automaton->edges_pool_size = edges_count;
+    automaton_bump_version(automaton);
+
+    automaton_free_masks(automaton);
+    automaton->key_masks = key_masks;
+
+    nodemap_free(&ids);
+
+    return automaton_prepare_chain_masks(automaton);
+}
+
+
+static PyObject*
+automaton_compact(PyObject* self, PyObject* args) {
+#define automaton ((Automaton*)self)
+
+    TrieNode** nodes;
+    size_t count;
+    bool ok;
+
+    if (automaton->kind == EMPTY) {
+        Py_RETURN_NONE;
+    }
+
+    nodes = automaton_collect_nodes(automaton, &count, false);
+    if (UNLIKELY(nodes == NULL)) {
+        return NULL;
+    }
+
+    ok = automaton_compact_nodes(automaton, nodes, count);
+    memory_free(nodes);
+    if (not ok) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+#undef automaton
+}
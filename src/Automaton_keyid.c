@@ -0,0 +1,221 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Key ids (STORE_KEY_ID) --- the key table and implementation of
+    key_of() method.
+
+    Keys get ids equal to their ranks in sorted order; all keys are
+    concatenated in order of ids, thus a key is restored from the
+    table without walking the trie. The table is built by
+    make_automaton, or lazily for a loaded automaton.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+static PyObject*
+automaton_build_key(const TRIE_LETTER_TYPE* letters, size_t length) {
+
+#if defined PEP393_UNICODE
+    return F(PyUnicode_FromKindAndData)(PyUnicode_4BYTE_KIND, (void*)letters, length);
+#elif defined AHOCORASICK_UNICODE
+    return PyUnicode_FromUnicode((Py_UNICODE*)letters, length);
+#else
+    PyObject* bytes;
+    char* data;
+    size_t i;
+
+    bytes = F(PyBytes_FromStringAndSize)(NULL, length);
+    if (UNLIKELY(bytes == NULL)) {
+        return NULL;
+    }
+
+    data = PyBytes_AS_STRING(bytes);
+    for (i=0; i < length; i++) {
+        data[i] = (char)letters[i];
+    }
+
+    return bytes;
+#endif
+}
+
+
+static void
+automaton_free_key_table(Automaton* automaton) {
+
+    memory_safefree(automaton->key_letters);
+    memory_safefree(automaton->key_offsets);
+    automaton->key_letters = NULL;
+    automaton->key_offsets = NULL;
+    automaton->key_count   = 0;
+    automaton->key_table_version = -1;
+}
+
+
+/* visits all keys in sorted order, the path keeps letters of a key;
+   if letters is NULL only the number of keys and their total length
+   are calculated, otherwise keys are numbered and copied */
+static void
+automaton_walk_keys(Automaton* automaton, TrieNode** nodes, unsigned* indices, TRIE_LETTER_TYPE* path,
+                    TRIE_LETTER_TYPE* letters, size_t* offsets, size_t* count, size_t* total) {
+
+    TrieNode* node;
+    TrieNode* child;
+    size_t depth;
+
+    *count = 0;
+    *total = 0;
+
+    nodes[0]   = automaton->root;
+    indices[0] = 0;
+    depth      = 0;
+    while (true) {
+        node = nodes[depth];
+        if (indices[depth] == node->n) {
+            if (depth == 0) {
+                break;
+            }
+
+            depth -= 1;
+            continue;
+        }
+
+        if (indices[depth] == 0 and letters == NULL and node->n > 1) {
+            qsort(node->next, node->n, sizeof(Pair), minimize_pair_cmp);
+        }
+
+        child = node->next[indices[depth]].child;
+        path[depth] = node->next[indices[depth]].letter;
+        indices[depth] += 1;
+
+        depth += 1;
+        ASSERT(depth <= (size_t)automaton->longest_word);
+        nodes[depth]   = child;
+        indices[depth] = 0;
+
+        if (child->eow) {
+            if (letters != NULL) {
+                child->output = *count;
+                offsets[*count] = *total;
+                memcpy(letters + *total, path, depth * sizeof(TRIE_LETTER_TYPE));
+            }
+
+            *count += 1;
+            *total += depth;
+        }
+    }
+
+    if (offsets != NULL) {
+        offsets[*count] = *total;
+    }
+}
+
+
+static bool
+automaton_build_key_table(Automaton* automaton) {
+
+    TrieNode** nodes;
+    unsigned* indices;
+    TRIE_LETTER_TYPE* path;
+    TRIE_LETTER_TYPE* letters;
+    size_t* offsets;
+    size_t count;
+    size_t total;
+    size_t n;
+
+    ASSERT(automaton->store == STORE_KEY_ID);
+    ASSERT(automaton->root);
+
+    automaton_free_key_table(automaton);
+
+    // the longest word may be shorter if some keys were removed
+    n = (size_t)automaton->longest_word + 1;
+    nodes   = (TrieNode**)memory_alloc(n * sizeof(TrieNode*));
+    indices = (unsigned*)memory_alloc(n * sizeof(unsigned));
+    path    = (TRIE_LETTER_TYPE*)memory_alloc(n * sizeof(TRIE_LETTER_TYPE));
+    letters = NULL;
+    offsets = NULL;
+    if (UNLIKELY(nodes == NULL or indices == NULL or path == NULL)) {
+        goto no_mem;
+    }
+
+    // 1. sort edges and count letters, then numerate keys and copy them
+    automaton_walk_keys(automaton, nodes, indices, path, NULL, NULL, &count, &total);
+
+    letters = (TRIE_LETTER_TYPE*)memory_alloc((total > 0 ? total : 1) * sizeof(TRIE_LETTER_TYPE));
+    offsets = (size_t*)memory_alloc((count + 1) * sizeof(size_t));
+    if (UNLIKELY(letters == NULL or offsets == NULL)) {
+        goto no_mem;
+    }
+
+    automaton_walk_keys(automaton, nodes, indices, path, letters, offsets, &count, &total);
+
+    memory_free(nodes);
+    memory_free(indices);
+    memory_free(path);
+
+    automaton->key_letters = letters;
+    automaton->key_offsets = offsets;
+    automaton->key_count   = count;
+    automaton->key_table_version = automaton->version;
+
+    return true;
+
+no_mem:
+    memory_safefree(nodes);
+    memory_safefree(indices);
+    memory_safefree(path);
+    memory_safefree(letters);
+    memory_safefree(offsets);
+    PyErr_NoMemory();
+    return false;
+}
+
+
+static bool
+automaton_check_key_table(Automaton* automaton) {
+
+    if (automaton->store != STORE_KEY_ID) {
+        PyErr_SetString(PyExc_AttributeError, "Keys have ids only in an automaton created with STORE_KEY_ID.");
+        return false;
+    }
+
+    if (automaton->kind != AHOCORASICK) {
+        PyErr_SetString(PyExc_AttributeError, "Not an Aho-Corasick automaton yet: "
+                        "call make_automaton to assign ids to keys.");
+        return false;
+    }
+
+    if (automaton->key_table_version == automaton->version) {
+        return true;
+    }
+
+    return automaton_build_key_table(automaton);
+}
+
+
+static PyObject*
+automaton_key_of(PyObject* self, PyObject* args) {
+#define automaton ((Automaton*)self)
+
+    Py_ssize_t id;
+    size_t begin;
+
+    if (not F(PyArg_ParseTuple)(args, "n", &id)) {
+        return NULL;
+    }
+
+    if (not automaton_check_key_table(automaton)) {
+        return NULL;
+    }
+
+    if (id < 0 or (size_t)id >= automaton->key_count) {
+        PyErr_SetString(PyExc_IndexError, "key id out of range");
+        return NULL;
+    }
+
+    begin = automaton->key_offsets[id];
+    return automaton_build_key(automaton->key_letters + begin, automaton->key_offsets[id + 1] - begin);
+#undef automaton
+}
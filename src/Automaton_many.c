@@ -0,0 +1,238 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Searching several strings at once --- implementation of
+    search_many() method.
+
+    Each transition of the automaton is a dependent load: the next
+    state is known once the current one is read. When the automaton
+    doesn't fit in cache a single walk mostly waits for memory. Here
+    a few strings are searched in lockstep, one letter of each string
+    in a round, and nodes needed in the next round are prefetched;
+    thus cache misses of different strings overlap. Matches of a state
+    are reported in the round after the transition, when the node has
+    been already loaded, and only then its edges are prefetched.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+#define AUTOMATON_INTERLEAVE_DEFAULT 8
+#define AUTOMATON_INTERLEAVE_MAX 64
+
+typedef struct AutomatonStream {
+    Py_ssize_t      string; ///< index of searched string, -1 if the stream is idle
+    struct Input    input;
+    Py_ssize_t      index;  ///< current index in the string
+    TrieNode*       state;  ///< current state of the automaton
+    bool            pending;///< matches of the state, ending at index, are yet to be reported
+} AutomatonStream;
+
+
+static bool
+automaton_stream_start(Automaton* automaton, AutomatonStream* stream, PyObject* strings, Py_ssize_t* next) {
+
+    // the input of a stream is valid as long as the stream isn't idle
+    stream->string = -1;
+    if (*next == PySequence_Fast_GET_SIZE(strings)) {
+        return true;
+    }
+
+    init_input(&stream->input);
+    if (not prepare_input((PyObject*)automaton, PySequence_Fast_GET_ITEM(strings, *next), &stream->input)) {
+        return false;
+    }
+
+    stream->string = *next;
+    stream->index  = 0;
+    stream->state  = automaton->root;
+    stream->pending = false;
+    *next += 1;
+
+    return true;
+}
+
+
+static bool
+automaton_stream_output(Automaton* automaton, AutomatonStream* stream, PyObject* matches) {
+
+    TrieNode* node;
+    PyObject* item;
+    size_t k;
+
+    for (node = stream->state; node != NULL; node = node->fail) {
+        if (not node->eow) {
+            continue;
+        }
+
+        if (automaton->store == STORE_MULTI_INTS) {
+            // a match is reported for each integer
+            for (k=0; k < automaton_payload_count(automaton, node); k++) {
+                item = F(Py_BuildValue)("nN", stream->index, automaton_build_payload(automaton, node, k));
+                if (item == NULL or PyList_Append(matches, item) < 0) {
+                    Py_XDECREF(item);
+                    return false;
+                }
+
+                Py_DECREF(item);
+            }
+        } else {
+            item = F(Py_BuildValue)("nN", stream->index, automaton_build_value(automaton, node));
+            if (item == NULL or PyList_Append(matches, item) < 0) {
+                Py_XDECREF(item);
+                return false;
+            }
+
+            Py_DECREF(item);
+        }
+    }
+
+    return true;
+}
+
+
+static PyObject*
+automaton_search_many(PyObject* self, PyObject* args, PyObject* kwargs) {
+#define automaton ((Automaton*)self)
+
+    static char *kwlist[] = {"strings", "interleave", NULL};
+
+    PyObject* object;
+    PyObject* strings;
+    PyObject* result = NULL;
+    PyObject* matches;
+    AutomatonStream* streams = NULL;
+    AutomatonStream* stream;
+    int interleave = AUTOMATON_INTERLEAVE_DEFAULT;
+    Py_ssize_t count;
+    Py_ssize_t next;
+    Py_ssize_t active;
+    Py_ssize_t i;
+    int k;
+
+    if (!F(PyArg_ParseTupleAndKeywords)(args, kwargs, "O|i", kwlist, &object, &interleave)) {
+        return NULL;
+    }
+
+    if (interleave < 1 or interleave > AUTOMATON_INTERLEAVE_MAX) {
+        PyErr_Format(PyExc_ValueError, "interleave must be in range 1 .. %d", AUTOMATON_INTERLEAVE_MAX);
+        return NULL;
+    }
+
+    strings = F(PySequence_Fast)(object, "strings must be iterable");
+    if (strings == NULL) {
+        return NULL;
+    }
+
+    count  = PySequence_Fast_GET_SIZE(strings);
+    result = F(PyList_New)(count);
+    if (result == NULL) {
+        goto error;
+    }
+
+    for (i=0; i < count; i++) {
+        matches = F(PyList_New)(0);
+        if (matches == NULL) {
+            goto error;
+        }
+
+        PyList_SET_ITEM(result, i, matches);
+    }
+
+    if (automaton->kind != AHOCORASICK or count == 0) {
+        Py_DECREF(strings);
+        return result;
+    }
+
+    streams = (AutomatonStream*)memory_alloc(interleave * sizeof(AutomatonStream));
+    if (streams == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+
+    for (k=0; k < interleave; k++) {
+        streams[k].string = -1;
+    }
+
+    automaton_update_prefilter(automaton);
+
+    next = 0;
+    for (k=0; k < interleave; k++) {
+        if (not automaton_stream_start(automaton, &streams[k], strings, &next)) {
+            goto error;
+        }
+    }
+
+    active = (count < interleave) ? count : interleave;
+    while (active > 0) {
+        // 1. nodes were prefetched in the previous round, report their matches
+        //    and prefetch their edges
+        for (k=0; k < interleave; k++) {
+            stream = &streams[k];
+            if (stream->string < 0 or not stream->pending) {
+                continue;
+            }
+
+            if (not automaton_stream_output(automaton, stream, PyList_GET_ITEM(result, stream->string))) {
+                goto error;
+            }
+
+            PREFETCH(stream->state->next);
+            stream->pending = false;
+            stream->index += 1;
+        }
+
+        // 2. a letter of each string
+        for (k=0; k < interleave; k++) {
+            stream = &streams[k];
+            if (stream->string < 0) {
+                continue;
+            }
+
+            if (stream->state == automaton->root) {
+                stream->index = automaton_skip_root(automaton, stream->input.word, stream->index, stream->input.wordlen);
+            }
+
+            if (stream->index >= stream->input.wordlen) {
+                destroy_input(&stream->input);
+                if (not automaton_stream_start(automaton, stream, strings, &next)) {
+                    goto error;
+                }
+
+                if (stream->string < 0) {
+                    active -= 1;
+                }
+
+                continue;
+            }
+
+            stream->state = automaton_next(automaton, stream->state, stream->input.word[stream->index]);
+            stream->pending = true;
+            PREFETCH(stream->state);
+        }
+    }
+
+    memory_free(streams);
+    Py_DECREF(strings);
+    return result;
+
+error:
+    if (streams != NULL) {
+        for (k=0; k < interleave; k++) {
+            if (streams[k].string >= 0) {
+                destroy_input(&streams[k].input);
+            }
+        }
+
+        memory_free(streams);
+    }
+
+    Py_XDECREF(result);
+    Py_DECREF(strings);
+    return NULL;
+#undef automaton
+}
+
+#undef AUTOMATON_INTERLEAVE_DEFAULT
+#undef AUTOMATON_INTERLEAVE_MAX
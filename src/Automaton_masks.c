@@ -0,0 +1,314 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Category masks of keys --- filtering matches by a mask given to
+    iter(), iter_spans(), find_all() and find_all_spans().
+
+    A key may be given a 64-bit mask; a key without a mask matches every
+    mask. For each state of the automaton OR of masks of all keys on its
+    output chain is precomputed, thus a state having no key of the
+    requested categories is skipped with a single lookup. Masks of
+    states are computed by make_automaton, compact, minimize and load;
+    masks of nodes of the pool are kept in an array indexed as the pool,
+    masks of nodes allocated separately in a map.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+static bool
+automaton_parse_mask(PyObject* object, uint64_t* mask) {
+
+    unsigned long long value;
+
+    if (not F(PyLong_Check)(object)) {
+        PyErr_SetString(PyExc_TypeError, "A mask must be an integer.");
+        return false;
+    }
+
+    value = F(PyLong_AsUnsignedLongLong)(object);
+    if (value == (unsigned long long)-1 and PyErr_Occurred()) {
+        return false;
+    }
+
+    if (value == 0) {
+        PyErr_SetString(PyExc_ValueError, "A mask must have at least one bit set.");
+        return false;
+    }
+
+    *mask = (uint64_t)value;
+    return true;
+}
+
+
+static bool
+automaton_parse_mask_kwarg(PyObject* kwargs, uint64_t* mask, bool* use_mask) {
+
+    PyObject* object;
+
+    *use_mask = false;
+    if (kwargs == NULL or PyDict_Size(kwargs) == 0) {
+        return true;
+    }
+
+    object = F(PyDict_GetItemString)(kwargs, "mask");
+    if (object == NULL or PyDict_Size(kwargs) != 1) {
+        PyErr_SetString(PyExc_TypeError, "the only keyword argument accepted is mask");
+        return false;
+    }
+
+    *use_mask = true;
+    return automaton_parse_mask(object, mask);
+}
+
+
+static bool
+automaton_parse_search_mask(Automaton* automaton, PyObject* kwargs, uint64_t* mask, bool* use_mask) {
+
+    if (not automaton_parse_mask_kwarg(kwargs, mask, use_mask)) {
+        return false;
+    }
+
+    if (automaton->key_masks.count == 0) {
+        // every key matches every mask
+        *use_mask = false;
+        return true;
+    }
+
+    if (*use_mask) {
+        return automaton_check_chain_masks(automaton);
+    }
+
+    return true;
+}
+
+
+static bool
+automaton_add_key_mask(Automaton* automaton, TrieNode* node, uint64_t mask) {
+
+    uint64_t* key_mask;
+
+    ASSERT(node->eow);
+
+    key_mask = nodemasks_put(&automaton->key_masks, node);
+    if (UNLIKELY(key_mask == NULL)) {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    *key_mask |= mask;
+    return true;
+}
+
+
+static uint64_t
+automaton_key_mask(const Automaton* automaton, TrieNode* node) {
+
+    uint64_t* key_mask;
+
+    // 0 marks a removed key, a mask given to a key is never 0
+    key_mask = nodemasks_get(&automaton->key_masks, node);
+    if (key_mask == NULL or *key_mask == 0) {
+        return ~(uint64_t)0;
+    }
+
+    return *key_mask;
+}
+
+
+static void
+automaton_remove_key_mask(Automaton* automaton, TrieNode* node) {
+
+    uint64_t* key_mask;
+
+    // the map has no removal, a node at the same address must not
+    // inherit the mask; zeroed masks are dropped by make_automaton
+    key_mask = nodemasks_get(&automaton->key_masks, node);
+    if (key_mask != NULL) {
+        *key_mask = 0;
+    }
+}
+
+
+static void
+automaton_prune_key_masks(Automaton* automaton) {
+
+    NodeMasks key_masks;
+    TrieNode** nodes;
+    size_t count;
+    size_t live;
+    size_t i;
+
+    live = 0;
+    for (i=0; i < automaton->key_masks.count; i++) {
+        live += (automaton->key_masks.masks[i] != 0);
+    }
+
+    if (live == automaton->key_masks.count) {
+        return;
+    }
+
+    // masks of removed keys are left in the map (keys might have been
+    // added again at the same addresses), thus masks of existing keys
+    // are copied into a new map
+    nodes = NULL;
+    nodemasks_init(&key_masks);
+    if (live > 0) {
+        nodes = automaton_collect_nodes(automaton, &count, false);
+        if (UNLIKELY(nodes == NULL or !nodemasks_reserve(&key_masks, live))) {
+            // pruning is optional, the old map is still valid
+            memory_safefree(nodes);
+            PyErr_Clear();
+            return;
+        }
+
+        for (i=0; i < count; i++) {
+            if (nodes[i]->eow and automaton_key_mask(automaton, nodes[i]) != ~(uint64_t)0) {
+                *nodemasks_put(&key_masks, nodes[i]) = automaton_key_mask(automaton, nodes[i]); // space is reserved
+            }
+        }
+
+        memory_free(nodes);
+    }
+
+    nodemasks_free(&automaton->key_masks);
+    automaton->key_masks = key_masks;
+}
+
+
+static bool
+automaton_build_chain_masks(Automaton* automaton) {
+
+    TrieNode** nodes;
+    TrieNode* node;
+    uint64_t* chain_mask;
+    uint64_t mask;
+    size_t count;
+    size_t i;
+
+    automaton_free_chain_masks(automaton);
+
+    nodes = automaton_collect_nodes(automaton, &count, false);
+    if (UNLIKELY(nodes == NULL)) {
+        return false;
+    }
+
+    if (automaton->pool != NULL) {
+        automaton->pool_chain_masks = (uint64_t*)memory_alloc(automaton->pool_size * sizeof(uint64_t));
+        if (UNLIKELY(automaton->pool_chain_masks == NULL)) {
+            memory_free(nodes);
+            PyErr_NoMemory();
+            return false;
+        }
+
+        memset(automaton->pool_chain_masks, 0, automaton->pool_size * sizeof(uint64_t));
+    }
+
+    // nodes are in BFS order, thus the fail node of a node, which is
+    // closer to the root, already has its mask
+    for (i=0; i < count; i++) {
+        node = nodes[i];
+        mask = (node->fail != NULL) ? automaton_chain_mask(automaton, node->fail) : 0;
+        if (node->eow) {
+            mask |= automaton_key_mask(automaton, node);
+        }
+
+        if (mask == 0) {
+            continue;
+        }
+
+        chain_mask = automaton_pool_chain_mask(automaton, node);
+        if (chain_mask == NULL) {
+            chain_mask = nodemasks_put(&automaton->chain_masks, node);
+            if (UNLIKELY(chain_mask == NULL)) {
+                memory_free(nodes);
+                automaton_free_chain_masks(automaton);
+                PyErr_NoMemory();
+                return false;
+            }
+        }
+
+        *chain_mask = mask;
+    }
+
+    memory_free(nodes);
+    automaton->chain_masks_version = automaton->version;
+
+    return true;
+}
+
+
+static bool
+automaton_check_chain_masks(Automaton* automaton) {
+
+    if (automaton->chain_masks_version == automaton->version) {
+        return true;
+    }
+
+    return automaton_build_chain_masks(automaton);
+}
+
+
+static bool
+automaton_prepare_chain_masks(Automaton* automaton) {
+
+    // only an automaton is searched
+    if (automaton->kind != AHOCORASICK or automaton->key_masks.count == 0) {
+        return true;
+    }
+
+    return automaton_check_chain_masks(automaton);
+}
+
+
+static uint64_t*
+automaton_pool_chain_mask(Automaton* automaton, TrieNode* node) {
+
+    size_t index;
+
+    if (automaton->pool_chain_masks == NULL) {
+        return NULL;
+    }
+
+    // a node below the pool wraps around to a large index
+    index = (size_t)(((Py_uintptr_t)node - (Py_uintptr_t)automaton->pool) / sizeof(TrieNode));
+    if (index >= automaton->pool_size) {
+        return NULL;
+    }
+
+    return &automaton->pool_chain_masks[index];
+}
+
+
+static uint64_t
+automaton_chain_mask(Automaton* automaton, TrieNode* node) {
+
+    uint64_t* chain_mask;
+
+    chain_mask = automaton_pool_chain_mask(automaton, node);
+    if (chain_mask != NULL) {
+        return *chain_mask;
+    }
+
+    chain_mask = nodemasks_get(&automaton->chain_masks, node);
+    return (chain_mask != NULL) ? *chain_mask : 0;
+}
+
+
+static void
+automaton_free_chain_masks(Automaton* automaton) {
+
+    nodemasks_free(&automaton->chain_masks);
+    memory_safefree(automaton->pool_chain_masks);
+    automaton->pool_chain_masks    = NULL;
+    automaton->chain_masks_version = -1;
+}
+
+
+static void
+automaton_free_masks(Automaton* automaton) {
+
+    nodemasks_free(&automaton->key_masks);
+    automaton_free_chain_masks(automaton);
+}
@@ -0,0 +1,408 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Automaton minimization --- implementation of minimize() method
+    and helpers for walking a minimized automaton.
+
+    A minimized automaton is a DAG rather than a tree: equivalent nodes
+    are shared by many paths, thus all procedures that visit each node
+    once (clear, statistics, dump) have to recognize visited nodes.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+#include "nodemap.h"
+
+static bool
+automaton_check_not_minimized(Automaton* automaton) {
+
+    if (UNLIKELY(automaton->minimized)) {
+        PyErr_SetString(PyExc_AttributeError, "Automaton is minimized and read-only; call clear() to reuse it.");
+        return false;
+    }
+
+    return true;
+}
+
+
+static int
+minimize_pair_cmp(const void* a, const void* b) {
+
+    const TRIE_LETTER_TYPE A = ((const Pair*)a)->letter;
+    const TRIE_LETTER_TYPE B = ((const Pair*)b)->letter;
+
+    return (A > B) - (A < B);
+}
+
+
+static TrieNode**
+automaton_collect_nodes(Automaton* automaton, size_t* count, bool sort_edges) {
+
+    TrieNode** nodes;
+    TrieNode** tmp;
+    TrieNode* node;
+    TrieNode* child;
+    NodeMap visited;
+    Pair* edges = NULL;
+    Pair* edges_tmp;
+    size_t edges_capacity = 0;
+    size_t capacity;
+    size_t n;
+    size_t i;
+    unsigned j;
+
+    ASSERT(automaton->root);
+
+    capacity = 1024;
+    nodes = (TrieNode**)memory_alloc(capacity * sizeof(TrieNode*));
+    if (UNLIKELY(nodes == NULL)) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    if (UNLIKELY(!nodemap_init(&visited, capacity))) {
+        memory_free(nodes);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    n = 0;
+    nodes[n++] = automaton->root;
+    if (UNLIKELY(nodemap_put(&visited, automaton->root) == NULL)) {
+        goto no_mem;
+    }
+
+    // nodes array is also a queue for BFS; only a minimized automaton
+    // may reach a node more than once
+    for (i=0; i < n; i++) {
+        node = nodes[i];
+        if (sort_edges and node->n > 1) {
+            if (node->n > edges_capacity) {
+                edges_tmp = (Pair*)memory_realloc(edges, node->n * sizeof(Pair));
+                if (UNLIKELY(edges_tmp == NULL)) {
+                    goto no_mem;
+                }
+
+                edges = edges_tmp;
+                edges_capacity = node->n;
+            }
+
+            memcpy(edges, node->next, node->n * sizeof(Pair));
+            qsort(edges, node->n, sizeof(Pair), minimize_pair_cmp);
+        }
+
+        for (j=0; j < node->n; j++) {
+            if (sort_edges and node->n > 1) {
+                child = edges[j].child;
+            } else {
+                child = trienode_get_ith_unsafe(node, j);
+            }
+
+            if (automaton->minimized) {
+                if (nodemap_get(&visited, child) != NULL) {
+                    continue;
+                }
+
+                if (UNLIKELY(nodemap_put(&visited, child) == NULL)) {
+                    goto no_mem;
+                }
+            }
+
+            if (n == capacity) {
+                tmp = (TrieNode**)memory_realloc(nodes, 2 * capacity * sizeof(TrieNode*));
+                if (UNLIKELY(tmp == NULL)) {
+                    goto no_mem;
+                }
+
+                nodes = tmp;
+                capacity *= 2;
+            }
+
+            nodes[n++] = child;
+        }
+    }
+
+    nodemap_free(&visited);
+    memory_safefree(edges);
+    *count = n;
+    return nodes;
+
+no_mem:
+    nodemap_free(&visited);
+    memory_safefree(edges);
+    memory_free(nodes);
+    PyErr_NoMemory();
+    return NULL;
+}
+
+
+static void
+automaton_clear_minimized(Automaton* automaton) {
+
+    // It must not fail, so nothing is allocated: all nodes are linked into
+    // a list through the fail field and bit 1 of eow marks linked nodes.
+    TrieNode* node;
+    TrieNode* last;
+    TrieNode* child;
+    unsigned i;
+
+    ASSERT(automaton->root);
+
+    node = automaton->root;
+    last = node;
+    node->fail = NULL;
+    node->eow |= 2;
+
+    for (/**/; node != NULL; node = node->fail) {
+        for (i=0; i < node->n; i++) {
+            child = trienode_get_ith_unsafe(node, i);
+            if (child->eow & 2) {
+                continue;
+            }
+
+            child->eow |= 2;
+            child->fail = NULL;
+            last->fail  = child;
+            last = child;
+        }
+    }
+
+    node = automaton->root;
+    while (node != NULL) {
+        child = node->fail;
+        trie_free_node(automaton, node);
+        node = child;
+    }
+}
+
+
+#define minimize_mix(h, x) (((h) ^ (uint64_t)(x)) * 0x100000001b3ull)
+
+/* output of a node: an integer, address of a value (STORE_ANY), i.e.
+   values are compared by identity, or a word from the value column;
+   byte strings are represented by their hash */
+static uint64_t PURE
+minimize_node_output(const Automaton* automaton, const TrieNode* node) {
+
+    const char* data;
+    uint64_t h;
+    size_t length;
+    size_t i;
+
+    switch (automaton->store) {
+        case STORE_ANY:
+            return (Py_uintptr_t)automaton_get_value(automaton, node);
+
+        case STORE_INT64:
+        case STORE_FLOAT:
+            return valuecolumn_get(&automaton->column, node->output);
+
+        case STORE_BYTES:
+        case STORE_MULTI_INTS:
+            data   = valuecolumn_get_bytes(&automaton->column, node->output);
+            length = valuecolumn_get_length(&automaton->column, node->output);
+            h = 0xcbf29ce484222325ull;
+            for (i=0; i < length; i++) {
+                h = minimize_mix(h, (unsigned char)data[i]);
+            }
+
+            return minimize_mix(h, length);
+
+        default:
+            return node->output;
+    }
+}
+
+
+static bool PURE
+minimize_output_equal(const Automaton* automaton, const TrieNode* a, const TrieNode* b) {
+
+    size_t length;
+
+    if (not store_column_is_bytes(automaton->store)) {
+        return minimize_node_output(automaton, a) == minimize_node_output(automaton, b);
+    }
+
+    length = valuecolumn_get_length(&automaton->column, a->output);
+    return length == valuecolumn_get_length(&automaton->column, b->output)
+       and memcmp(valuecolumn_get_bytes(&automaton->column, a->output),
+                  valuecolumn_get_bytes(&automaton->column, b->output),
+                  length) == 0;
+}
+
+
+static size_t PURE
+minimize_node_hash(const Automaton* automaton, const TrieNode* node) {
+
+    uint64_t h = 0xcbf29ce484222325ull;
+    unsigned i;
+
+    h = minimize_mix(h, node->eow);
+    if (node->eow) {
+        h = minimize_mix(h, minimize_node_output(automaton, node));
+        h = minimize_mix(h, automaton_key_mask(automaton, (TrieNode*)node));
+    }
+
+    h = minimize_mix(h, (Py_uintptr_t)node->fail);
+    h = minimize_mix(h, node->n);
+    for (i=0; i < node->n; i++) {
+        h = minimize_mix(h, node->next[i].letter);
+        h = minimize_mix(h, (Py_uintptr_t)node->next[i].child);
+    }
+
+    return (size_t)(h ^ (h >> 29));
+}
+
+#undef minimize_mix
+
+
+static bool PURE
+minimize_node_equal(const Automaton* automaton, const TrieNode* a, const TrieNode* b) {
+
+    if (a->eow != b->eow or a->fail != b->fail or a->n != b->n) {
+        return false;
+    }
+
+    if (a->eow and not minimize_output_equal(automaton, a, b)) {
+        return false;
+    }
+
+    if (a->eow and automaton_key_mask(automaton, (TrieNode*)a) != automaton_key_mask(automaton, (TrieNode*)b)) {
+        return false;
+    }
+
+    return a->n == 0 or memcmp(a->next, b->next, a->n * sizeof(Pair)) == 0;
+}
+
+
+static PyObject*
+automaton_minimize(PyObject* self, PyObject* args) {
+#define automaton ((Automaton*)self)
+
+    TrieNode** nodes = NULL;
+    TrieNode** table = NULL;
+    TrieNode* node;
+    NodeMap merged;
+    NodeMapItem* item;
+    size_t count;
+    size_t size;
+    size_t index;
+    size_t i;
+    unsigned j;
+
+    if (automaton->kind != AHOCORASICK) {
+        PyErr_SetString(PyExc_AttributeError, "Not an Aho-Corasick automaton yet: "
+                        "call add_word to add some keys and call make_automaton to "
+                        "convert the trie to an automaton.");
+        return NULL;
+    }
+
+    if (automaton->minimized) {
+        Py_RETURN_NONE;
+    }
+
+    // 1. collect nodes in BFS order; allocate everything in advance,
+    //    once the nodes are being merged nothing can fail
+    nodes = automaton_collect_nodes(automaton, &count, false);
+    if (nodes == NULL) {
+        return NULL;
+    }
+
+    size = 16;
+    while (size < 2 * count) {
+        size *= 2;
+    }
+
+    table = (TrieNode**)memory_alloc(size * sizeof(TrieNode*));
+    if (UNLIKELY(table == NULL or !nodemap_init(&merged, count))) {
+        memory_safefree(table);
+        memory_free(nodes);
+        PyErr_NoMemory();
+        return NULL;
+    }
+
+    memset(table, 0, size * sizeof(TrieNode*));
+
+    // 2. bottom-up: children of a node are already replaced with their
+    //    representatives, so a node is equivalent to an already seen one
+    //    if they have the same output, fail link and edges; the root is
+    //    never merged
+    for (i=count; i > 0; i--) {
+        node = nodes[i - 1];
+
+        for (j=0; j < node->n; j++) {
+            item = nodemap_get(&merged, node->next[j].child);
+            if (item != NULL) {
+                node->next[j].child = (TrieNode*)item->value;
+            }
+        }
+
+        if (node->n > 1) {
+            qsort(node->next, node->n, sizeof(Pair), minimize_pair_cmp);
+        }
+
+        if (node == automaton->root) {
+            continue;
+        }
+
+        index = minimize_node_hash(automaton, node) & (size - 1);
+        while (table[index] != NULL and not minimize_node_equal(automaton, table[index], node)) {
+            index = (index + 1) & (size - 1);
+        }
+
+        if (table[index] == NULL) {
+            table[index] = node;
+        } else {
+            item = nodemap_put(&merged, node);
+            ASSERT(item); // map has been allocated for all nodes
+            item->value = table[index];
+        }
+    }
+
+    // 3. redirect fail links of the remaining nodes to representatives,
+    //    then free merged nodes
+    for (i=0; i < count; i++) {
+        node = nodes[i];
+        if (nodemap_get(&merged, node) != NULL) {
+            continue;
+        }
+
+        if (node->fail != NULL) {
+            item = nodemap_get(&merged, node->fail);
+            if (item != NULL) {
+                node->fail = (TrieNode*)item->value;
+            }
+        }
+    }
+
+    for (i=0; i < count; i++) {
+        node = nodes[i];
+        if (nodemap_get(&merged, node) == NULL) {
+            continue;
+        }
+
+        // the representative holds the same value, for STORE_ANY
+        // the reference count can't drop to zero
+        if (node->eow) {
+            automaton_remove_value(automaton, node);
+        }
+
+        trie_free_node(automaton, node);
+    }
+
+    nodemap_free(&merged);
+    memory_free(table);
+    memory_free(nodes);
+
+    automaton->minimized = true;
+    automaton_bump_version(automaton);
+
+    if (not automaton_prepare_chain_masks(automaton)) {
+        return NULL;
+    }
+
+    Py_RETURN_NONE;
+#undef automaton
+}
@@ -0,0 +1,327 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Profile-guided layout --- implementation of optimize() method.
+
+    The automaton searches sample texts and counts how many times each
+    edge is taken and each node is visited. Then edges of every node
+    are reordered, the most frequent first, thus trienode_get_next
+    usually stops at the first edges. Finally nodes are compacted in
+    order of their frequency, thus nodes visited most often share
+    cache lines.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+typedef struct OptimizeProfile {
+    TrieNode**  nodes;  ///< all nodes in BFS order
+    size_t      count;  ///< number of nodes
+    NodeMap     ids;    ///< node -> its index in nodes
+    size_t*     visits; ///< number of visits of each node
+    size_t*     edges;  ///< number of transitions over each edge, edges of the i-th node start at first_edge[i]
+    size_t*     first_edge;
+} OptimizeProfile;
+
+
+typedef struct OptimizeEdge {
+    size_t      count;
+    unsigned    index;  ///< original position, ties keep the order
+    Pair        pair;
+} OptimizeEdge;
+
+
+typedef struct OptimizeNode {
+    size_t      count;
+    size_t      index;  ///< position in BFS order, ties keep the order
+    TrieNode*   node;
+} OptimizeNode;
+
+
+static void
+optimize_profile_free(OptimizeProfile* profile) {
+
+    memory_safefree(profile->nodes);
+    memory_safefree(profile->visits);
+    memory_safefree(profile->edges);
+    memory_safefree(profile->first_edge);
+    if (profile->ids.items != NULL) {
+        nodemap_free(&profile->ids);
+    }
+}
+
+
+static bool
+optimize_profile_init(Automaton* automaton, OptimizeProfile* profile) {
+
+    NodeMapItem* item;
+    size_t edges_count;
+    size_t i;
+
+    memset(profile, 0, sizeof(OptimizeProfile));
+
+    profile->nodes = automaton_collect_nodes(automaton, &profile->count, false);
+    if (UNLIKELY(profile->nodes == NULL)) {
+        return false;
+    }
+
+    edges_count = 0;
+    for (i=0; i < profile->count; i++) {
+        edges_count += profile->nodes[i]->n;
+    }
+
+    profile->visits     = (size_t*)memory_alloc(profile->count * sizeof(size_t));
+    profile->first_edge = (size_t*)memory_alloc(profile->count * sizeof(size_t));
+    profile->edges      = (size_t*)memory_alloc((edges_count + 1) * sizeof(size_t));
+    if (UNLIKELY(profile->visits == NULL or profile->first_edge == NULL or profile->edges == NULL
+                 or !nodemap_init(&profile->ids, profile->count))) {
+        optimize_profile_free(profile);
+        PyErr_NoMemory();
+        return false;
+    }
+
+    memset(profile->visits, 0, profile->count * sizeof(size_t));
+    memset(profile->edges, 0, (edges_count + 1) * sizeof(size_t));
+
+    edges_count = 0;
+    for (i=0; i < profile->count; i++) {
+        item = nodemap_put(&profile->ids, profile->nodes[i]);
+        ASSERT(item); // map has been allocated for all nodes
+        item->value = (void*)(Py_uintptr_t)i;
+
+        profile->first_edge[i] = edges_count;
+        edges_count += profile->nodes[i]->n;
+    }
+
+    return true;
+}
+
+
+static void
+optimize_profile_text(Automaton* automaton, OptimizeProfile* profile, const TRIE_LETTER_TYPE* word, Py_ssize_t length) {
+
+    // the same walk as automaton_next, but the taken edge is recorded
+    TrieNode* state;
+    TrieNode* node;
+    size_t id;
+    Py_ssize_t i;
+    unsigned j;
+
+#define node_id(node) ((size_t)(Py_uintptr_t)nodemap_get(&profile->ids, (node))->value)
+
+    state = automaton->root;
+    for (i=0; i < length; i++) {
+        node = state;
+        state = automaton->root;
+        while (node != NULL) {
+            id = node_id(node);
+            for (j=0; j < node->n; j++) {
+                if (node->next[j].letter == word[i]) {
+                    profile->edges[profile->first_edge[id] + j] += 1;
+                    state = node->next[j].child;
+                    goto found;
+                }
+            }
+
+            node = node->fail;
+        }
+
+    found:
+        profile->visits[node_id(state)] += 1;
+    }
+
+#undef node_id
+}
+
+
+static int
+optimize_edge_cmp(const void* a, const void* b) {
+
+    const OptimizeEdge* A = (const OptimizeEdge*)a;
+    const OptimizeEdge* B = (const OptimizeEdge*)b;
+
+    if (A->count != B->count) {
+        return (A->count > B->count) ? -1 : 1;
+    }
+
+    return (A->index < B->index) ? -1 : (A->index > B->index);
+}
+
+
+static int
+optimize_node_cmp(const void* a, const void* b) {
+
+    const OptimizeNode* A = (const OptimizeNode*)a;
+    const OptimizeNode* B = (const OptimizeNode*)b;
+
+    if (A->count != B->count) {
+        return (A->count > B->count) ? -1 : 1;
+    }
+
+    return (A->index < B->index) ? -1 : (A->index > B->index);
+}
+
+
+static bool
+optimize_reorder_edges(OptimizeProfile* profile) {
+
+    OptimizeEdge* edges;
+    TrieNode* node;
+    unsigned max_n;
+    size_t i;
+    unsigned j;
+
+    max_n = 0;
+    for (i=0; i < profile->count; i++) {
+        if (profile->nodes[i]->n > max_n) {
+            max_n = profile->nodes[i]->n;
+        }
+    }
+
+    if (max_n < 2) {
+        return true;
+    }
+
+    edges = (OptimizeEdge*)memory_alloc(max_n * sizeof(OptimizeEdge));
+    if (UNLIKELY(edges == NULL)) {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    for (i=0; i < profile->count; i++) {
+        node = profile->nodes[i];
+        if (node->n < 2) {
+            continue;
+        }
+
+        for (j=0; j < node->n; j++) {
+            edges[j].count = profile->edges[profile->first_edge[i] + j];
+            edges[j].index = j;
+            edges[j].pair  = node->next[j];
+        }
+
+        qsort(edges, node->n, sizeof(OptimizeEdge), optimize_edge_cmp);
+
+        // edges may be in the pool, they are reordered in place
+        for (j=0; j < node->n; j++) {
+            node->next[j] = edges[j].pair;
+        }
+    }
+
+    memory_free(edges);
+    return true;
+}
+
+
+static bool
+optimize_reorder_nodes(Automaton* automaton, OptimizeProfile* profile) {
+
+    OptimizeNode* order;
+    size_t i;
+    bool ok;
+
+    order = (OptimizeNode*)memory_alloc(profile->count * sizeof(OptimizeNode));
+    if (UNLIKELY(order == NULL)) {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    for (i=0; i < profile->count; i++) {
+        order[i].count = profile->visits[i];
+        order[i].index = i;
+        order[i].node  = profile->nodes[i];
+    }
+
+    // the root stays the first node
+    qsort(order + 1, profile->count - 1, sizeof(OptimizeNode), optimize_node_cmp);
+    for (i=0; i < profile->count; i++) {
+        profile->nodes[i] = order[i].node;
+    }
+
+    memory_free(order);
+
+    ok = automaton_compact_nodes(automaton, profile->nodes, profile->count);
+
+    // nodes were moved, the map refers to released memory
+    nodemap_free(&profile->ids);
+    profile->ids.items = NULL;
+
+    return ok;
+}
+
+
+static PyObject*
+automaton_optimize(PyObject* self, PyObject* args) {
+#define automaton ((Automaton*)self)
+
+    OptimizeProfile profile;
+    PyObject* texts;
+    PyObject* iterator;
+    PyObject* text;
+    struct Input input;
+    int version;
+
+    if (automaton->kind != AHOCORASICK) {
+        PyErr_SetString(PyExc_AttributeError, "not an automaton yet; add some words and call make_automaton");
+        return NULL;
+    }
+
+    if (not F(PyArg_ParseTuple)(args, "O", &texts)) {
+        return NULL;
+    }
+
+    iterator = F(PyObject_GetIter)(texts);
+    if (iterator == NULL) {
+        return NULL;
+    }
+
+    if (not optimize_profile_init(automaton, &profile)) {
+        Py_DECREF(iterator);
+        return NULL;
+    }
+
+    // 1. collect statistics
+    while ((text = F(PyIter_Next)(iterator)) != NULL) {
+        init_input(&input);
+        if (not prepare_input(self, text, &input)) {
+            Py_DECREF(text);
+            goto error;
+        }
+
+        optimize_profile_text(automaton, &profile, input.word, input.wordlen);
+
+        destroy_input(&input);
+        Py_DECREF(text);
+    }
+
+    if (PyErr_Occurred()) {
+        goto error;
+    }
+
+    // 2. ids of keys are ranks in sorted order, they don't depend on the layout;
+    //    the table is built before edges are reordered, as building sorts them
+    if (automaton->store == STORE_KEY_ID and not automaton_check_key_table(automaton)) {
+        goto error;
+    }
+
+    // 3. change the layout
+    version = automaton->version;
+    if (not optimize_reorder_edges(&profile) or not optimize_reorder_nodes(automaton, &profile)) {
+        goto error;
+    }
+
+    if (automaton->key_table_version == version) {
+        automaton->key_table_version = automaton->version;
+    }
+
+    optimize_profile_free(&profile);
+    Py_DECREF(iterator);
+    Py_RETURN_NONE;
+
+error:
+    optimize_profile_free(&profile);
+    Py_DECREF(iterator);
+    return NULL;
+#undef automaton
+}
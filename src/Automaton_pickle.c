@@ -9,35 +9,23 @@
 */
 
 /*
-Pickling (automaton___reduce__):
-
-1. assign sequential numbers to nodes in order to replace
-   address with these numbers
-   (pickle_dump_replace_fail_with_id)
-2. save in array all nodes data in the same order as numbers,
-   also replace fail and next links with numbers; collect on
-   a list all values (python objects) stored in a trie
-   (pickle_dump_save);
-
-   Before we start, all nodes of trie are visited and total
-   size of pickled data is calculated. If it is small enough
-   (less than given threshold), all data is saved in a single
-   byte array. Otherwise, data is saved in several byte arrays.
-
-   In either case, the format of byte array is the same:
-   * 8 first bytes is number of nodes stored in this
-     chunk of memory
-   * the number if followed by some raw data.
-
-   When there is just one byte array, it's size is fit to
-   needs. If data is split, then each array has exactly the
-   same size of bytes, but not all might be used (only the
-   last array is fit).
-
-3. clean up
-   (pickle_dump_undo_replace or pickle_dump_revert_replace)
-
-Unpickling (automaton_unpickle, called in Automaton constructor)
+Pickling (automaton___reduce_ex__):
+
+The automaton is written in the format version 3 (see
+custompickle/custompickle.h) into a single bytes object; nodes
+are numbered using a separate map, the trie is not modified.
+Values of STORE_ANY are not serialized, the list of them is
+passed to pickle.
+
+Pickle protocol 5 gets the bytes object wrapped in PickleBuffer,
+thus it might be transferred out-of-band, without copying.
+
+The constructor called with (data, values) loads the automaton
+(automaton_unpickle3); data is any object supporting the buffer
+protocol.
+
+Unpickling of the legacy format (automaton_unpickle, called in
+the constructor with 7 arguments):
 1. load all nodes from array
 2. make number->node lookup table
 3. replace numbers stored in fail and next pointers with
@@ -46,242 +34,90 @@ Unpickling (automaton_unpickle, called in Automaton constructor)
 
 
 #include <string.h>
-#include "pickle/pickle_data.c"
+#include "pickle/pickle.h"
 
-typedef struct NodeID {
-    TrieNode* fail;         ///< original fail value
-    Py_uintptr_t id;        ///< id
-} NodeID;
-
-typedef struct DumpState {
-    Py_uintptr_t id;        ///< next id
-    size_t total_size;      ///< number of nodes
-    TrieNode* failed_on;    ///< if fail while numerating, save node in order
-                            ///  to revert changes made in trie
-} DumpState;
-
-
-static size_t
-get_pickled_size(TrieNode* node) {
-    ASSERT(node != NULL);
-    return PICKLE_TRIENODE_SIZE + node->n * sizeof(Pair);
-}
 
-// replace fail with pairs (fail, id)
-static int
-pickle_dump_replace_fail_with_id(TrieNode* node, const int depth, void* extra) {
-
-    NodeID* repl;
-
-    ASSERT(sizeof(NodeID*) <= sizeof(TrieNode*));
-#define state ((DumpState*)extra)
-    repl = (NodeID*)memory_alloc(sizeof(NodeID));
-    if (LIKELY(repl != NULL)) {
-        state->id += 1;
-        state->total_size += get_pickled_size(node);
+static PyObject*
+automaton_reduce_impl(Automaton* automaton, int protocol) {
 
-        repl->id   = state->id;
-        repl->fail = node->fail;
+    SaveBuffer  output;
+    PyObject*   data;
+    PyObject*   values = NULL;
+    PyObject*   tuple;
 
-        node->fail = (TrieNode*)repl;
-        return 1;
-    }
-    else {
-        // error, revert is needed!
-        state->failed_on = node;
-        return 0;
+    // the exact size is reserved once the nodes are counted
+    if (!savebuffer_init_memory(&output, NULL, automaton->store, 0)) {
+        return NULL;
     }
-#undef state
-}
 
-
-// revert changes in trie (in case of error)
-static int
-pickle_dump_revert_replace(TrieNode* node, const int depth, void* extra) {
-#define state ((DumpState*)extra)
-    if (state->failed_on != node) {
-        NodeID* repl = (NodeID*)(node->fail);
-        node->fail = repl->fail;
-        memory_free(repl);
-
-        return 1;
+    if (UNLIKELY(!automaton_save_to_buffer(automaton, &output, false, false, &values))) {
+        savebuffer_finalize(&output);
+        return NULL;
     }
-    else
-        return 0;
-#undef state
-}
 
-
-// revert changes in trie
-static int
-pickle_dump_undo_replace(TrieNode* node, const int depth, void* extra) {
-#define state ((DumpState*)extra)
-    NodeID* repl = (NodeID*)(node->fail);
-    node->fail = repl->fail;
-    memory_free(repl);
-
-    return 1;
-#undef state
-}
-
-
-static int
-pickle_dump_save(TrieNode* node, const int depth, void* extra) {
-#define self ((PickleData*)extra)
-#define NODEID(object) ((NodeID*)((TrieNode*)object)->fail)
-
-    TrieNode* dump;
-    TrieNode* tmp;
-    Pair* arr;
-    unsigned i;
-    size_t size;
-
-    size = get_pickled_size(node);
-    if (UNLIKELY(self->top + size > self->size)) {
-        if (UNLIKELY(!pickle_data__add_next_buffer(self))) {
-            self->error = true;
-            return 0;
-        }
+    data = savebuffer_finalize_memory(&output);
+    if (UNLIKELY(data == NULL)) {
+        Py_XDECREF(values);
+        return NULL;
     }
 
-    dump = (TrieNode*)(self->data + self->top);
+    if (values == NULL) { // always pickle a Python object
+        values = Py_None;
+        Py_INCREF(values);
+    }
 
-    // we do not save the last pointer in array
-    arr = (Pair*)(self->data + self->top + PICKLE_TRIENODE_SIZE);
+    if (protocol >= 5) {
+        PyObject* buffer;
 
-    // append the python object to the list
-    if (node->eow and self->values) {
-        if (PyList_Append(self->values, node->output.object) == -1) {
-            self->error = true;
-            return 0;
+        buffer = F(PyPickleBuffer_FromObject)(data);
+        Py_DECREF(data);
+        if (UNLIKELY(buffer == NULL)) {
+            Py_DECREF(values);
+            return NULL;
         }
-    }
 
-    // save node data
-    if (self->values)
-        dump->output.integer = 0;
-    else
-        dump->output.integer = node->output.integer;
-
-    dump->n         = node->n;
-    dump->eow       = node->eow;
-
-    tmp = NODEID(node)->fail;
-    if (tmp)
-        dump->fail  = (TrieNode*)(NODEID(tmp)->id);
-    else
-        dump->fail  = NULL;
-
-    // save array of pointers
-    for (i=0; i < node->n; i++) {
-        TrieNode* child = trienode_get_ith_unsafe(node, i);
-        ASSERT(child);
-        arr[i].child  = (TrieNode*)(NODEID(child)->id);    // save the id of child node
-        arr[i].letter = trieletter_get_ith_unsafe(node, i);
+        data = buffer;
     }
 
-    self->top       += size;
-    (*self->count)  += 1;
-    return 1;
-#undef NODEID
-#undef self
+    tuple = F(Py_BuildValue)("O(OO)", Py_TYPE(automaton), data, values);
+    Py_DECREF(data);
+    Py_DECREF(values);
+
+    return tuple;
 }
 
 
 static PyObject*
 automaton___reduce__(PyObject* self, PyObject* args) {
-#define automaton ((Automaton*)self)
-
-#define MB ((size_t)(1024*1024))
-
-    const size_t array_size = 16*MB;
-
-    DumpState   state;
-    PickleData  data;
-    PyObject*   tuple;
+    return automaton_reduce_impl((Automaton*)self, 0);
+}
 
-    // 0. for an empty automaton do nothing
-    if (automaton->count == 0) {
-        // the class constructor feed with an empty argument build an empty automaton
-        return F(Py_BuildValue)("O()", Py_TYPE(self));
-    }
 
-    // 1. numerate nodes
-    state.id        = 0;
-    state.failed_on = NULL;
-    state.total_size = 0;
+static PyObject*
+automaton___reduce_ex__(PyObject* self, PyObject* args) {
 
-    trie_traverse(automaton->root, pickle_dump_replace_fail_with_id, &state);
-    if (state.failed_on) {
-        // revert changes (partial)
-        trie_traverse(automaton->root, pickle_dump_revert_replace, &state);
+    int protocol;
 
-        // and set error
-        PyErr_NoMemory();
+    if (UNLIKELY(!F(PyArg_ParseTuple)(args, "i", &protocol))) {
         return NULL;
     }
 
-    // 2. gather data
-    if (!pickle_data__init(&data, automaton->store, state.total_size, array_size))
-        goto exception;
-
-    trie_traverse(automaton->root, pickle_dump_save, &data);
-    if (UNLIKELY(data.error)) {
-        goto exception;
-    }
+    return automaton_reduce_impl((Automaton*)self, protocol);
+}
 
-    if (UNLIKELY(!pickle_data__shrink_last_buffer(&data))) {
-        goto exception;
-    }
 
-    if (automaton->store != STORE_ANY) { // always pickle a Python object
-        data.values = Py_None;
-        Py_INCREF(data.values);
-    }
+static bool
+automaton_unpickle3(Automaton* automaton, PyObject* data, PyObject* values) {
 
-    /* 3: save tuple:
-        * binary data
-        * automaton->kind
-        * automaton->store
-        * automaton->key_type
-        * automaton->count
-        * automaton->longest_word
-        * list of values
-    */
-
-    tuple = F(Py_BuildValue)(
-        "O(OiiiiiO)",
-        Py_TYPE(self),
-        data.bytes_list,
-        automaton->kind,
-        automaton->store,
-        automaton->key_type,
-        automaton->count,
-        automaton->longest_word,
-        data.values
-    );
-
-    if (data.values == Py_None) {
-        data.values = NULL;
-    }
+    LoadBuffer input;
 
-    if (UNLIKELY(tuple == NULL)) {
-        goto exception;
+    if (UNLIKELY(!loadbuffer_open_memory(&input, data, NULL))) {
+        return false;
     }
 
-    // revert all changes
-    trie_traverse(automaton->root, pickle_dump_undo_replace, NULL);
+    input.value_list = values;
 
-    return tuple;
-
-exception:
-    // revert all changes
-    trie_traverse(automaton->root, pickle_dump_undo_replace, NULL);
-
-    // and free memory
-    pickle_data__cleanup(&data);
-    return NULL;
-#undef automaton
+    return automaton_load_impl(automaton, &input);
 }
 
 
@@ -347,6 +183,7 @@ automaton_unpickle(
     size_t j;
     unsigned object_idx = 0;
     size_t index;
+    size_t value_index;
     size_t count;
 
     if (!automaton_unpickle__validate_bytes_list(bytes_list, &count)) {
@@ -425,8 +262,10 @@ automaton_unpickle(
         if (values and node->eow) {
             value = F(PyList_GetItem)(values, object_idx);
             if (value) {
-                Py_INCREF(value);
-                node->output.object = value;
+                if (UNLIKELY(!valuetable_add(&automaton->values, value, &value_index)))
+                    goto no_mem;
+
+                node->output = value_index;
                 object_idx += 1;
             }
             else
@@ -460,6 +299,8 @@ automaton_unpickle(
     }
 
     automaton->root = id2node[1];
+    // depths are not part of the legacy format
+    trie_set_depths(automaton->root);
 
     memory_free(id2node);
     return 1;
@@ -476,13 +317,8 @@ exception:
         memory_free(id2node);
     }
 
-    // If there is value list and some of its items were already
-    // referenced, release them
-    if (values) {
-        for (i=0; i < object_idx; i++) {
-            Py_XDECREF(F(PyList_GetItem)(values, i));
-        }
-    }
+    // release values that were already referenced
+    valuetable_clear(&automaton->values);
 
     return 0;
 }
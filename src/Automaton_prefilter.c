@@ -0,0 +1,375 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Prefilter of searching --- positions where no key can start are
+    skipped while the automaton is in the root state.
+
+    Most letters of a typical text lead from the root back to the
+    root; the prefilter keeps a bitmap of letters leaving the root,
+    thus such letters are skipped with a single test instead of
+    scanning edges of the root.
+
+    When the keys start with relatively few pairs of letters, also
+    a bitmap of these pairs is kept. Then a position is skipped unless
+    the next two letters may start a key, or the letter is a key
+    itself; it's much more selective for small sets of keys.
+
+    When all keys are long, the shift table of Wu-Manber algorithm is
+    built for blocks of three letters; the text is examined at the end of
+    a window as long as the shortest key, and the window is moved by
+    the shift of the block --- most letters are never read.
+
+    Each of these methods is an engine (ENGINE_LETTERS, ENGINE_BIGRAMS
+    and ENGINE_SHIFTS; ENGINE_TRIE doesn't skip anything). Unless
+    make_automaton was given an engine, it's selected from statistics
+    of keys: the length of the shortest key, the number of pairs of
+    first letters and letters leaving the root.
+
+    The prefilter is built lazily, for the current version of the
+    automaton.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+#define automaton_letter_index(letter)  (((letter) & 0xff) >> 3)
+#define automaton_letter_bit(letter)    (1u << ((letter) & 0x07))
+
+#define automaton_bigram_index(first, second) ((((first) & 0xff) << 5) | automaton_letter_index(second))
+
+#define automaton_block_index(first, second, third) \
+    ((((first) & 0x1f) << 11) | (((second) & 0x3f) << 5) | ((third) & 0x1f))
+
+#define automaton_has_letter(bitmap, letter) \
+    ((bitmap)[automaton_letter_index(letter)] & automaton_letter_bit(letter))
+
+#define automaton_has_bigram(bitmap, first, second) \
+    ((bitmap)[automaton_bigram_index(first, second)] & automaton_letter_bit(second))
+
+/* the bitmap of pairs is selected when at most 1/8 of pairs start keys */
+#define AUTOMATON_BIGRAMS_MAX_COUNT (65536 / 8)
+
+/* the shift table is selected when all keys have at least this length */
+#define AUTOMATON_SHIFTS_MIN_LENGTH 8
+
+/* keys are examined up to this length, longer ones don't shift further */
+#define AUTOMATON_SHIFTS_MAX_LENGTH 64
+
+
+static void
+automaton_free_prefilter(Automaton* automaton) {
+
+    memory_safefree(automaton->prefilter.bigrams);
+    memory_safefree(automaton->prefilter.shifts);
+    automaton->prefilter.bigrams = NULL;
+    automaton->prefilter.shifts = NULL;
+    automaton_free_root_table(&automaton->prefilter);
+    automaton_free_alphabet(&automaton->prefilter);
+    automaton_free_cache(&automaton->prefilter);
+    automaton->prefilter.version = -1;
+}
+
+
+static size_t
+automaton_count_bigrams(const Automaton* automaton) {
+
+    size_t count;
+    unsigned i;
+
+    count = 0;
+    for (i=0; i < automaton->root->n; i++) {
+        count += trienode_get_ith_unsafe(automaton->root, i)->n;
+    }
+
+    return count;
+}
+
+
+static bool
+automaton_build_bigrams(Automaton* automaton) {
+
+    AutomatonPrefilter* prefilter = &automaton->prefilter;
+    TRIE_LETTER_TYPE first;
+    TRIE_LETTER_TYPE second;
+    TrieNode* child;
+    unsigned i;
+    unsigned j;
+
+    prefilter->bigrams = (uint8_t*)memory_alloc(AUTOMATON_BIGRAMS_SIZE);
+    if (prefilter->bigrams == NULL) {
+        return false;
+    }
+
+    memset(prefilter->bigrams, 0, AUTOMATON_BIGRAMS_SIZE);
+    for (i=0; i < automaton->root->n; i++) {
+        first = trieletter_get_ith_unsafe(automaton->root, i);
+        child = trienode_get_ith_unsafe(automaton->root, i);
+        for (j=0; j < child->n; j++) {
+            second = trieletter_get_ith_unsafe(child, j);
+            prefilter->bigrams[automaton_bigram_index(first, second)] |= automaton_letter_bit(second);
+        }
+    }
+
+    return true;
+}
+
+
+static int
+automaton_min_length(TrieNode* node, int depth, int best) {
+
+    unsigned i;
+    TrieNode* child;
+
+    if (depth + 1 >= best) {
+        return best;
+    }
+
+    for (i=0; i < node->n; i++) {
+        child = trienode_get_ith_unsafe(node, i);
+        if (child->eow) {
+            return depth + 1;
+        }
+
+        best = automaton_min_length(child, depth + 1, best);
+    }
+
+    return best;
+}
+
+
+static void
+automaton_fill_shifts(uint8_t* shifts, TrieNode* node, TRIE_LETTER_TYPE first, TRIE_LETTER_TYPE second, int depth, int length) {
+
+    // a block ending at the depth-th letter of a key (counting from 0)
+    // gets to the end of window when it's moved by length - depth - 1
+    unsigned i;
+    TRIE_LETTER_TYPE letter;
+    uint8_t* shift;
+
+    for (i=0; i < node->n; i++) {
+        letter = trieletter_get_ith_unsafe(node, i);
+        if (depth > 1) {
+            shift = &shifts[automaton_block_index(first, second, letter)];
+            if (*shift > length - depth - 1) {
+                *shift = length - depth - 1;
+            }
+        }
+
+        if (depth + 1 < length) {
+            automaton_fill_shifts(shifts, trienode_get_ith_unsafe(node, i), second, letter, depth + 1, length);
+        }
+    }
+}
+
+
+static bool
+automaton_build_shifts(Automaton* automaton) {
+
+    AutomatonPrefilter* prefilter = &automaton->prefilter;
+
+    // a window has to hold a block
+    if (prefilter->min_length < 3) {
+        return false;
+    }
+
+    prefilter->shifts = (uint8_t*)memory_alloc(AUTOMATON_SHIFTS_SIZE);
+    if (prefilter->shifts == NULL) {
+        return false;
+    }
+
+    memset(prefilter->shifts, prefilter->min_length - 2, AUTOMATON_SHIFTS_SIZE);
+    automaton_fill_shifts(prefilter->shifts, automaton->root, 0, 0, 0, prefilter->min_length);
+
+    return true;
+}
+
+
+static AutomatonEngine PURE
+automaton_select_engine(const Automaton* automaton, size_t bigrams_count) {
+
+    const AutomatonPrefilter* prefilter = &automaton->prefilter;
+    unsigned i;
+
+    if (prefilter->min_length >= AUTOMATON_SHIFTS_MIN_LENGTH) {
+        return ENGINE_SHIFTS;
+    }
+
+    if (bigrams_count <= AUTOMATON_BIGRAMS_MAX_COUNT) {
+        return ENGINE_BIGRAMS;
+    }
+
+    for (i=0; i < sizeof(prefilter->root_letters); i++) {
+        if (prefilter->root_letters[i] != 0xff) {
+            return ENGINE_LETTERS;
+        }
+    }
+
+    // every letter may leave the root, there's nothing to skip
+    return ENGINE_TRIE;
+}
+
+
+static void
+automaton_update_prefilter(Automaton* automaton) {
+
+    // tables are optional, when memory is low a weaker engine is used
+    AutomatonPrefilter* prefilter = &automaton->prefilter;
+    TRIE_LETTER_TYPE letter;
+    size_t bigrams_count;
+    unsigned i;
+
+    if (prefilter->version == automaton->version) {
+        return;
+    }
+
+    memory_safefree(prefilter->bigrams);
+    memory_safefree(prefilter->shifts);
+    prefilter->bigrams = NULL;
+    prefilter->shifts = NULL;
+    automaton_free_root_table(prefilter);
+    automaton_free_alphabet(prefilter);
+    automaton_free_cache(prefilter);
+    prefilter->min_length = 0;
+    prefilter->engine = ENGINE_TRIE;
+    memset(prefilter->root_letters, 0, sizeof(prefilter->root_letters));
+    memset(prefilter->root_words, 0, sizeof(prefilter->root_words));
+    if (automaton->kind == AHOCORASICK) {
+        for (i=0; i < automaton->root->n; i++) {
+            letter = trieletter_get_ith_unsafe(automaton->root, i);
+            prefilter->root_letters[automaton_letter_index(letter)] |= automaton_letter_bit(letter);
+            if (trienode_get_ith_unsafe(automaton->root, i)->eow) {
+                prefilter->root_words[automaton_letter_index(letter)] |= automaton_letter_bit(letter);
+            }
+        }
+
+        automaton_build_root_table(automaton);
+        automaton_build_alphabet(automaton);
+        automaton_build_cache(automaton);
+
+        prefilter->min_length = automaton_min_length(automaton->root, 0, AUTOMATON_SHIFTS_MAX_LENGTH);
+        bigrams_count = automaton_count_bigrams(automaton);
+
+        prefilter->engine = automaton->engine;
+        if (prefilter->engine == ENGINE_AUTO) {
+            prefilter->engine = automaton_select_engine(automaton, bigrams_count);
+        }
+
+        switch (prefilter->engine) {
+            case ENGINE_SHIFTS:
+                if (automaton_build_shifts(automaton)) {
+                    // candidates are checked with bigrams when they are selective
+                    if (bigrams_count <= AUTOMATON_BIGRAMS_MAX_COUNT) {
+                        automaton_build_bigrams(automaton);
+                    }
+                    break;
+                }
+
+                prefilter->engine = ENGINE_BIGRAMS;
+                /* fall through */
+
+            case ENGINE_BIGRAMS:
+                if (automaton_build_bigrams(automaton)) {
+                    break;
+                }
+
+                prefilter->engine = ENGINE_LETTERS;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    prefilter->version = automaton->version;
+}
+
+
+static Py_ssize_t PURE
+automaton_skip_letters(const AutomatonPrefilter* prefilter, const TRIE_LETTER_TYPE* word, Py_ssize_t index, const Py_ssize_t end) {
+
+    while (index < end and not automaton_has_letter(prefilter->root_letters, word[index])) {
+        index += 1;
+    }
+
+    return index;
+}
+
+
+static Py_ssize_t PURE
+automaton_skip_bigrams(const AutomatonPrefilter* prefilter, const TRIE_LETTER_TYPE* word, Py_ssize_t index, const Py_ssize_t end) {
+
+    while (index + 1 < end
+           and not automaton_has_bigram(prefilter->bigrams, word[index], word[index + 1])
+           and not automaton_has_letter(prefilter->root_words, word[index])) {
+        index += 1;
+    }
+
+    // a key starting at the last letter may continue in the next
+    // chunk of data, see AutomatonSearchIter.set()
+    return automaton_skip_letters(prefilter, word, index, end);
+}
+
+
+static Py_ssize_t PURE
+automaton_skip_shifts(const AutomatonPrefilter* prefilter, const TRIE_LETTER_TYPE* word, Py_ssize_t index, const Py_ssize_t end) {
+
+    Py_ssize_t last;
+    uint8_t shift;
+
+    // a key starting at index has to fit in the window
+    while (index + prefilter->min_length <= end) {
+        last  = index + prefilter->min_length - 1;
+        shift = prefilter->shifts[automaton_block_index(word[last - 2], word[last - 1], word[last])];
+        if (shift == 0) {
+            if (prefilter->bigrams != NULL
+                    ? automaton_has_bigram(prefilter->bigrams, word[index], word[index + 1])
+                    : automaton_has_letter(prefilter->root_letters, word[index])) {
+                return index;
+            }
+
+            shift = 1;
+        }
+
+        index += shift;
+    }
+
+    if (prefilter->bigrams != NULL) {
+        return automaton_skip_bigrams(prefilter, word, index, end);
+    } else {
+        return automaton_skip_letters(prefilter, word, index, end);
+    }
+}
+
+
+static Py_ssize_t PURE
+automaton_skip_root(const Automaton* automaton, const TRIE_LETTER_TYPE* word, Py_ssize_t index, const Py_ssize_t end) {
+
+    // letters sharing the lowest 8 bits share a bit, thus the
+    // automaton still has to check letters at the returned index
+    ASSERT(automaton->prefilter.version == automaton->version);
+
+    switch (automaton->prefilter.engine) {
+        case ENGINE_SHIFTS:
+            return automaton_skip_shifts(&automaton->prefilter, word, index, end);
+
+        case ENGINE_BIGRAMS:
+            return automaton_skip_bigrams(&automaton->prefilter, word, index, end);
+
+        case ENGINE_LETTERS:
+            return automaton_skip_letters(&automaton->prefilter, word, index, end);
+
+        default:
+            return index;
+    }
+}
+
+#undef automaton_letter_index
+#undef automaton_letter_bit
+#undef automaton_bigram_index
+#undef automaton_block_index
+#undef automaton_has_letter
+#undef automaton_has_bigram
+#undef AUTOMATON_BIGRAMS_MAX_COUNT
+#undef AUTOMATON_SHIFTS_MIN_LENGTH
+#undef AUTOMATON_SHIFTS_MAX_LENGTH
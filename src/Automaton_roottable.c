@@ -0,0 +1,161 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Root table --- direct lookup of children of the root.
+
+    Every position of a text that falls back to the root scans edges
+    of the root; in a unicode automaton (e.g. a CJK dictionary) the
+    root can have thousands of edges. When the root has many edges its
+    children are kept in a two-level table indexed by a letter: the
+    dense first level is indexed by the higher bits, pages of the
+    second level by the lowest 8 bits. Pages are allocated only for
+    ranges of letters that leave the root, thus the table is small
+    even for the whole code point space.
+
+    The table is built together with the prefilter, for the current
+    version of the automaton.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+/* the root table is built when the root has at least that many edges */
+#define AUTOMATON_ROOT_TABLE_MIN_EDGES 32
+
+#define automaton_root_page(letter)     ((letter) / AUTOMATON_ROOT_PAGE_SIZE)
+#define automaton_root_index(letter)    ((letter) % AUTOMATON_ROOT_PAGE_SIZE)
+
+
+static void
+automaton_free_root_table(AutomatonPrefilter* prefilter) {
+
+    size_t i;
+
+    if (prefilter->root_table == NULL) {
+        return;
+    }
+
+    for (i=0; i < AUTOMATON_ROOT_PAGES; i++) {
+        memory_safefree(prefilter->root_table[i]);
+    }
+
+    memory_free(prefilter->root_table);
+    prefilter->root_table = NULL;
+    prefilter->root_pages = 0;
+}
+
+
+static bool
+automaton_build_root_table(Automaton* automaton) {
+
+    AutomatonPrefilter* prefilter = &automaton->prefilter;
+    TRIE_LETTER_TYPE letter;
+    TrieNode*** table;
+    TrieNode** page;
+    unsigned i;
+
+    ASSERT(prefilter->root_table == NULL);
+
+    if (automaton->root->n < AUTOMATON_ROOT_TABLE_MIN_EDGES) {
+        return true;
+    }
+
+    table = (TrieNode***)memory_alloc(AUTOMATON_ROOT_PAGES * sizeof(TrieNode**));
+    if (UNLIKELY(table == NULL)) {
+        return false;
+    }
+
+    memset(table, 0, AUTOMATON_ROOT_PAGES * sizeof(TrieNode**));
+    prefilter->root_table = table;
+
+    for (i=0; i < automaton->root->n; i++) {
+        letter = trieletter_get_ith_unsafe(automaton->root, i);
+#if TRIE_LETTER_SIZE == 4
+        if (letter >= AUTOMATON_ROOT_LETTERS) {
+            // integer keys (KEY_SEQUENCE) may be outside the table, they're still found on edges
+            continue;
+        }
+#endif
+
+        page = table[automaton_root_page(letter)];
+        if (page == NULL) {
+            page = (TrieNode**)memory_alloc(AUTOMATON_ROOT_PAGE_SIZE * sizeof(TrieNode*));
+            if (UNLIKELY(page == NULL)) {
+                automaton_free_root_table(prefilter);
+                return false;
+            }
+
+            memset(page, 0, AUTOMATON_ROOT_PAGE_SIZE * sizeof(TrieNode*));
+            table[automaton_root_page(letter)] = page;
+            prefilter->root_pages += 1;
+        }
+
+        page[automaton_root_index(letter)] = trienode_get_ith_unsafe(automaton->root, i);
+    }
+
+    return true;
+}
+
+
+static TrieNode* PURE
+automaton_root_child(const AutomatonPrefilter* prefilter, TrieNode* root, const TRIE_LETTER_TYPE letter) {
+
+    TrieNode** page;
+    TrieNode* child;
+
+#if TRIE_LETTER_SIZE == 4
+    if (prefilter->root_table != NULL and LIKELY(letter < AUTOMATON_ROOT_LETTERS)) {
+#else
+    // a 16-bit letter is always in the table
+    if (prefilter->root_table != NULL) {
+#endif
+        page = prefilter->root_table[automaton_root_page(letter)];
+        if (page != NULL and page[automaton_root_index(letter)] != NULL) {
+            return page[automaton_root_index(letter)];
+        }
+
+        return root;
+    }
+
+    child = trienode_get_next(root, letter);
+    return (child != NULL) ? child : root;
+}
+
+
+static TrieNode* PURE
+automaton_resolve_next(const Automaton* automaton, TrieNode* node, const TRIE_LETTER_TYPE letter) {
+
+    const AutomatonPrefilter* prefilter = &automaton->prefilter;
+    TrieNode* const root = automaton->root;
+    TrieNode* child;
+
+    ASSERT(prefilter->version == automaton->version);
+
+    if (node != root) {
+        child = trienode_get_next(node, letter);
+        if (child != NULL) {
+            return child;
+        }
+
+        // no node has an edge for a letter absent in keys
+        if (prefilter->letter_pages != NULL and automaton_letter_class(prefilter, letter) == 0) {
+            return root;
+        }
+
+        // the root ends each chain of fail links
+        for (node = node->fail; node != root; node = node->fail) {
+            ASSERT(node);
+            child = trienode_get_next(node, letter);
+            if (child != NULL) {
+                return child;
+            }
+        }
+    }
+
+    return automaton_root_child(prefilter, root, letter);
+}
+
+#undef AUTOMATON_ROOT_TABLE_MIN_EDGES
+#undef automaton_root_page
+#undef automaton_root_index
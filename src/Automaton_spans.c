@@ -0,0 +1,179 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Spans of matches --- implementation of iter_spans() and
+    find_all_spans() methods.
+
+    Each node keeps its depth, i.e. the length of a key ending in the
+    node, thus the start of a match is known without looking up
+    the key.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+
+static bool
+automaton_check_spans(Automaton* automaton) {
+
+    // a node of a minimized automaton may be reached by paths of different lengths
+    if (automaton->minimized) {
+        PyErr_SetString(PyExc_AttributeError, "Spans are not available in a minimized automaton.");
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool
+automaton_build_span(Automaton* automaton, TrieNode* node, Py_ssize_t end, size_t payload, PyObject** result) {
+
+    Py_ssize_t start;
+
+    if (UNLIKELY(node->depth == TRIENODE_MAX_DEPTH)) {
+        PyErr_SetString(PyExc_ValueError, "key is too long to find start of its match");
+        return false;
+    }
+
+    start = end - (Py_ssize_t)node->depth + 1;
+
+    switch (automaton->store) {
+        case STORE_LENGTH:
+        case STORE_INTS:
+        case STORE_KEY_ID:
+            *result = F(Py_BuildValue)("nnn", start, end, (Py_ssize_t)node->output);
+            break;
+
+        case STORE_ANY:
+            *result = F(Py_BuildValue)("nnO", start, end, automaton_get_value(automaton, node));
+            break;
+
+        case STORE_BYTES:
+        case STORE_INT64:
+        case STORE_FLOAT:
+            *result = F(Py_BuildValue)("nnN", start, end, automaton_build_value(automaton, node));
+            break;
+
+        case STORE_MULTI_INTS:
+            *result = F(Py_BuildValue)("nnN", start, end, automaton_build_payload(automaton, node, payload));
+            break;
+
+        default:
+            PyErr_SetString(PyExc_ValueError, "inconsistent internal state!");
+            return false;
+    }
+
+    return *result != NULL;
+}
+
+
+static PyObject*
+automaton_iter_spans(PyObject* self, PyObject* args, PyObject* keywds) {
+    return automaton_iter_impl(self, args, keywds, true);
+}
+
+
+static PyObject*
+automaton_find_all_spans(PyObject* self, PyObject* args, PyObject* kwargs) {
+#define automaton ((Automaton*)self)
+
+    struct Input input;
+    Py_ssize_t start;
+    Py_ssize_t end;
+    PyObject* callback;
+    PyObject* callback_ret;
+    PyObject* span;
+    uint64_t mask = 0;
+    bool use_mask;
+
+    Py_ssize_t i;
+    size_t k;
+    size_t count;
+    TrieNode* state;
+    TrieNode* tmp;
+    int version;
+
+    if (automaton->kind != AHOCORASICK)
+        Py_RETURN_NONE;
+
+    if (not automaton_check_spans(automaton)
+        or not automaton_parse_search_mask(automaton, kwargs, &mask, &use_mask)) {
+        return NULL;
+    }
+
+    // arg 1
+    if (!prepare_input_from_tuple(self, args, 0, &input)) {
+        return NULL;
+    }
+
+    // arg 2
+    callback = F(PyTuple_GetItem)(args, 1);
+    if (callback == NULL) {
+        destroy_input(&input);
+        return NULL;
+    }
+    else
+    if (not F(PyCallable_Check)(callback)) {
+        PyErr_SetString(PyExc_TypeError, "The callback argument must be a callable such as a function.");
+        destroy_input(&input);
+        return NULL;
+    }
+
+    // parse start/end
+    if (pymod_parse_start_end(args, 2, 3, 0, input.wordlen, &start, &end)) {
+        destroy_input(&input);
+        return NULL;
+    }
+
+    automaton_update_prefilter(automaton);
+    version = automaton->version;
+
+    state = automaton->root;
+    for (i=start; i < end; i++) {
+        if (state == automaton->root) {
+            i = automaton_skip_root(automaton, input.word, i, end);
+            if (i == end) {
+                break;
+            }
+        }
+
+        state = tmp = automaton_next(automaton, state, input.word[i]);
+        if (use_mask and (automaton_chain_mask(automaton, state) & mask) == 0) {
+            continue;
+        }
+
+        // return output
+        while (tmp) {
+            if (tmp->eow and (not use_mask or (automaton_key_mask(automaton, tmp) & mask) != 0)) {
+                // the callback is called for each integer of STORE_MULTI_INTS
+                count = (automaton->store == STORE_MULTI_INTS) ? automaton_payload_count(automaton, tmp) : 1;
+                for (k=0; k < count; k++) {
+                    if (not automaton_build_span(automaton, tmp, i, k, &span)) {
+                        destroy_input(&input);
+                        return NULL;
+                    }
+
+                    callback_ret = F(PyObject_CallObject)(callback, span);
+                    Py_DECREF(span);
+                    if (callback_ret == NULL) {
+                        destroy_input(&input);
+                        return NULL;
+                    } else
+                        Py_DECREF(callback_ret);
+
+                    if (not automaton_check_callback_version(automaton, version)) {
+                        destroy_input(&input);
+                        return NULL;
+                    }
+                }
+            }
+
+            tmp = tmp->fail;
+        }
+    }
+#undef automaton
+
+    destroy_input(&input);
+    Py_RETURN_NONE;
+}
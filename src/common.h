@@ -54,16 +54,19 @@
         // but we use UCS-4
 #       define TRIE_LETTER_TYPE uint32_t
 #       define TRIE_LETTER_SIZE 4
+#       define TRIE_LETTER_MAX  0x10ffff
 #   else
         // Python use UCS-2
 #       define TRIE_LETTER_TYPE uint16_t
 #       define TRIE_LETTER_SIZE 2
+#       define TRIE_LETTER_MAX  0xffff
 #       define VARIABLE_LEN_CHARCODES 1
 #   endif
 #else
-    // only bytes are supported
+    // only bytes are supported; they're signed chars extended to 16 bits
 #   define TRIE_LETTER_TYPE uint16_t
 #   define TRIE_LETTER_SIZE 2
+#   define TRIE_LETTER_MAX  0xffff
 #endif
 
 #ifdef __GNUC__
@@ -72,12 +75,14 @@
 #   define  ALWAYS_INLINE   __attribute__((always_inline))
 #   define  PURE            __attribute__((pure))
 #   define  UNUSED          __attribute__((unused))
+#   define  PREFETCH(ptr)   __builtin_prefetch(ptr)
 #else
 #   define  LIKELY(x)   x
 #   define  UNLIKELY(x) x
 #   define  ALWAYS_INLINE
 #   define  PURE
 #   define  UNUSED
+#   define  PREFETCH(ptr)
 #endif
 
 #ifdef DEBUG
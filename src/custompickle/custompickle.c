@@ -8,11 +8,19 @@ static const char CUSTOMPICKLE_MAGICK[16] = {
 };
 
 
+static const char CUSTOMPICKLE_MAGICK3[16] = {
+    'p', 'y', 'a', 'h', 'o', 'c', 'o', 'r', 'a', 's', 'i', 'c', 'k',    // signature
+    '0', '0', '3'                                                       // format version
+};
+
+
 void custompickle_initialize_header(CustompickleHeader* header, Automaton* automaton) {
 
     ASSERT(header != NULL);
     ASSERT(automaton != NULL);
 
+    // padding is zeroed, saved data must not depend on garbage
+    memset(header, 0, sizeof(CustompickleHeader));
     memcpy(header->magick, CUSTOMPICKLE_MAGICK, sizeof(CUSTOMPICKLE_MAGICK));
     header->data.kind         = automaton->kind;
     header->data.store        = automaton->store;
@@ -22,6 +30,30 @@ void custompickle_initialize_header(CustompickleHeader* header, Automaton* autom
 }
 
 
+void custompickle_initialize_header3(CustompickleHeader* header, CustompickleHeader3* header3, Automaton* automaton, size_t nodes_count, bool compact, bool values_list) {
+
+    ASSERT(header3 != NULL);
+
+    custompickle_initialize_header(header, automaton);
+    memcpy(header->magick, CUSTOMPICKLE_MAGICK3, sizeof(CUSTOMPICKLE_MAGICK3));
+
+    header3->nodes_count = nodes_count;
+    header3->flags       = automaton->minimized ? CUSTOMPICKLE_FLAG_MINIMIZED : 0;
+    header3->letter_size = sizeof(TRIE_LETTER_TYPE);
+    if (compact) {
+        header3->flags |= CUSTOMPICKLE_FLAG_COMPACT;
+    }
+
+    if (values_list) {
+        header3->flags |= CUSTOMPICKLE_FLAG_VALUES_LIST;
+    }
+
+    if (automaton->key_masks.count > 0) {
+        header3->flags |= CUSTOMPICKLE_FLAG_MASKS;
+    }
+}
+
+
 void custompickle_initialize_footer(CustompickleFooter* footer, size_t nodes_count) {
 
     ASSERT(footer != NULL);
@@ -30,10 +62,25 @@ void custompickle_initialize_footer(CustompickleFooter* footer, size_t nodes_cou
     footer->nodes_count = nodes_count;
 }
 
-int custompickle_validate_header(CustompickleHeader* header) {
-    if (memcmp(header->magick, CUSTOMPICKLE_MAGICK, sizeof(CUSTOMPICKLE_MAGICK)) != 0)
-        return false;
+void custompickle_initialize_footer3(CustompickleFooter* footer, size_t nodes_count) {
+
+    custompickle_initialize_footer(footer, nodes_count);
+    memcpy(footer->magick, CUSTOMPICKLE_MAGICK3, sizeof(CUSTOMPICKLE_MAGICK3));
+}
+
 
+CustompickleVersion custompickle_get_version(CustompickleHeader* header) {
+    if (memcmp(header->magick, CUSTOMPICKLE_MAGICK, sizeof(CUSTOMPICKLE_MAGICK)) == 0)
+        return CUSTOMPICKLE_VERSION2;
+
+    if (memcmp(header->magick, CUSTOMPICKLE_MAGICK3, sizeof(CUSTOMPICKLE_MAGICK3)) == 0)
+        return CUSTOMPICKLE_VERSION3;
+
+    return CUSTOMPICKLE_INVALID;
+}
+
+
+static int custompickle_validate_data(CustompickleHeader* header) {
     if (!check_store(header->data.store))
         return false;
 
@@ -47,6 +94,42 @@ int custompickle_validate_header(CustompickleHeader* header) {
 }
 
 
+int custompickle_validate_header(CustompickleHeader* header) {
+    if (memcmp(header->magick, CUSTOMPICKLE_MAGICK, sizeof(CUSTOMPICKLE_MAGICK)) != 0)
+        return false;
+
+    return custompickle_validate_data(header);
+}
+
+
+int custompickle_validate_header3(CustompickleHeader* header, CustompickleHeader3* header3) {
+    if (memcmp(header->magick, CUSTOMPICKLE_MAGICK3, sizeof(CUSTOMPICKLE_MAGICK3)) != 0)
+        return false;
+
+    if (!custompickle_validate_data(header))
+        return false;
+
+    if (header3->letter_size != sizeof(TRIE_LETTER_TYPE))
+        return false;
+
+    if (header3->flags & ~CUSTOMPICKLE_FLAGS_ALL)
+        return false;
+
+    if (header3->nodes_count > CUSTOMPICKLE_MAX_NODES)
+        return false;
+
+    return (header3->nodes_count == 0) == (header->data.kind == EMPTY);
+}
+
+
 int custompickle_validate_footer(CustompickleFooter* footer) {
     return (memcmp(footer->magick, CUSTOMPICKLE_MAGICK, sizeof(CUSTOMPICKLE_MAGICK)) == 0);
 }
+
+
+int custompickle_validate_footer3(CustompickleFooter* footer, CustompickleHeader3* header3) {
+    if (memcmp(footer->magick, CUSTOMPICKLE_MAGICK3, sizeof(CUSTOMPICKLE_MAGICK3)) != 0)
+        return false;
+
+    return footer->nodes_count == header3->nodes_count;
+}
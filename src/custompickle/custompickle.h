@@ -23,7 +23,102 @@ typedef struct CustompickleFooter {
 } CustompickleFooter;
 
 
+/*
+    Version 3 of the format is position-independent: nodes are stored
+    in BFS order (the root is the first one) and refer to each other
+    by indices.
+
+    CustompickleHeader (CUSTOMPICKLE_MAGICK3)
+    CustompickleHeader3
+    for each node:
+        CustompickleNode
+        CustompickleEdge[n]
+    values (STORE_ANY and the column stores):
+        uint64_t size
+        serialized values or a raw column
+    masks (only when CUSTOMPICKLE_FLAG_MASKS is set):
+        uint64_t[number of nodes having eow set]
+    CustompickleFooter (CUSTOMPICKLE_MAGICK3)
+
+    Values of STORE_ANY are serialized one by one, each one preceded by
+    its uint64_t size; when CUSTOMPICKLE_FLAG_VALUES_LIST is set, they
+    are serialized at once as a list. The k-th value belongs to the k-th
+    node having eow set, the node keeps k as its output.
+
+    Values of the remaining stores are numbered in the same way and
+    written as a raw column: uint64_t[count] for STORE_INT64 and
+    STORE_FLOAT (bits of a double); uint32_t[count] lengths followed
+    by the concatenated byte strings for STORE_BYTES and
+    STORE_MULTI_INTS, where a string is an array of int64_t.
+
+    Category masks of keys are numbered like values; 0 means that
+    a key has no mask.
+
+    When CUSTOMPICKLE_FLAG_COMPACT is set, a node is a sequence of
+    varints (7 bits per byte, little-endian, high bit means "more"):
+
+        (n << 1) | eow
+        fail + 1, 0 means no fail node
+        value (only when eow is set for STORE_INTS and STORE_LENGTH):
+            zigzag-encoded integer
+        n letters, sorted; the first one verbatim, the following ones
+            as differences to the previous letter
+        n child indices (only in a minimized automaton)
+
+    In a plain trie nodes are stored in BFS order visiting children in
+    order of letters, thus children of a node are exactly the next
+    unassigned indices and do not have to be saved.
+*/
+
+#define CUSTOMPICKLE_NO_NODE        ((uint32_t)0xffffffff)
+#define CUSTOMPICKLE_MAX_NODES      ((uint64_t)CUSTOMPICKLE_NO_NODE)
+
+#define CUSTOMPICKLE_FLAG_MINIMIZED 0x0001
+#define CUSTOMPICKLE_FLAG_COMPACT   0x0002
+#define CUSTOMPICKLE_FLAG_MASKS     0x0004
+#define CUSTOMPICKLE_FLAG_VALUES_LIST 0x0008
+#define CUSTOMPICKLE_FLAGS_ALL      (CUSTOMPICKLE_FLAG_MINIMIZED | CUSTOMPICKLE_FLAG_COMPACT | CUSTOMPICKLE_FLAG_MASKS | CUSTOMPICKLE_FLAG_VALUES_LIST)
+
+#define CUSTOMPICKLE_VARINT_MAX_SIZE 10
+
+
+typedef struct CustompickleHeader3 {
+    uint64_t        nodes_count;
+    uint32_t        flags;          // CUSTOMPICKLE_FLAG_*
+    uint32_t        letter_size;    // sizeof(TRIE_LETTER_TYPE)
+} CustompickleHeader3;
+
+
+#pragma pack(push)
+#pragma pack(1)
+typedef struct CustompickleNode {
+    uint64_t        output;         // integer value or size of pickled value
+    uint32_t        fail;           // index of fail node or CUSTOMPICKLE_NO_NODE
+    uint32_t        n;              // number of edges
+    uint8_t         eow;
+} CustompickleNode;
+
+
+typedef struct CustompickleEdge {
+    TRIE_LETTER_TYPE    letter;
+    uint32_t            child;      // index of child node
+} CustompickleEdge;
+#pragma pack(pop)
+
+
+typedef enum {
+    CUSTOMPICKLE_INVALID = 0,
+    CUSTOMPICKLE_VERSION2 = 2,
+    CUSTOMPICKLE_VERSION3 = 3
+} CustompickleVersion;
+
+
 void custompickle_initialize_header(CustompickleHeader* header, Automaton* automaton);
+void custompickle_initialize_header3(CustompickleHeader* header, CustompickleHeader3* header3, Automaton* automaton, size_t nodes_count, bool compact, bool values_list);
 void custompickle_initialize_footer(CustompickleFooter* footer, size_t nodescount);
+void custompickle_initialize_footer3(CustompickleFooter* footer, size_t nodescount);
+CustompickleVersion custompickle_get_version(CustompickleHeader* header);
 int custompickle_validate_header(CustompickleHeader* header);
+int custompickle_validate_header3(CustompickleHeader* header, CustompickleHeader3* header3);
 int custompickle_validate_footer(CustompickleFooter* footer);
+int custompickle_validate_footer3(CustompickleFooter* footer, CustompickleHeader3* header3);
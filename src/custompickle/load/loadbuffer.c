@@ -1,17 +1,32 @@
 #include "loadbuffer.h"
 
 
-int
-loadbuffer_open(LoadBuffer* input, const char* path, PyObject* deserializer) {
-
-    ASSERT(input != NULL);
-    ASSERT(path != NULL);
+static void
+loadbuffer_reset(LoadBuffer* input, PyObject* deserializer) {
 
     input->file         = NULL;
+    input->view.buf     = NULL;
+    input->view.len     = 0;
+    input->position     = 0;
+    input->data_size    = 0;
     input->lookup       = NULL;
     input->size         = 0;
     input->capacity     = 0;
     input->deserializer = deserializer;
+    input->value_list   = NULL;
+    input->values       = NULL;
+}
+
+
+int
+loadbuffer_open(LoadBuffer* input, const char* path, PyObject* deserializer) {
+
+    long size;
+
+    ASSERT(input != NULL);
+    ASSERT(path != NULL);
+
+    loadbuffer_reset(input, deserializer);
 
     input->file = fopen(path, "rb");
     if (UNLIKELY(input->file == NULL)) {
@@ -19,9 +34,44 @@ loadbuffer_open(LoadBuffer* input, const char* path, PyObject* deserializer) {
         return 0;
     }
 
+    // nodes are read in small pieces, a large buffer makes the number
+    // of system calls negligible; it is not an error if it can't be set
+    setvbuf(input->file, NULL, _IOFBF, LOADBUFFER_FILE_BUFFER_SIZE);
+
+    // the size bounds counts read from the data
+    if (UNLIKELY(fseek(input->file, 0, SEEK_END) < 0 || (size = ftell(input->file)) < 0
+                 || fseek(input->file, 0, SEEK_SET) < 0)) {
+        PyErr_SetFromErrno(PyExc_IOError);
+        fclose(input->file);
+        input->file = NULL;
+        return 0;
+    }
+
+    input->data_size = (size_t)size;
+
     return 1;
 }
 
+
+int
+loadbuffer_open_memory(LoadBuffer* input, PyObject* object, PyObject* deserializer) {
+
+    ASSERT(input != NULL);
+    ASSERT(object != NULL);
+
+    loadbuffer_reset(input, deserializer);
+
+    if (UNLIKELY(F(PyObject_GetBuffer)(object, &input->view, PyBUF_SIMPLE) < 0)) {
+        input->view.buf = NULL;
+        return 0;
+    }
+
+    input->data_size = (size_t)input->view.len;
+
+    return 1;
+}
+
+
 int
 loadbuffer_load(LoadBuffer* input, char* buffer, size_t size) {
 
@@ -35,28 +85,138 @@ loadbuffer_load(LoadBuffer* input, char* buffer, size_t size) {
         return 0;
     }
 
+    if (input->file == NULL) {
+        if (UNLIKELY(size > (size_t)input->view.len - input->position)) {
+            PyErr_SetString(PyExc_ValueError, "unexpected end of data");
+            return 0;
+        }
+
+        memcpy(buffer, (const char*)input->view.buf + input->position, size);
+        input->position += size;
+        return 1;
+    }
+
     read = fread(buffer, 1, size, input->file);
     if (read != size) {
         PyErr_SetFromErrno(PyExc_IOError);
         return 0;
     }
 
+    input->position += size;
     return 1;
 }
 
+
 int
-loadbuffer_init(LoadBuffer* input, CustompickleHeader* header, CustompickleFooter* footer) {
+loadbuffer_load_varint(LoadBuffer* input, uint64_t* value) {
+
+    const unsigned char* data;
+    size_t available;
+    size_t i;
+    uint64_t result;
+    int byte;
+
+    ASSERT(input != NULL);
+    ASSERT(value != NULL);
+
+    result = 0;
+    if (input->file == NULL) {
+        data = (const unsigned char*)input->view.buf + input->position;
+        available = (size_t)input->view.len - input->position;
+        for (i=0; i < available && i < CUSTOMPICKLE_VARINT_MAX_SIZE; i++) {
+            result |= (uint64_t)(data[i] & 0x7f) << (7 * i);
+            if ((data[i] & 0x80) == 0) {
+                input->position += i + 1;
+                *value = result;
+                return 1;
+            }
+        }
+    } else {
+        for (i=0; i < CUSTOMPICKLE_VARINT_MAX_SIZE; i++) {
+            byte = getc(input->file);
+            if (UNLIKELY(byte == EOF)) {
+                break;
+            }
+
+            result |= (uint64_t)(byte & 0x7f) << (7 * i);
+            if ((byte & 0x80) == 0) {
+                input->position += i + 1;
+                *value = result;
+                return 1;
+            }
+        }
+    }
+
+    PyErr_SetString(PyExc_ValueError, "malformed or truncated data");
+    return 0;
+}
 
+
+PyObject*
+loadbuffer_load_bytes(LoadBuffer* input, size_t size) {
+
+    PyObject* bytes;
+
+    if (input->file == NULL) {
+        // no need for an intermediate copy
+        if (UNLIKELY(size > (size_t)input->view.len - input->position)) {
+            PyErr_SetString(PyExc_ValueError, "unexpected end of data");
+            return NULL;
+        }
+
+        bytes = F(PyBytes_FromStringAndSize)((const char*)input->view.buf + input->position, size);
+        if (LIKELY(bytes != NULL)) {
+            input->position += size;
+        }
+
+        return bytes;
+    }
+
+    bytes = F(PyBytes_FromStringAndSize)(NULL, size);
+    if (UNLIKELY(bytes == NULL)) {
+        return NULL;
+    }
+
+    if (size > 0 && UNLIKELY(!loadbuffer_load(input, PyBytes_AS_STRING(bytes), size))) {
+        Py_DECREF(bytes);
+        return NULL;
+    }
+
+    return bytes;
+}
+
+
+size_t
+loadbuffer_remaining(LoadBuffer* input) {
+
+    ASSERT(input != NULL);
+
+    if (UNLIKELY(input->position > input->data_size)) {
+        return 0;
+    }
+
+    return input->data_size - input->position;
+}
+
+
+int
+loadbuffer_load_footer(LoadBuffer* input, CustompickleFooter* footer) {
+
+    size_t position;
     long pos;
     int ret;
 
     ASSERT(input != NULL);
-    ASSERT(header != NULL);
     ASSERT(footer != NULL);
 
-    ret = loadbuffer_loadinto(input, header, CustompickleHeader);
-    if (UNLIKELY(!ret)) {
-        return 0;
+    if (input->file == NULL) {
+        if (UNLIKELY((size_t)input->view.len < sizeof(CustompickleFooter))) {
+            PyErr_SetString(PyExc_ValueError, "unexpected end of data");
+            return 0;
+        }
+
+        memcpy(footer, (const char*)input->view.buf + input->view.len - sizeof(CustompickleFooter), sizeof(CustompickleFooter));
+        return 1;
     }
 
     pos = ftell(input->file);
@@ -71,7 +231,9 @@ loadbuffer_init(LoadBuffer* input, CustompickleHeader* header, CustompickleFoote
         return 0;
     }
 
+    position = input->position;
     ret = loadbuffer_loadinto(input, footer, CustompickleFooter);
+    input->position = position;
     if (UNLIKELY(!ret)) {
         return 0;
     }
@@ -82,6 +244,25 @@ loadbuffer_init(LoadBuffer* input, CustompickleHeader* header, CustompickleFoote
         return 0;
     }
 
+    return 1;
+}
+
+
+int
+loadbuffer_init(LoadBuffer* input, CustompickleHeader* header, CustompickleFooter* footer) {
+
+    int ret;
+
+    ASSERT(input != NULL);
+    ASSERT(header != NULL);
+    ASSERT(footer != NULL);
+
+    // header has been already read
+    ret = loadbuffer_load_footer(input, footer);
+    if (UNLIKELY(!ret)) {
+        return 0;
+    }
+
     if (UNLIKELY(!custompickle_validate_header(header))) {
         PyErr_Format(PyExc_ValueError, "invalid header");
         return 0;
@@ -123,14 +304,15 @@ loadbuffer_close(LoadBuffer* input) {
         fclose(input->file);
     }
 
+    if (input->view.buf != NULL) {
+        PyBuffer_Release(&input->view);
+        input->view.buf = NULL;
+    }
+
     if (input->lookup) {
         for (i=0; i < input->size; i++) {
+            // values are kept by the automaton
             node = input->lookup[i].current;
-
-            if (node->eow && input->store == STORE_ANY) {
-                Py_DECREF(node->output.object);
-            }
-
             trienode_free(node);
         }
 
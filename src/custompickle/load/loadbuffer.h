@@ -5,6 +5,8 @@
 #include "../../trienode.h"
 #include "../custompickle.h"
 
+#define LOADBUFFER_FILE_BUFFER_SIZE (1024 * 1024lu)
+
 typedef struct AddressPair {
     TrieNode* original;
     TrieNode* current;
@@ -13,9 +15,15 @@ typedef struct AddressPair {
 
 typedef struct LoadBuffer {
     PyObject*     deserializer;
+    PyObject*     value_list;   ///< if not NULL, values of STORE_ANY are given here rather than in the data
+    ValueTable*   values;       ///< values of the automaton being loaded
     FILE*         file;
+    Py_buffer     view;         ///< memory source (an object supporting the buffer protocol), used when file is NULL
+    size_t        position;     ///< read position in the file or the memory source
+    size_t        data_size;    ///< size of the file or the memory source
     KeysStore     store;
     AutomatonKind kind;
+    uint32_t      letter_max;   ///< the largest letter of keys being loaded
     AddressPair*  lookup;
     size_t        size;
     size_t        capacity;
@@ -24,12 +32,27 @@ typedef struct LoadBuffer {
 int
 loadbuffer_open(LoadBuffer* input, const char* path, PyObject* deserializer);
 
+int
+loadbuffer_open_memory(LoadBuffer* input, PyObject* object, PyObject* deserializer);
+
 int
 loadbuffer_load(LoadBuffer* input, char* output, size_t size);
 
 #define loadbuffer_loadinto(input, variable, type) \
     loadbuffer_load(input, (char*)(variable), sizeof(type))
 
+int
+loadbuffer_load_varint(LoadBuffer* input, uint64_t* value);
+
+PyObject*
+loadbuffer_load_bytes(LoadBuffer* input, size_t size);
+
+size_t
+loadbuffer_remaining(LoadBuffer* input);
+
+int
+loadbuffer_load_footer(LoadBuffer* input, CustompickleFooter* footer);
+
 int
 loadbuffer_init(LoadBuffer* input, CustompickleHeader* header, CustompickleFooter* footer);
 
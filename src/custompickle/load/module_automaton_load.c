@@ -6,13 +6,11 @@
 
 // --- public -----------------------------------------------------------
 
-static bool
-automaton_load_impl(Automaton* automaton, const char* path, PyObject* deserializer);
-
 PyObject*
 module_automaton_load(PyObject* module, PyObject* args) {
 
     SaveLoadParameters params;
+    LoadBuffer input;
     Automaton* automaton;
     int ret;
 
@@ -26,17 +24,907 @@ module_automaton_load(PyObject* module, PyObject* args) {
         return NULL;
     }
 
-    ret = automaton_load_impl(automaton, PyBytes_AsString(params.path), params.callback);
+    ret = loadbuffer_open(&input, PyBytes_AsString(params.path), params.callback);
     Py_DECREF(params.path);
 
-    if (LIKELY(ret))
+    if (LIKELY(ret)) {
+        ret = automaton_load_impl(automaton, &input);
+    }
+
+    if (LIKELY(ret)) {
         return (PyObject*)automaton;
-    else
+    } else {
+        Py_DECREF(automaton);
         return NULL;
+    }
+}
+
+PyObject*
+module_automaton_load_bytes(PyObject* module, PyObject* args) {
+
+    LoadBuffer input;
+    Automaton* automaton;
+    PyObject* data;
+    PyObject* deserializer;
+
+    deserializer = NULL;
+    if (UNLIKELY(!F(PyArg_ParseTuple)(args, "O|O", &data, &deserializer))) {
+        return NULL;
+    }
+
+    // whether values have to be deserialized is known from the header
+    if (UNLIKELY(deserializer != NULL and !F(PyCallable_Check)(deserializer))) {
+        PyErr_SetString(PyExc_TypeError, "the deserializer must be a callable object");
+        return NULL;
+    }
+
+    automaton = (Automaton*)automaton_create();
+    if (UNLIKELY(automaton == NULL)) {
+        return NULL;
+    }
+
+    // nodes are read directly from the caller's buffer
+    if (UNLIKELY(!loadbuffer_open_memory(&input, data, deserializer))) {
+        Py_DECREF(automaton);
+        return NULL;
+    }
+
+    if (LIKELY(automaton_load_impl(automaton, &input))) {
+        return (PyObject*)automaton;
+    } else {
+        Py_DECREF(automaton);
+        return NULL;
+    }
 }
 
 // ----private ----------------------------------------------------------
 
+static bool
+automaton_load_impl2(Automaton* automaton, LoadBuffer* input, CustompickleHeader* header);
+
+static bool
+automaton_load_impl3(Automaton* automaton, LoadBuffer* input, CustompickleHeader* header);
+
+bool
+automaton_load_impl(Automaton* automaton, LoadBuffer* input) {
+
+    CustompickleHeader header;
+    bool ret;
+
+    input->values = &automaton->values;
+    if (!loadbuffer_loadinto(input, &header, CustompickleHeader)) {
+        loadbuffer_close(input);
+        return false;
+    }
+
+    if (UNLIKELY(header.data.store == STORE_ANY and input->deserializer == NULL and input->value_list == NULL)) {
+        PyErr_SetString(PyExc_ValueError, "for automatons with STORE_ANY deserializer must be given");
+        loadbuffer_close(input);
+        return false;
+    }
+
+    switch (custompickle_get_version(&header)) {
+        case CUSTOMPICKLE_VERSION2:
+            ret = automaton_load_impl2(automaton, input, &header);
+            break;
+
+        case CUSTOMPICKLE_VERSION3:
+            ret = automaton_load_impl3(automaton, input, &header);
+            break;
+
+        default:
+            PyErr_Format(PyExc_ValueError, "invalid header");
+            ret = false;
+            break;
+    }
+
+    if (ret) {
+        ret = automaton_prepare_chain_masks(automaton);
+    }
+
+    loadbuffer_close(input);
+    return ret;
+}
+
+
+static void
+automaton_load_setup(Automaton* automaton, CustompickleHeader* header, TrieNode* root) {
+
+    automaton->kind          = header->data.kind;
+    automaton->store         = header->data.store;
+    automaton->key_type      = header->data.key_type;
+    automaton->count         = header->data.words_count;
+    automaton->longest_word  = header->data.longest_word;
+    automaton->version       = 0;
+    automaton->stats.version = -1;
+    automaton->root          = root;
+}
+
+// --- format version 3 -------------------------------------------------
+
+static bool
+automaton_load_node3(LoadBuffer* input, TrieNode* pool, size_t count, size_t index, bool minimized, size_t* next_child, size_t* values_count);
+
+static bool
+automaton_load_node3_compact(LoadBuffer* input, TrieNode* pool, size_t count, size_t index, bool minimized, size_t* next_child, size_t* values_count);
+
+static bool
+automaton_load_values3(LoadBuffer* input, ValueTable* values, size_t values_count, bool values_list);
+
+static PyObject*
+automaton_load_values3_each(LoadBuffer* input, uint64_t size, size_t values_count);
+
+static bool
+automaton_load_column3(LoadBuffer* input, ValueColumn* column, size_t values_count);
+
+static bool
+automaton_load_masks3(LoadBuffer* input, NodeMasks* key_masks, TrieNode* pool, size_t count);
+
+static bool
+automaton_load_longest_path(TrieNode* pool, size_t count, bool minimized, size_t* longest);
+
+static bool
+automaton_load_check_fail(TrieNode* pool, size_t count);
+
+static bool
+automaton_load_impl3(Automaton* automaton, LoadBuffer* input, CustompickleHeader* header) {
+
+    CustompickleHeader3 header3;
+    CustompickleFooter footer;
+    TrieNode* pool;
+    size_t next_child;
+    size_t values_count;
+    size_t words_count;
+    size_t longest;
+    size_t count;
+    size_t i;
+    bool minimized;
+    bool ret;
+
+    if (!loadbuffer_loadinto(input, &header3, CustompickleHeader3)) {
+        return false;
+    }
+
+    if (UNLIKELY(!custompickle_validate_header3(header, &header3))) {
+        PyErr_Format(PyExc_ValueError, "invalid header");
+        return false;
+    }
+
+    if (UNLIKELY(!loadbuffer_load_footer(input, &footer))) {
+        return false;
+    }
+
+    if (UNLIKELY(!custompickle_validate_footer3(&footer, &header3))) {
+        PyErr_Format(PyExc_ValueError, "invalid footer");
+        return false;
+    }
+
+    // len() returns an int
+    if (UNLIKELY(header->data.words_count > INT_MAX)) {
+        PyErr_Format(PyExc_ValueError, "malformed data: %lu keys expected", header->data.words_count);
+        return false;
+    }
+
+    input->store = header->data.store;
+    input->kind  = header->data.kind;
+    // letters of a string must be valid characters
+    input->letter_max = (header->data.key_type == KEY_STRING) ? TRIE_LETTER_MAX : (TRIE_LETTER_TYPE)~0;
+    count        = (size_t)header3.nodes_count;
+    pool         = NULL;
+    minimized    = (header3.flags & CUSTOMPICKLE_FLAG_MINIMIZED) != 0;
+    values_count = 0;
+
+    // each node takes at least one byte
+    if (UNLIKELY(count > loadbuffer_remaining(input))) {
+        PyErr_Format(PyExc_ValueError, "malformed data: %lu nodes expected", count);
+        return false;
+    }
+
+    if (count > 0) {
+        // All nodes are allocated in a single block, the node with index i
+        // is pool[i]. Thus children and fail nodes are known when a node is
+        // read: there's no translation table and no fixups are needed.
+        pool = (TrieNode*)memory_alloc(count * sizeof(TrieNode));
+        if (UNLIKELY(pool == NULL)) {
+            PyErr_NoMemory();
+            return false;
+        }
+
+        memset(pool, 0, count * sizeof(TrieNode));
+
+        next_child = 1;
+        for (i=0; i < count; i++) {
+            if (header3.flags & CUSTOMPICKLE_FLAG_COMPACT) {
+                ret = automaton_load_node3_compact(input, pool, count, i, minimized, &next_child, &values_count);
+            } else {
+                ret = automaton_load_node3(input, pool, count, i, minimized, &next_child, &values_count);
+            }
+
+            if (UNLIKELY(!ret)) {
+                goto exception;
+            }
+        }
+    }
+
+    // iterators keep keys in buffers of the size of the longest word, thus
+    // it's not taken from the header, but recomputed
+    if (UNLIKELY(!automaton_load_longest_path(pool, count, minimized, &longest))) {
+        goto exception;
+    }
+
+    if (UNLIKELY(longest > INT_MAX)) {
+        PyErr_SetString(PyExc_ValueError, "malformed data: keys are too long");
+        goto exception;
+    }
+
+    if (minimized and header->data.kind == AHOCORASICK and UNLIKELY(!automaton_load_check_fail(pool, count))) {
+        goto exception;
+    }
+
+    // each key ends at its own node, only a minimized automaton shares them
+    words_count = 0;
+    for (i=0; i < count; i++) {
+        words_count += pool[i].eow;
+    }
+
+    if (UNLIKELY(minimized ? (words_count > header->data.words_count or (words_count == 0) != (header->data.words_count == 0))
+                           : (words_count != header->data.words_count))) {
+        PyErr_Format(PyExc_ValueError, "malformed data: %lu keys expected, %lu found", header->data.words_count, words_count);
+        goto exception;
+    }
+
+    // values are released along with the automaton in case of error
+    if (input->store == STORE_ANY and UNLIKELY(!automaton_load_values3(input, &automaton->values, values_count, header3.flags & CUSTOMPICKLE_FLAG_VALUES_LIST))) {
+        goto exception;
+    }
+
+    if (store_is_column(input->store) and UNLIKELY(!automaton_load_column3(input, &automaton->column, values_count))) {
+        goto exception;
+    }
+
+    // masks are released along with the automaton in case of error
+    if ((header3.flags & CUSTOMPICKLE_FLAG_MASKS) and UNLIKELY(!automaton_load_masks3(input, &automaton->key_masks, pool, count))) {
+        goto exception;
+    }
+
+    automaton_load_setup(automaton, header, pool);
+    automaton->longest_word = (int)longest;
+    automaton->pool      = pool;
+    automaton->pool_size = count;
+    automaton->minimized = minimized;
+
+    return true;
+
+exception:
+    for (i=0; i < count; i++) {
+        if (pool[i].n > 0) {
+            memory_free(pool[i].next);
+        }
+    }
+
+    memory_safefree(pool);
+    return false;
+}
+
+
+static bool
+automaton_load_values3(LoadBuffer* input, ValueTable* values, size_t values_count, bool values_list) {
+
+    PyObject* bytes;
+    PyObject* list;
+    uint64_t size;
+    size_t index;
+    Py_ssize_t i;
+
+    if (input->value_list != NULL) {
+        list = input->value_list;
+        Py_INCREF(list);
+    } else {
+        if (UNLIKELY(!loadbuffer_loadinto(input, &size, uint64_t))) {
+            return false;
+        }
+
+        // the size is checked before the bytes object is allocated
+        if (UNLIKELY(size > loadbuffer_remaining(input))) {
+            PyErr_SetString(PyExc_ValueError, "malformed values");
+            return false;
+        }
+
+        if (values_list) {
+            bytes = loadbuffer_load_bytes(input, (size_t)size);
+            if (UNLIKELY(bytes == NULL)) {
+                return false;
+            }
+
+            list = F(PyObject_CallFunctionObjArgs)(input->deserializer, bytes, NULL);
+            Py_DECREF(bytes);
+        } else {
+            list = automaton_load_values3_each(input, size, values_count);
+        }
+
+        if (UNLIKELY(list == NULL)) {
+            return false;
+        }
+    }
+
+    if (UNLIKELY(!F(PyList_Check)(list) or (size_t)PyList_GET_SIZE(list) != values_count)) {
+        if (input->value_list != NULL) {
+            PyErr_Format(PyExc_ValueError, "expected a list of %lu values", values_count);
+        } else {
+            PyErr_Format(PyExc_ValueError, "deserializer must return a list of %lu values", values_count);
+        }
+
+        Py_DECREF(list);
+        return false;
+    }
+
+    if (UNLIKELY(!valuetable_reserve(values, values_count))) {
+        Py_DECREF(list);
+        PyErr_NoMemory();
+        return false;
+    }
+
+    // the table is empty, thus the k-th value gets index k
+    for (i=0; i < PyList_GET_SIZE(list); i++) {
+        if (UNLIKELY(!valuetable_add(values, PyList_GET_ITEM(list, i), &index))) {
+            Py_DECREF(list);
+            PyErr_NoMemory();
+            return false;
+        }
+
+        ASSERT(index == (size_t)i);
+    }
+
+    Py_DECREF(list);
+    return true;
+}
+
+
+static PyObject*
+automaton_load_values3_each(LoadBuffer* input, uint64_t size, size_t values_count) {
+
+    // each value is preceded by its size, all of them take size bytes
+    PyObject* list;
+    PyObject* bytes;
+    PyObject* value;
+    uint64_t value_size;
+    size_t i;
+
+    list = F(PyList_New)(0);
+    if (UNLIKELY(list == NULL)) {
+        return NULL;
+    }
+
+    for (i=0; i < values_count; i++) {
+        if (UNLIKELY(size < sizeof(uint64_t))) {
+            goto malformed;
+        }
+
+        if (UNLIKELY(!loadbuffer_loadinto(input, &value_size, uint64_t))) {
+            goto exception;
+        }
+
+        size -= sizeof(uint64_t);
+        if (UNLIKELY(value_size > size)) {
+            goto malformed;
+        }
+
+        size -= value_size;
+        bytes = loadbuffer_load_bytes(input, (size_t)value_size);
+        if (UNLIKELY(bytes == NULL)) {
+            goto exception;
+        }
+
+        value = F(PyObject_CallFunctionObjArgs)(input->deserializer, bytes, NULL);
+        Py_DECREF(bytes);
+        if (UNLIKELY(value == NULL)) {
+            goto exception;
+        }
+
+        if (UNLIKELY(F(PyList_Append)(list, value) < 0)) {
+            Py_DECREF(value);
+            goto exception;
+        }
+
+        Py_DECREF(value);
+    }
+
+    if (UNLIKELY(size != 0)) {
+        goto malformed;
+    }
+
+    return list;
+
+malformed:
+    PyErr_SetString(PyExc_ValueError, "malformed values");
+
+exception:
+    Py_DECREF(list);
+    return NULL;
+}
+
+
+static bool
+automaton_load_column3(LoadBuffer* input, ValueColumn* column, size_t values_count) {
+
+    uint64_t size;
+    uint64_t length;
+    size_t i;
+
+    if (UNLIKELY(!loadbuffer_loadinto(input, &size, uint64_t))) {
+        return false;
+    }
+
+    // the column is empty, thus the k-th value gets index k
+    valuecolumn_init(column, store_column_is_bytes(input->store));
+
+    // the size is checked before the column is allocated
+    if (UNLIKELY(size > loadbuffer_remaining(input))) {
+        goto malformed;
+    }
+
+    if (column->bytes) {
+        if (UNLIKELY(size < (uint64_t)values_count * sizeof(uint32_t))) {
+            goto malformed;
+        }
+
+        length = size - (uint64_t)values_count * sizeof(uint32_t);
+    } else {
+        if (UNLIKELY(size != (uint64_t)values_count * sizeof(uint64_t))) {
+            goto malformed;
+        }
+
+        length = 0;
+    }
+
+    if (values_count == 0) {
+        if (UNLIKELY(length != 0)) {
+            goto malformed;
+        }
+
+        return true;
+    }
+
+    if (UNLIKELY((size_t)length != length or !valuecolumn_reserve(column, values_count, (size_t)length))) {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    if (not column->bytes) {
+        if (UNLIKELY(!loadbuffer_load(input, (char*)column->items, values_count * sizeof(uint64_t)))) {
+            return false;
+        }
+    } else {
+        if (UNLIKELY(!loadbuffer_load(input, (char*)column->lengths, values_count * sizeof(uint32_t)))) {
+            return false;
+        }
+
+        // byte strings are stored one after another
+        size = 0;
+        for (i=0; i < values_count; i++) {
+            if (UNLIKELY(column->lengths[i] > length - size)) {
+                goto malformed;
+            }
+
+            // a key has at least one integer (STORE_MULTI_INTS)
+            if (input->store == STORE_MULTI_INTS and UNLIKELY(column->lengths[i] == 0 or column->lengths[i] % sizeof(int64_t) != 0)) {
+                goto malformed;
+            }
+
+            column->items[i] = size;
+            size += column->lengths[i];
+        }
+
+        if (UNLIKELY(size != length)) {
+            goto malformed;
+        }
+
+        if (length > 0 and UNLIKELY(!loadbuffer_load(input, column->data, (size_t)length))) {
+            return false;
+        }
+
+        column->data_size = (size_t)length;
+    }
+
+    column->size  = values_count;
+    column->count = values_count;
+
+    return true;
+
+malformed:
+    PyErr_SetString(PyExc_ValueError, "malformed values");
+    return false;
+}
+
+
+static bool
+automaton_load_masks3(LoadBuffer* input, NodeMasks* key_masks, TrieNode* pool, size_t count) {
+
+    // the k-th mask belongs to the k-th terminating node, 0 means no mask
+    uint64_t* key_mask;
+    uint64_t mask;
+    size_t i;
+
+    for (i=0; i < count; i++) {
+        if (not pool[i].eow) {
+            continue;
+        }
+
+        if (UNLIKELY(!loadbuffer_loadinto(input, &mask, uint64_t))) {
+            return false;
+        }
+
+        if (mask != 0) {
+            key_mask = nodemasks_put(key_masks, &pool[i]);
+            if (UNLIKELY(key_mask == NULL)) {
+                PyErr_NoMemory();
+                return false;
+            }
+
+            *key_mask = mask;
+        }
+    }
+
+    return true;
+}
+
+
+static bool
+automaton_load_longest_path(TrieNode* pool, size_t count, bool minimized, size_t* longest) {
+
+    // Nodes are visited in topological order and lengths of paths are
+    // propagated to children. Children of a plain trie follow their parents,
+    // thus the order of nodes is topological. Nodes of a minimized automaton
+    // are sorted with Kahn's algorithm: nodes are removed along with their
+    // edges once no edge enters them; nodes left belong to a cycle or are
+    // reachable from one. Only the root may have no incoming edges, other
+    // such nodes are never visited by a search.
+    size_t* length;
+    size_t* incoming;
+    size_t* queue;
+    size_t orphan;
+    size_t child;
+    size_t head;
+    size_t tail;
+    size_t i;
+    unsigned j;
+
+    *longest = 0;
+    if (count == 0) {
+        return true;
+    }
+
+    length = (size_t*)memory_alloc((minimized ? 3 : 2) * count * sizeof(size_t));
+    if (UNLIKELY(length == NULL)) {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    memset(length, 0, 2 * count * sizeof(size_t));
+    incoming = length + count;
+    queue    = incoming + count;
+    for (i=0; i < count; i++) {
+        for (j=0; j < pool[i].n; j++) {
+            incoming[(size_t)(pool[i].next[j].child - pool)] += 1;
+        }
+    }
+
+    orphan = 0;
+    tail   = minimized ? 0 : count;
+    for (i=0; i < count; i++) {
+        if (incoming[i] == 0) {
+            if (i > 0 and orphan == 0) {
+                orphan = i;
+            }
+
+            if (minimized) {
+                queue[tail++] = i;
+            }
+        }
+    }
+
+    for (head=0; head < tail; head++) {
+        i = minimized ? queue[head] : head;
+        if (length[i] > *longest) {
+            *longest = length[i];
+        }
+
+        for (j=0; j < pool[i].n; j++) {
+            child = (size_t)(pool[i].next[j].child - pool);
+            if (length[child] < length[i] + 1) {
+                length[child] = length[i] + 1;
+            }
+
+            if (minimized) {
+                incoming[child] -= 1;
+                if (incoming[child] == 0) {
+                    queue[tail++] = child;
+                }
+            }
+        }
+    }
+
+    memory_free(length);
+    if (UNLIKELY(tail != count)) {
+        PyErr_SetString(PyExc_ValueError, "malformed data: edges form a cycle");
+        return false;
+    }
+
+    if (UNLIKELY(orphan != 0)) {
+        PyErr_Format(PyExc_ValueError, "malformed data: node %lu is not reachable from the root", orphan);
+        return false;
+    }
+
+    return true;
+}
+
+
+static bool
+automaton_load_check_fail(TrieNode* pool, size_t count) {
+
+    // Fail links of a minimized automaton may point to any node, thus each
+    // chain is followed until a node known to reach the root; nodes on the
+    // current chain are marked, meeting such a node again means a cycle.
+    uint8_t* state; // 0 - not visited, 1 - on the current chain, 2 - reaches the root
+    size_t node;
+    size_t i;
+
+    if (UNLIKELY(pool[0].fail != NULL)) {
+        goto malformed;
+    }
+
+    state = (uint8_t*)memory_alloc(count);
+    if (UNLIKELY(state == NULL)) {
+        PyErr_NoMemory();
+        return false;
+    }
+
+    memset(state, 0, count);
+    state[0] = 2;
+    for (i=1; i < count; i++) {
+        for (node = i; state[node] == 0; node = (size_t)(pool[node].fail - pool)) {
+            if (UNLIKELY(pool[node].fail == NULL)) {
+                memory_free(state);
+                goto malformed;
+            }
+
+            state[node] = 1;
+        }
+
+        if (UNLIKELY(state[node] == 1)) {
+            memory_free(state);
+            goto malformed;
+        }
+
+        for (node = i; state[node] == 1; node = (size_t)(pool[node].fail - pool)) {
+            state[node] = 2;
+        }
+    }
+
+    memory_free(state);
+    return true;
+
+malformed:
+    PyErr_SetString(PyExc_ValueError, "malformed data: fail links don't lead to the root");
+    return false;
+}
+
+
+static bool
+automaton_load_node3(LoadBuffer* input, TrieNode* pool, size_t count, size_t index, bool minimized, size_t* next_child, size_t* values_count) {
+
+    CustompickleNode record;
+    CustompickleEdge edge;
+    TrieNode* node;
+    Pair* next;
+    char* tail;
+    size_t i;
+
+    node = &pool[index];
+
+    if (UNLIKELY(!loadbuffer_loadinto(input, &record, CustompickleNode))) {
+        return false;
+    }
+
+    // searching follows fail links down to the root: in a plain trie stored
+    // in BFS order a fail node is shallower, thus it precedes the node
+    if (input->kind == AHOCORASICK and !minimized and UNLIKELY(index == 0 ? record.fail != CUSTOMPICKLE_NO_NODE : record.fail >= index)) {
+        goto malformed;
+    }
+
+    if (record.fail != CUSTOMPICKLE_NO_NODE) {
+        if (UNLIKELY(record.fail >= count)) {
+            goto malformed;
+        }
+
+        node->fail = &pool[record.fail];
+    }
+
+    // 1. load edges; the number is checked before the allocation
+    if (record.n > 0) {
+        if (UNLIKELY(record.n >= count or (size_t)record.n * sizeof(CustompickleEdge) > loadbuffer_remaining(input))) {
+            goto malformed;
+        }
+
+        next = (Pair*)memory_alloc(record.n * sizeof(Pair));
+        if (UNLIKELY(next == NULL)) {
+            PyErr_NoMemory();
+            return false;
+        }
+
+        // Edges are read in one go into the tail of the array and then
+        // expanded in place, front to back: a Pair is larger than an edge,
+        // thus the i-th pair never overwrites edges not converted yet.
+        tail = (char*)next + record.n * (sizeof(Pair) - sizeof(CustompickleEdge));
+        if (UNLIKELY(!loadbuffer_load(input, tail, record.n * sizeof(CustompickleEdge)))) {
+            memory_free(next);
+            return false;
+        }
+
+        for (i=0; i < record.n; i++) {
+            memcpy(&edge, tail + i * sizeof(CustompickleEdge), sizeof(CustompickleEdge));
+            // the root is never a child; a plain trie is stored in BFS order,
+            // thus its children are the next unassigned indices, following
+            // the parent
+            if (UNLIKELY(edge.child >= count or edge.child == 0 or (!minimized and (edge.child != *next_child or edge.child <= index)) or edge.letter > input->letter_max)) {
+                memory_free(next);
+                goto malformed;
+            }
+
+            if (!minimized) {
+                *next_child += 1;
+            }
+
+            next[i].letter = edge.letter;
+            next[i].child  = &pool[edge.child];
+            // a parent precedes its children, thus its depth is already known
+            if (!minimized) {
+                next[i].child->depth = trienode_child_depth(node);
+            }
+        }
+
+        node->next = next;
+        node->n    = record.n;
+    }
+
+    // 2. values kept in a table or a column are numbered in order of nodes
+    if (record.eow && store_has_index(input->store)) {
+        if (UNLIKELY(record.output != *values_count)) {
+            goto malformed;
+        }
+
+        *values_count += 1;
+    }
+
+    node->output = (Py_uintptr_t)record.output;
+    node->eow    = record.eow;
+
+    return true;
+
+malformed:
+    PyErr_Format(PyExc_ValueError, "Detected malformed pointer during unpickling node %lu", index);
+    return false;
+}
+
+
+static bool
+automaton_load_node3_compact(LoadBuffer* input, TrieNode* pool, size_t count, size_t index, bool minimized, size_t* next_child, size_t* values_count) {
+
+    TrieNode* node;
+    Pair* next;
+    uint64_t header;
+    uint64_t fail;
+    uint64_t value;
+    uint64_t letter;
+    uint64_t delta;
+    uint64_t child;
+    size_t n;
+    size_t i;
+
+    node  = &pool[index];
+    value = 0;
+
+    if (UNLIKELY(!loadbuffer_load_varint(input, &header) or !loadbuffer_load_varint(input, &fail))) {
+        return false;
+    }
+
+    n = (size_t)(header >> 1);
+    if (UNLIKELY((header >> 1) > count)) {
+        goto malformed;
+    }
+
+    // fail links of a plain trie point to preceding nodes, as above
+    if (input->kind == AHOCORASICK and !minimized and UNLIKELY(index == 0 ? fail != 0 : (fail == 0 or fail > index))) {
+        goto malformed;
+    }
+
+    if (fail != 0) {
+        if (UNLIKELY(fail > count)) {
+            goto malformed;
+        }
+
+        node->fail = &pool[fail - 1];
+    }
+
+    if ((header & 1) and !store_has_index(input->store) and UNLIKELY(!loadbuffer_load_varint(input, &value))) {
+        return false;
+    }
+
+    // 1. load edges: letters are strictly increasing, children of a plain
+    //    trie are the next unassigned indices
+    if (n > 0) {
+        // each edge takes at least one byte; children follow their parent
+        if (UNLIKELY((!minimized and (n > count - *next_child or *next_child <= index)) or n > loadbuffer_remaining(input))) {
+            goto malformed;
+        }
+
+        next = (Pair*)memory_alloc(n * sizeof(Pair));
+        if (UNLIKELY(next == NULL)) {
+            PyErr_NoMemory();
+            return false;
+        }
+
+        letter = 0;
+        for (i=0; i < n; i++) {
+            if (UNLIKELY(!loadbuffer_load_varint(input, &delta))) {
+                memory_free(next);
+                return false;
+            }
+
+            if (UNLIKELY((i > 0 and delta == 0) or delta > input->letter_max - letter)) {
+                memory_free(next);
+                goto malformed;
+            }
+
+            letter += delta;
+            next[i].letter = (TRIE_LETTER_TYPE)letter;
+        }
+
+        for (i=0; i < n; i++) {
+            if (minimized) {
+                if (UNLIKELY(!loadbuffer_load_varint(input, &child))) {
+                    memory_free(next);
+                    return false;
+                }
+
+                // the root is never a child
+                if (UNLIKELY(child >= count or child == 0)) {
+                    memory_free(next);
+                    goto malformed;
+                }
+            } else {
+                child = *next_child;
+                *next_child += 1;
+                pool[child].depth = trienode_child_depth(node);
+            }
+
+            next[i].child = &pool[child];
+        }
+
+        node->next = next;
+        node->n    = n;
+    }
+
+    // 2. values kept in a table or a column are numbered implicitly
+    if ((header & 1) && store_has_index(input->store)) {
+        node->output = *values_count;
+        *values_count += 1;
+    } else {
+        // undo zigzag encoding
+        node->output = (Py_uintptr_t)((value >> 1) ^ (0 - (value & 1)));
+    }
+
+    node->eow = (uint8_t)(header & 1);
+
+    return true;
+
+malformed:
+    PyErr_Format(PyExc_ValueError, "Detected malformed pointer during unpickling node %lu", index);
+    return false;
+}
+
+// --- format version 2 -------------------------------------------------
+
 static bool
 automaton_load_node(LoadBuffer* input);
 
@@ -44,59 +932,48 @@ static TrieNode*
 automaton_load_fixup_pointers(LoadBuffer* input);
 
 static bool
-automaton_load_impl(Automaton* automaton, const char* path, PyObject* deserializer) {
+automaton_load_impl2(Automaton* automaton, LoadBuffer* input, CustompickleHeader* header) {
 
     TrieNode* root;
-    LoadBuffer input;
-    CustompickleHeader header;
     CustompickleFooter footer;
     size_t i;
 
-    if (!loadbuffer_open(&input, path, deserializer)) {
+    // native value columns exist only in the format version 3
+    if (UNLIKELY(store_is_column(header->data.store))) {
+        PyErr_Format(PyExc_ValueError, "invalid header");
         return false;
     }
 
-    if (!loadbuffer_init(&input, &header, &footer)) {
-        goto exception;
+    if (!loadbuffer_init(input, header, &footer)) {
+        return false;
     }
 
-    if (header.data.kind == TRIE || header.data.kind == AHOCORASICK) {
-        for (i=0; i < input.capacity; i++) {
-            if (UNLIKELY(!automaton_load_node(&input))) {
-                goto exception;
+    if (header->data.kind == TRIE || header->data.kind == AHOCORASICK) {
+        for (i=0; i < input->capacity; i++) {
+            if (UNLIKELY(!automaton_load_node(input))) {
+                return false;
             }
         }
 
-        root = automaton_load_fixup_pointers(&input);
+        root = automaton_load_fixup_pointers(input);
         if (UNLIKELY(root == NULL)) {
-            goto exception;
+            return false;
         }
-    } else if (header.data.kind == EMPTY) {
+
+        // depths are not part of the format version 2
+        trie_set_depths(root);
+    } else if (header->data.kind == EMPTY) {
 
         root = NULL;
 
     } else {
         PyErr_SetString(PyExc_ValueError, "automaton kind save in file is invalid");
-        goto exception;
+        return false;
     }
 
-    loadbuffer_close(&input);
-
-    // setup object
-    automaton->kind          = header.data.kind;
-    automaton->store         = header.data.store;
-    automaton->key_type      = header.data.key_type;
-    automaton->count         = header.data.words_count;
-    automaton->longest_word  = header.data.longest_word;
-    automaton->version       = 0;
-    automaton->stats.version = -1;
-    automaton->root          = root;
+    automaton_load_setup(automaton, header, root);
 
     return true;
-
-exception:
-    loadbuffer_close(&input);
-    return false;
 }
 
 static bool
@@ -107,6 +984,7 @@ automaton_load_node(LoadBuffer* input) {
     TrieNode* original;
     TrieNode* node;
     size_t size;
+    size_t index;
     int ret;
 
     // 1. get original address of upcoming node
@@ -147,7 +1025,7 @@ automaton_load_node(LoadBuffer* input) {
 
     // 4. load custom python object
     if (node->eow && input->store == STORE_ANY) {
-        size = (size_t)(node->output.integer);
+        size = (size_t)(node->output);
         bytes = F(PyBytes_FromStringAndSize)(NULL, size);
         if (UNLIKELY(bytes == NULL)) {
             goto exception;
@@ -160,13 +1038,19 @@ automaton_load_node(LoadBuffer* input) {
         }
 
         object = F(PyObject_CallFunction)(input->deserializer, "O", bytes);
+        Py_DECREF(bytes);
         if (UNLIKELY(object == NULL)) {
-            Py_DECREF(bytes);
             goto exception;
         }
 
-        node->output.object = object;
-        Py_DECREF(bytes);
+        ret = valuetable_add(input->values, object, &index);
+        Py_DECREF(object);
+        if (UNLIKELY(!ret)) {
+            PyErr_NoMemory();
+            goto exception;
+        }
+
+        node->output = index;
     }
 
     input->lookup[input->size].original = original;
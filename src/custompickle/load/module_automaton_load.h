@@ -1,7 +1,16 @@
 #pragma once
 
+#include "loadbuffer.h"
+
 #define module_automaton_load_doc \
 	"Load automaton from a file"
 
 PyObject*
 module_automaton_load(PyObject* module, PyObject* args);
+
+PyObject*
+module_automaton_load_bytes(PyObject* module, PyObject* args);
+
+/* Load automaton from the opened input, the input is closed. */
+bool
+automaton_load_impl(Automaton* automaton, LoadBuffer* input);
@@ -59,3 +59,45 @@ automaton_save_load_parse_args(KeysStore store, PyObject* args, SaveLoadParamete
     return true;
 }
 
+
+
+bool
+automaton_parse_save_kwargs(PyObject* kwargs, int* compact, int* values_list) {
+
+    PyObject* flag;
+    Py_ssize_t found;
+
+    *compact = 0;
+    *values_list = 0;
+    if (kwargs == NULL || PyDict_Size(kwargs) == 0) {
+        return true;
+    }
+
+    found = 0;
+    flag = F(PyDict_GetItemString)(kwargs, "compact");
+    if (flag != NULL) {
+        *compact = F(PyObject_IsTrue)(flag);
+        if (*compact < 0) {
+            return false;
+        }
+
+        found += 1;
+    }
+
+    flag = F(PyDict_GetItemString)(kwargs, "values_list");
+    if (flag != NULL) {
+        *values_list = F(PyObject_IsTrue)(flag);
+        if (*values_list < 0) {
+            return false;
+        }
+
+        found += 1;
+    }
+
+    if (found != PyDict_Size(kwargs)) {
+        PyErr_SetString(PyExc_TypeError, "the only keyword arguments accepted are compact and values_list");
+        return false;
+    }
+
+    return true;
+}
@@ -8,3 +8,6 @@ typedef struct SaveLoadParameters {
 bool 
 automaton_save_load_parse_args(KeysStore store, PyObject* args, SaveLoadParameters* result);
 
+
+bool
+automaton_parse_save_kwargs(PyObject* kwargs, int* compact, int* values_list);
@@ -2,28 +2,35 @@
 
 #include "../custompickle.h"
 #include "../pyhelpers.h"
+#include "../../nodemap.h"
 #include "savebuffer.h"
 
 
 // --- public -----------------------------------------------------------
 
 static bool
-automaton_save_impl(Automaton* automaton, const char* path, PyObject* serializer);
+automaton_save_impl(Automaton* automaton, const char* path, PyObject* serializer, bool compact, bool values_list);
 
 PyObject*
-automaton_save(PyObject* self, PyObject* args) {
+automaton_save(PyObject* self, PyObject* args, PyObject* kwargs) {
 
     SaveLoadParameters params;
     Automaton* automaton;
+    int compact;
+    int values_list;
     int ret;
 
     automaton = (Automaton*)self;
 
+    if (UNLIKELY(!automaton_parse_save_kwargs(kwargs, &compact, &values_list))) {
+        return NULL;
+    }
+
     if (UNLIKELY(!automaton_save_load_parse_args(automaton->store, args, &params))) {
         return NULL;
     }
 
-    ret = automaton_save_impl(automaton, PyBytes_AsString(params.path), params.callback);
+    ret = automaton_save_impl(automaton, PyBytes_AsString(params.path), params.callback, compact, values_list);
     Py_DECREF(params.path);
 
     if (LIKELY(ret))
@@ -32,107 +39,553 @@ automaton_save(PyObject* self, PyObject* args) {
         return NULL;
 }
 
-// --- private ----------------------------------------------------------
+PyObject*
+automaton_save_bytes(PyObject* self, PyObject* args, PyObject* kwargs) {
+
+    SaveBuffer output;
+    Automaton* automaton;
+    PyObject* serializer;
+    int compact;
+    int values_list;
+
+    automaton = (Automaton*)self;
+    serializer = NULL;
+
+    if (UNLIKELY(!automaton_parse_save_kwargs(kwargs, &compact, &values_list))) {
+        return NULL;
+    }
+
+    if (UNLIKELY(!F(PyArg_ParseTuple)(args, "|O", &serializer))) {
+        return NULL;
+    }
+
+    if (UNLIKELY(automaton->store == STORE_ANY and serializer == NULL)) {
+        PyErr_SetString(PyExc_ValueError, "for automatons with STORE_ANY serializer must be given");
+        return NULL;
+    }
+
+    if (UNLIKELY(serializer != NULL and !F(PyCallable_Check)(serializer))) {
+        PyErr_SetString(PyExc_TypeError, "the serializer must be a callable object");
+        return NULL;
+    }
+
+    // the size of plain format is reserved once nodes are counted
+    if (UNLIKELY(!savebuffer_init_memory(&output, serializer, automaton->store, compact ? SAVEBUFFER_DEFAULT_SIZE : 0))) {
+        return NULL;
+    }
+
+    if (UNLIKELY(!automaton_save_to_buffer(automaton, &output, compact, values_list, NULL))) {
+        savebuffer_finalize(&output);
+        return NULL;
+    }
 
-static int
-automaton_save_node(TrieNode* node, const int depth, void* extra);
+    return savebuffer_finalize_memory(&output);
+}
 
 static bool
-automaton_save_impl(Automaton* automaton, const char* path, PyObject* serializer) {
-
-    CustompickleHeader header;
-    CustompickleFooter footer;
-    SaveBuffer         output;
-    int                ret;
-
-    ret = savebuffer_init(&output,
-                          serializer,
-                          automaton->store,
-                          path,
-                          SAVEBUFFER_DEFAULT_SIZE);
-    if (!ret)
+automaton_save_impl(Automaton* automaton, const char* path, PyObject* serializer, bool compact, bool values_list) {
+
+    SaveBuffer output;
+    bool ret;
+
+    if (!savebuffer_init(&output, serializer, automaton->store, path, SAVEBUFFER_DEFAULT_SIZE)) {
         return false;
+    }
+
+    ret = automaton_save_to_buffer(automaton, &output, compact, values_list, NULL);
+    savebuffer_finalize(&output);
+
+    return ret and PyErr_Occurred() == NULL;
+}
+
+// --- private ----------------------------------------------------------
+
+static PyObject*
+automaton_save_values(Automaton* automaton, TrieNode** nodes, size_t count);
+
+static PyObject*
+automaton_save_serialize_each(PyObject* serializer, PyObject* list, uint64_t* size);
+
+static uint64_t
+automaton_save_column_size(Automaton* automaton, TrieNode** nodes, size_t count);
 
-    custompickle_initialize_header(&header, automaton);
+static void
+automaton_save_column(Automaton* automaton, SaveBuffer* output, TrieNode** nodes, size_t count);
 
-    // 1. save header
-    savebuffer_store(&output, (const char*)&header, sizeof(header));
+static void
+automaton_save_masks(Automaton* automaton, SaveBuffer* output, TrieNode** nodes, size_t count);
 
-    // 2. save nodes
+static bool
+automaton_save_node(SaveBuffer* output, TrieNode* node, NodeMap* ids, bool minimized, size_t* next_child, size_t* value_index);
+
+static bool
+automaton_save_node_compact(SaveBuffer* output, TrieNode* node, NodeMap* ids, bool minimized, Pair** edges, size_t* capacity);
+
+bool
+automaton_save_to_buffer(Automaton* automaton, SaveBuffer* output, bool compact, bool values_list, PyObject** values) {
+
+    CustompickleHeader  header;
+    CustompickleHeader3 header3;
+    CustompickleFooter  footer;
+    TrieNode**          nodes;
+    NodeMap             ids;
+    NodeMapItem*        item;
+    Pair*               edges;
+    PyObject*           list;
+    PyObject*           serialized;
+    uint64_t            values_size;
+    uint64_t            value_size;
+    uint64_t            column_size;
+    size_t              edges_capacity;
+    size_t              edges_count;
+    size_t              eow_count;
+    size_t              next_child;
+    size_t              value_index;
+    size_t              size;
+    size_t              count;
+    size_t              i;
+    bool                ret;
+
+    // 1. numerate nodes in BFS order (each node once, also for a minimized
+    //    automaton); the compact format requires children to be visited
+    //    in order of letters
+    nodes = NULL;
+    edges = NULL;
+    list = NULL;
+    serialized = NULL;
+    edges_capacity = 0;
+    column_size = 0;
+    count = 0;
     if (automaton->kind != EMPTY) {
-        trie_traverse(automaton->root, automaton_save_node, &output);
-        if (UNLIKELY(PyErr_Occurred() != NULL)) {
+        nodes = automaton_collect_nodes(automaton, &count, compact);
+        if (UNLIKELY(nodes == NULL)) {
+            return false;
+        }
+
+        if (UNLIKELY(count > CUSTOMPICKLE_MAX_NODES)) {
+            PyErr_SetString(PyExc_ValueError, "automaton is too big to be saved");
+            memory_free(nodes);
+            return false;
+        }
+    }
+
+    // 2. ids are looked up for fail nodes and, in a minimized automaton,
+    //    for children; children of a plain trie get consecutive ids, thus
+    //    the map keeps only fail nodes --- usually a small subset of nodes,
+    //    which makes lookups cheap
+    if (UNLIKELY(!nodemap_init(&ids, automaton->minimized ? count : 1024))) {
+        memory_safefree(nodes);
+        PyErr_NoMemory();
+        return false;
+    }
+
+    edges_count = 0;
+    eow_count = 0;
+    for (i=0; i < count; i++) {
+        eow_count += nodes[i]->eow ? 1 : 0;
+    }
+
+    if (automaton->minimized) {
+        for (i=0; i < count; i++) {
+            item = nodemap_put(&ids, nodes[i]);
+            ASSERT(item); // map has been allocated for all nodes
+            item->value = (void*)(Py_uintptr_t)i;
+            edges_count += nodes[i]->n;
+        }
+    } else {
+        for (i=0; i < count; i++) {
+            edges_count += nodes[i]->n;
+            if (nodes[i]->fail != NULL and UNLIKELY(nodemap_put(&ids, nodes[i]->fail) == NULL)) {
+                PyErr_NoMemory();
+                goto exception;
+            }
+        }
+
+        for (i=0; i < count; i++) {
+            item = nodemap_get(&ids, nodes[i]);
+            if (item != NULL) {
+                item->value = (void*)(Py_uintptr_t)i;
+            }
+        }
+    }
+
+    // 3. serialize values, each one separately or all at once; the list
+    //    of values isn't serialized when it's given to the caller
+    values_list = values_list and automaton->store == STORE_ANY and values == NULL;
+    values_size = 0;
+    if (automaton->store == STORE_ANY) {
+        list = automaton_save_values(automaton, nodes, count);
+        if (UNLIKELY(list == NULL)) {
             goto exception;
         }
+
+        if (values_list) {
+            serialized = F(PyObject_CallFunctionObjArgs)(output->serializer, list, NULL);
+            if (UNLIKELY(serialized == NULL)) {
+                goto exception;
+            }
+
+            if (UNLIKELY(!F(PyBytes_CheckExact)(serialized))) {
+                PyErr_SetString(PyExc_TypeError, "serializer must return bytes object");
+                goto exception;
+            }
+
+            values_size = (uint64_t)PyBytes_GET_SIZE(serialized);
+        } else if (values == NULL) {
+            serialized = automaton_save_serialize_each(output->serializer, list, &values_size);
+            if (UNLIKELY(serialized == NULL)) {
+                goto exception;
+            }
+        }
+    } else if (store_is_column(automaton->store)) {
+        column_size = automaton_save_column_size(automaton, nodes, count);
     }
 
-    // 3. save footer
-    custompickle_initialize_footer(&footer, output.nodes_count);
-    savebuffer_store(&output, (const char*)&footer, sizeof(footer));
+    // 4. the size of plain format is known in advance
+    if (not compact) {
+        size = sizeof(header) + sizeof(header3) + sizeof(footer)
+             + count * sizeof(CustompickleNode)
+             + edges_count * sizeof(CustompickleEdge);
 
-    savebuffer_finalize(&output);
+        if (serialized != NULL) {
+            size += sizeof(values_size) + values_size;
+        } else if (store_is_column(automaton->store)) {
+            size += sizeof(values_size) + column_size;
+        }
+
+        if (automaton->key_masks.count > 0) {
+            size += eow_count * sizeof(uint64_t);
+        }
+
+        if (UNLIKELY(!savebuffer_reserve(output, size))) {
+            goto exception;
+        }
+    }
+
+    // 5. save header
+    custompickle_initialize_header3(&header, &header3, automaton, count, compact, values_list);
+    savebuffer_store(output, (const char*)&header, sizeof(header));
+    savebuffer_store(output, (const char*)&header3, sizeof(header3));
+
+    // 6. save nodes
+    value_index = 0;
+    next_child = 1;
+    for (i=0; i < count; i++) {
+        if (compact) {
+            ret = automaton_save_node_compact(output, nodes[i], &ids, automaton->minimized, &edges, &edges_capacity);
+        } else {
+            ret = automaton_save_node(output, nodes[i], &ids, automaton->minimized, &next_child, &value_index);
+        }
+
+        if (UNLIKELY(!ret)) {
+            goto exception;
+        }
+    }
+
+    // 7. save values
+    if (serialized != NULL) {
+        savebuffer_store(output, (const char*)&values_size, sizeof(values_size));
+        if (values_list) {
+            savebuffer_store(output, PyBytes_AS_STRING(serialized), PyBytes_GET_SIZE(serialized));
+        } else {
+            for (i=0; i < (size_t)PyList_GET_SIZE(serialized); i++) {
+                value_size = (uint64_t)PyBytes_GET_SIZE(PyList_GET_ITEM(serialized, i));
+                savebuffer_store(output, (const char*)&value_size, sizeof(value_size));
+                savebuffer_store(output, PyBytes_AS_STRING(PyList_GET_ITEM(serialized, i)), (size_t)value_size);
+            }
+        }
+    } else if (store_is_column(automaton->store)) {
+        values_size = column_size;
+        savebuffer_store(output, (const char*)&values_size, sizeof(values_size));
+        automaton_save_column(automaton, output, nodes, count);
+    }
+
+    if (automaton->key_masks.count > 0) {
+        automaton_save_masks(automaton, output, nodes, count);
+    }
+
+    // 8. save footer
+    custompickle_initialize_footer3(&footer, count);
+    savebuffer_store(output, (const char*)&footer, sizeof(footer));
+
+    nodemap_free(&ids);
+    memory_safefree(nodes);
+    memory_safefree(edges);
+    Py_XDECREF(serialized);
+
+    if (values != NULL) {
+        *values = list;
+    } else {
+        Py_XDECREF(list);
+    }
 
-    return true;
+    return PyErr_Occurred() == NULL;
 
 exception:
-    savebuffer_finalize(&output);
+    nodemap_free(&ids);
+    memory_safefree(nodes);
+    memory_safefree(edges);
+    Py_XDECREF(serialized);
+    Py_XDECREF(list);
 
     return false;
 }
 
 
-static int
-automaton_save_node(TrieNode* node, const int depth, void* extra) {
+static PyObject*
+automaton_save_values(Automaton* automaton, TrieNode** nodes, size_t count) {
 
-    SaveBuffer* output;
-    TrieNode* dump;
-    PyObject* bytes;
+    // the k-th value on the list belongs to the k-th terminating node
+    PyObject* list;
+    PyObject* value;
+    size_t i;
+
+    list = F(PyList_New)(0);
+    if (UNLIKELY(list == NULL)) {
+        return NULL;
+    }
 
-    output = (SaveBuffer*)extra;
+    for (i=0; i < count; i++) {
+        if (nodes[i]->eow) {
+            value = automaton_get_value(automaton, nodes[i]);
+            if (UNLIKELY(F(PyList_Append)(list, value) < 0)) {
+                Py_DECREF(list);
+                return NULL;
+            }
+        }
+    }
+
+    return list;
+}
 
-    // 1. save actual address of node
-    savebuffer_store_pointer(output, (void*)node);
 
-    // 2. obtain buffer
-    dump = (TrieNode*)savebuffer_acquire(output, PICKLE_TRIENODE_SIZE);
+static PyObject*
+automaton_save_serialize_each(PyObject* serializer, PyObject* list, uint64_t* size) {
 
-    if (output->store != STORE_ANY)
-        dump->output.integer = node->output.integer;
+    // returns the list of serialized values, size includes their sizes
+    PyObject* result;
+    PyObject* bytes;
+    Py_ssize_t i;
 
-    dump->n         = node->n;
-    dump->eow       = node->eow;
-    dump->fail      = node->fail;
+    result = F(PyList_New)(PyList_GET_SIZE(list));
+    if (UNLIKELY(result == NULL)) {
+        return NULL;
+    }
 
-    // 3. pickle python value associated with word
-    if (node->eow && output->store == STORE_ANY) {
-        bytes = F(PyObject_CallFunctionObjArgs)(output->serializer, node->output.object, NULL);
+    *size = 0;
+    for (i=0; i < PyList_GET_SIZE(list); i++) {
+        bytes = F(PyObject_CallFunctionObjArgs)(serializer, PyList_GET_ITEM(list, i), NULL);
         if (UNLIKELY(bytes == NULL)) {
-            return 0;
+            Py_DECREF(result);
+            return NULL;
         }
 
+        PyList_SET_ITEM(result, i, bytes);
         if (UNLIKELY(!F(PyBytes_CheckExact)(bytes))) {
             PyErr_SetString(PyExc_TypeError, "serializer must return bytes object");
-            return 0;
+            Py_DECREF(result);
+            return NULL;
+        }
+
+        *size += sizeof(uint64_t) + (uint64_t)PyBytes_GET_SIZE(bytes);
+    }
+
+    return result;
+}
+
+
+static uint64_t
+automaton_save_column_size(Automaton* automaton, TrieNode** nodes, size_t count) {
+
+    uint64_t size;
+    size_t i;
+
+    size = 0;
+    for (i=0; i < count; i++) {
+        if (nodes[i]->eow) {
+            if (store_column_is_bytes(automaton->store)) {
+                size += sizeof(uint32_t) + valuecolumn_get_length(&automaton->column, nodes[i]->output);
+            } else {
+                size += sizeof(uint64_t);
+            }
+        }
+    }
+
+    return size;
+}
+
+
+static void
+automaton_save_column(Automaton* automaton, SaveBuffer* output, TrieNode** nodes, size_t count) {
+
+    // the k-th value belongs to the k-th terminating node, like
+    // values of STORE_ANY
+    const ValueColumn* column = &automaton->column;
+    uint64_t value;
+    uint32_t length;
+    size_t i;
+
+    for (i=0; i < count; i++) {
+        if (nodes[i]->eow) {
+            if (column->bytes) {
+                length = (uint32_t)valuecolumn_get_length(column, nodes[i]->output);
+                savebuffer_store(output, (const char*)&length, sizeof(length));
+            } else {
+                value = valuecolumn_get(column, nodes[i]->output);
+                savebuffer_store(output, (const char*)&value, sizeof(value));
+            }
+        }
+    }
+
+    if (column->bytes) {
+        for (i=0; i < count; i++) {
+            if (nodes[i]->eow) {
+                savebuffer_store(output,
+                                 valuecolumn_get_bytes(column, nodes[i]->output),
+                                 valuecolumn_get_length(column, nodes[i]->output));
+            }
+        }
+    }
+}
+
+
+static void
+automaton_save_masks(Automaton* automaton, SaveBuffer* output, TrieNode** nodes, size_t count) {
+
+    // the k-th mask belongs to the k-th terminating node
+    uint64_t* key_mask;
+    uint64_t mask;
+    size_t i;
+
+    for (i=0; i < count; i++) {
+        if (nodes[i]->eow) {
+            key_mask = nodemasks_get(&automaton->key_masks, nodes[i]);
+            mask = (key_mask != NULL) ? *key_mask : 0;
+            savebuffer_store(output, (const char*)&mask, sizeof(mask));
         }
+    }
+}
+
+
+static uint32_t
+automaton_save_get_id(NodeMap* ids, TrieNode* node) {
+
+    NodeMapItem* item;
+
+    if (node == NULL) {
+        return CUSTOMPICKLE_NO_NODE;
+    }
 
-        // store the size of buffer in trie node [which is not saved yet in the file]
-        *(size_t*)(&dump->output.integer) = PyBytes_GET_SIZE(bytes);
+    item = nodemap_get(ids, node);
+    ASSERT(item);
+
+    return (uint32_t)(Py_uintptr_t)item->value;
+}
+
+
+static bool
+automaton_save_node(SaveBuffer* output, TrieNode* node, NodeMap* ids, bool minimized, size_t* next_child, size_t* value_index) {
+
+    CustompickleNode* dump;
+    CustompickleEdge* edge;
+    size_t size;
+    bool separate;
+    unsigned i;
+
+    // 1. save node, together with edges if they fit in the buffer
+    size = sizeof(CustompickleNode) + node->n * sizeof(CustompickleEdge);
+    separate = (output->file != NULL and size > output->capacity);
+
+    dump = (CustompickleNode*)savebuffer_acquire(output, separate ? sizeof(CustompickleNode) : size);
+    edge = (CustompickleEdge*)(dump + 1);
+    if (!store_has_index(output->store)) {
+        dump->output = (uint64_t)node->output;
+    } else if (node->eow) {
+        dump->output = (uint64_t)*value_index;
+        *value_index += 1;
     } else {
-        bytes = NULL;
+        dump->output = 0;
     }
 
-    // 4. save array of pointers
-    if (node->n > 0) {
-        savebuffer_store(output, (const char*)node->next, node->n * sizeof(Pair));
+    dump->fail = automaton_save_get_id(ids, node->fail);
+    dump->n    = node->n;
+    dump->eow  = node->eow;
+
+    // 2. save edges
+    for (i=0; i < node->n; i++, edge++) {
+        if (separate) {
+            edge = (CustompickleEdge*)savebuffer_acquire(output, sizeof(CustompickleEdge));
+        }
+
+        edge->letter = trieletter_get_ith_unsafe(node, i);
+        if (minimized) {
+            edge->child = automaton_save_get_id(ids, trienode_get_ith_unsafe(node, i));
+        } else {
+            edge->child = (uint32_t)*next_child;
+            *next_child += 1;
+        }
     }
 
-    // 5. save pickled data, if any
-    if (bytes) {
-        savebuffer_store(output, PyBytes_AS_STRING(bytes), PyBytes_GET_SIZE(bytes));
-        Py_DECREF(bytes);
+    output->nodes_count += 1;
+
+    return PyErr_Occurred() == NULL;
+}
+
+
+static bool
+automaton_save_node_compact(SaveBuffer* output, TrieNode* node, NodeMap* ids, bool minimized, Pair** edges, size_t* capacity) {
+
+    Pair* tmp;
+    uint32_t fail;
+    uint64_t value;
+    unsigned i;
+
+    // 1. save node
+    savebuffer_store_varint(output, ((uint64_t)node->n << 1) | (node->eow & 1));
+
+    fail = automaton_save_get_id(ids, node->fail);
+    savebuffer_store_varint(output, (fail == CUSTOMPICKLE_NO_NODE) ? 0 : (uint64_t)fail + 1);
+
+    // values kept in a table or a column are numbered implicitly
+    if (node->eow and !store_has_index(output->store)) {
+        // zigzag: small negative integers are short, too
+        value = (uint64_t)(int64_t)(Py_intptr_t)node->output;
+        value = (value << 1) ^ (uint64_t)((int64_t)value >> 63);
+        savebuffer_store_varint(output, value);
+    }
+
+    // 2. save edges sorted by letters, in the same order as
+    //    automaton_collect_nodes visited them
+    if (node->n > 0) {
+        if (node->n > *capacity) {
+            tmp = (Pair*)memory_realloc(*edges, node->n * sizeof(Pair));
+            if (UNLIKELY(tmp == NULL)) {
+                PyErr_NoMemory();
+                return false;
+            }
+
+            *edges = tmp;
+            *capacity = node->n;
+        }
+
+        memcpy(*edges, node->next, node->n * sizeof(Pair));
+        if (node->n > 1) {
+            qsort(*edges, node->n, sizeof(Pair), minimize_pair_cmp);
+        }
+
+        savebuffer_store_varint(output, (*edges)[0].letter);
+        for (i=1; i < node->n; i++) {
+            savebuffer_store_varint(output, (uint64_t)((*edges)[i].letter - (*edges)[i - 1].letter));
+        }
+
+        if (minimized) {
+            for (i=0; i < node->n; i++) {
+                savebuffer_store_varint(output, automaton_save_get_id(ids, (*edges)[i].child));
+            }
+        }
     }
 
     output->nodes_count += 1;
 
-    return 1;
+    return PyErr_Occurred() == NULL;
 }
@@ -1,7 +1,21 @@
 #pragma once
 
 #include "../../common.h"
+#include "savebuffer.h"
 
 PyObject*
-automaton_save(PyObject* self, PyObject* args);
+automaton_save(PyObject* self, PyObject* args, PyObject* kwargs);
+
+PyObject*
+automaton_save_bytes(PyObject* self, PyObject* args, PyObject* kwargs);
+
+/*
+    Write automaton to the output in the format version 3. Values of
+    STORE_ANY are serialized one by one, or at once as a list when
+    values_list is true. When values is not NULL, values of STORE_ANY
+    are not written, instead the list of them (in order expected by the
+    loader) is returned there; for other stores NULL is returned.
+*/
+bool
+automaton_save_to_buffer(Automaton* automaton, SaveBuffer* output, bool compact, bool values_list, PyObject** values);
 
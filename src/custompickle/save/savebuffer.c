@@ -1,15 +1,23 @@
 #include "savebuffer.h"
 
-bool
-savebuffer_init(SaveBuffer* output, PyObject* serializer, KeysStore store, const char* path, size_t capacity) {
+static void
+savebuffer_reset(SaveBuffer* output, PyObject* serializer, KeysStore store, size_t capacity) {
 
     output->store       = store;
     output->file        = NULL;
+    output->bytes       = NULL;
     output->buffer      = NULL;
     output->size        = 0;
     output->capacity    = capacity;
     output->serializer  = serializer;
     output->nodes_count = 0;
+}
+
+
+bool
+savebuffer_init(SaveBuffer* output, PyObject* serializer, KeysStore store, const char* path, size_t capacity) {
+
+    savebuffer_reset(output, serializer, store, capacity);
 
     if (PICKLE_SIZE_T_SIZE < sizeof(PyObject*)) {
         // XXX: this must be reworked, likely moved to module level
@@ -40,8 +48,64 @@ savebuffer_init(SaveBuffer* output, PyObject* serializer, KeysStore store, const
 }
 
 
+bool
+savebuffer_init_memory(SaveBuffer* output, PyObject* serializer, KeysStore store, size_t capacity) {
+
+    savebuffer_reset(output, serializer, store, capacity);
+
+    output->bytes = F(PyBytes_FromStringAndSize)(NULL, capacity);
+    if (UNLIKELY(output->bytes == NULL)) {
+        return false;
+    }
+
+    output->buffer = PyBytes_AS_STRING(output->bytes);
+
+    return true;
+}
+
+
+bool
+savebuffer_reserve(SaveBuffer* output, size_t size) {
+
+    PyObject* bytes;
+    size_t capacity;
+
+    // a file is written in pieces, only memory output grows
+    if (output->file != NULL or output->size + size <= output->capacity) {
+        return true;
+    }
+
+    capacity = 2 * output->capacity;
+    if (capacity < output->size + size) {
+        capacity = output->size + size;
+    }
+
+    bytes = F(PyBytes_FromStringAndSize)(NULL, capacity);
+    if (UNLIKELY(bytes == NULL)) {
+        // the current buffer is kept, thus subsequent small writes are
+        // still valid; the error is reported at the end, like I/O errors
+        output->size = 0;
+        return false;
+    }
+
+    memcpy(PyBytes_AS_STRING(bytes), output->buffer, output->size);
+    Py_DECREF(output->bytes);
+
+    output->bytes    = bytes;
+    output->buffer   = PyBytes_AS_STRING(bytes);
+    output->capacity = capacity;
+
+    return true;
+}
+
+
 void
 savebuffer_flush(SaveBuffer* output) {
+    if (output->file == NULL) {
+        // memory output is never flushed, it grows instead
+        return;
+    }
+
     if (output->size != fwrite(output->buffer, 1, output->size, output->file)) {
         PyErr_SetFromErrno(PyExc_IOError);
     }
@@ -55,6 +119,8 @@ savebuffer_acquire(SaveBuffer* output, size_t request) {
 
     char* ptr;
 
+    savebuffer_reserve(output, request);
+
     if (UNLIKELY(request > output->capacity)) {
         return NULL;
     }
@@ -73,6 +139,19 @@ savebuffer_acquire(SaveBuffer* output, size_t request) {
 void
 savebuffer_store(SaveBuffer* output, const char* data, size_t size) {
 
+    // empty values (e.g. b'' of STORE_BYTES) may have no data pointer
+    if (size == 0) {
+        return;
+    }
+
+    if (output->file == NULL) {
+        if (LIKELY(savebuffer_reserve(output, size))) {
+            memcpy(output->buffer + output->size, data, size);
+            output->size += size;
+        }
+        return;
+    }
+
     if (UNLIKELY(size > output->capacity)) {
         savebuffer_flush(output);
         if (fwrite(data, 1, size, output->file) != size) {
@@ -99,6 +178,26 @@ savebuffer_store_pointer(SaveBuffer* save, void* ptr) {
 }
 
 
+void
+savebuffer_store_varint(SaveBuffer* save, uint64_t value) {
+    char* buf;
+    size_t size;
+
+    buf = savebuffer_acquire(save, CUSTOMPICKLE_VARINT_MAX_SIZE);
+
+    size = 0;
+    while (value >= 0x80) {
+        buf[size++] = (char)((value & 0x7f) | 0x80);
+        value >>= 7;
+    }
+
+    buf[size++] = (char)value;
+
+    // return the unused part of the acquired space
+    save->size -= CUSTOMPICKLE_VARINT_MAX_SIZE - size;
+}
+
+
 void
 savebuffer_finalize(SaveBuffer* output) {
 
@@ -106,9 +205,42 @@ savebuffer_finalize(SaveBuffer* output) {
         savebuffer_flush(output);
     }
 
-    memory_safefree(output->buffer);
+    if (output->bytes != NULL) {
+        // the buffer is owned by the bytes object
+        Py_DECREF(output->bytes);
+        output->bytes = NULL;
+    } else {
+        memory_safefree(output->buffer);
+    }
+
+    output->buffer = NULL;
 
     if (output->file != NULL) {
         fclose(output->file);
     }
 }
+
+
+PyObject*
+savebuffer_finalize_memory(SaveBuffer* output) {
+
+    PyObject* bytes;
+
+    ASSERT(output->file == NULL);
+
+    bytes = output->bytes;
+    output->bytes  = NULL;
+    output->buffer = NULL;
+
+    if (UNLIKELY(PyErr_Occurred() != NULL)) {
+        Py_XDECREF(bytes);
+        return NULL;
+    }
+
+    // trim the unused part, it's a no-op if the size was known in advance
+    if ((size_t)PyBytes_GET_SIZE(bytes) != output->size and _PyBytes_Resize(&bytes, output->size) < 0) {
+        return NULL;
+    }
+
+    return bytes;
+}
@@ -1,12 +1,14 @@
 #pragma once
 
 #include "../../Automaton.h"
+#include "../custompickle.h"
 
 #define SAVEBUFFER_DEFAULT_SIZE (32 * 1024lu)
 
 typedef struct SaveBuffer {
     KeysStore   store;
     FILE*       file;
+    PyObject*   bytes;          ///< memory output (a bytes object), used when file is NULL
     char*       buffer;
     size_t      size;
     size_t      capacity;
@@ -18,6 +20,12 @@ typedef struct SaveBuffer {
 bool
 savebuffer_init(SaveBuffer* save, PyObject* serializer, KeysStore store, const char* path, size_t capacity);
 
+bool
+savebuffer_init_memory(SaveBuffer* save, PyObject* serializer, KeysStore store, size_t capacity);
+
+bool
+savebuffer_reserve(SaveBuffer* save, size_t size);
+
 void
 savebuffer_flush(SaveBuffer* save);
 
@@ -30,5 +38,11 @@ savebuffer_store(SaveBuffer* save, const char* data, size_t size);
 void
 savebuffer_store_pointer(SaveBuffer* save, void* ptr);
 
+void
+savebuffer_store_varint(SaveBuffer* save, uint64_t value);
+
 void
 savebuffer_finalize(SaveBuffer* save);
+
+PyObject*
+savebuffer_finalize_memory(SaveBuffer* save);
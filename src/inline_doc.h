@@ -4,7 +4,18 @@
 #define automaton___reduce___doc \
 	"__reduce__()\n" \
 	"\n" \
-	"Return pickle-able data for this automaton instance."
+	"Return pickle-able data for this automaton instance. The\n" \
+	"automaton is stored in a single bytes object; values of a\n" \
+	"STORE_ANY automaton are pickled as a list."
+
+#define automaton___reduce_ex___doc \
+	"__reduce_ex__(protocol)\n" \
+	"\n" \
+	"Return pickle-able data for this automaton instance, like\n" \
+	"__reduce__. For pickle protocol 5 or higher the data is\n" \
+	"wrapped in pickle.PickleBuffer, thus it can be transferred\n" \
+	"out-of-band without copying (see buffer_callback of\n" \
+	"pickle.dumps). Pickling does not modify the automaton."
 
 #define automaton___sizeof___doc \
 	"Return the approximate size in bytes occupied by the\n" \
@@ -13,7 +24,7 @@
 	"Automaton() or Automaton(ahocorasick.STORE_ANY)."
 
 #define automaton_add_word_doc \
-	"add_word(key, [value]) -> boolean\n" \
+	"add_word(key, [value], mask=None) -> boolean\n" \
 	"\n" \
 	"Add a key string to the dict-like trie and associate this\n" \
 	"key with a value. value is optional or mandatory depending\n" \
@@ -25,28 +36,97 @@
 	"The value is either mandatory or optional:\n" \
 	"- If the Automaton was created without argument (the\n" \
 	"  default) as Automaton() or with\n" \
-	"  Automaton(ahocorasik.STORE_ANY) then the value is required\n" \
-	"  and can be any Python object.\n" \
+	"  Automaton(ahocorasick.STORE_ANY) then the value is\n" \
+	"  required and can be any Python object.\n" \
 	"- If the Automaton was created with\n" \
-	"  Automaton(ahocorasik.STORE_INTS) then the value is\n" \
+	"  Automaton(ahocorasick.STORE_INTS) then the value is\n" \
 	"  optional. If provided it must be an integer, otherwise it\n" \
 	"  defaults to len(automaton) which is therefore the order\n" \
 	"  index in which keys are added to the trie.\n" \
 	"- If the Automaton was created with\n" \
-	"  Automaton(ahocorasik.STORE_LENGTH) then associating a\n" \
+	"  Automaton(ahocorasick.STORE_LENGTH) then associating a\n" \
 	"  value is not allowed - len(word) is saved automatically as\n" \
 	"  a value instead.\n" \
+	"- If the Automaton was created with\n" \
+	"  Automaton(ahocorasick.STORE_KEY_ID) then associating a\n" \
+	"  value is not allowed; make_automaton assigns ids to keys,\n" \
+	"  see key_of.\n" \
+	"- If the Automaton was created with STORE_BYTES, STORE_INT64\n" \
+	"  or STORE_FLOAT then the value is required and must be\n" \
+	"  respectively a bytes object, an integer fitting in 64 bits\n" \
+	"  or a float.\n" \
+	"- If the Automaton was created with STORE_MULTI_INTS then\n" \
+	"  the value is required and must be an integer fitting in 64\n" \
+	"  bits. It is appended to the integers already associated\n" \
+	"  with the key rather than replacing them.\n" \
+	"\n" \
+	"The optional mask is a non-zero 64-bit integer, a set of\n" \
+	"categories of the key. Masks given to the same key are ORed.\n" \
+	"Searching methods accept a mask and report only keys having\n" \
+	"a common category with it; a key without a mask is reported\n" \
+	"for every mask.\n" \
 	"\n" \
 	"Calling add_word() invalidates all iterators only if the new\n" \
 	"key did not exist in the trie so far (i.e. the method\n" \
 	"returned True)."
 
+#define automaton_add_words_doc \
+	"add_words(iterable, mask=None) -> integer\n" \
+	"\n" \
+	"Add many keys at once; the result is the same as calling\n" \
+	"add_word for each item of the iterable in order. Return the\n" \
+	"number of keys that did not exist in the trie so far.\n" \
+	"\n" \
+	"The items of the iterable depend on how the Automaton was\n" \
+	"created:\n" \
+	"- for STORE_ANY, STORE_BYTES, STORE_INT64, STORE_FLOAT and\n" \
+	"  STORE_MULTI_INTS each item must be a (key, value) tuple;\n" \
+	"  repeated keys of STORE_MULTI_INTS collect all their\n" \
+	"  integers;\n" \
+	"- for STORE_INTS an item is either a (key, value) tuple or\n" \
+	"  just a key, then the value defaults as in add_word;\n" \
+	"  however, with KEY_SEQUENCE a key is a tuple itself, thus\n" \
+	"  an item must always be a (key, value) tuple, e.g. ((1, 2),\n" \
+	"  3);\n" \
+	"- for STORE_LENGTH and STORE_KEY_ID each item is a key.\n" \
+	"\n" \
+	"The optional mask is given to all keys, as in add_word.\n" \
+	"\n" \
+	"All keys are validated before the trie is modified. Then the\n" \
+	"keys are sorted, thus all keys sharing the first letter are\n" \
+	"placed in the same subtree of the root in one go, and the\n" \
+	"common prefix of consecutive keys is not looked up again.\n" \
+	"This makes a bulk build noticeably faster than a loop of\n" \
+	"add_word calls.\n" \
+	"\n" \
+	"Calling add_words() invalidates all iterators only if at\n" \
+	"least one new key was added."
+
 #define automaton_clear_doc \
 	"clear()\n" \
 	"\n" \
 	"Remove all keys from the trie. This method invalidates all\n" \
 	"iterators."
 
+#define automaton_compact_doc \
+	"compact()\n" \
+	"\n" \
+	"Move all nodes of the automaton into a single array, and all\n" \
+	"their edges into another one, in breadth-first order. This\n" \
+	"removes per-node allocation overhead and places nodes that\n" \
+	"are visited together close in memory.\n" \
+	"\n" \
+	"Searching only reads both arrays. When worker processes are\n" \
+	"forked after compact, e.g. by multiprocessing, they keep\n" \
+	"sharing a single physical copy of the automaton. Values of a\n" \
+	"STORE_ANY automaton are still reference-counted Python\n" \
+	"objects and the pages of reported values get copied;\n" \
+	"STORE_INTS and STORE_LENGTH automata are not written at all.\n" \
+	"\n" \
+	"The automaton can be still modified; the first modification\n" \
+	"copies edges out of the shared array. Calling compact()\n" \
+	"invalidates all iterators."
+
 #define automaton_constructor_doc \
 	"Automaton(value_type=ahocorasick.STORE_ANY, [key_type])\n" \
 	"\n" \
@@ -61,6 +141,27 @@
 	"  in the trie for that key.\n" \
 	"- ahocorasick.STORE_INTS : The associated value must be a\n" \
 	"  32-bit integer.\n" \
+	"- ahocorasick.STORE_BYTES : The associated value must be a\n" \
+	"  bytes object.\n" \
+	"- ahocorasick.STORE_INT64 : The associated value must be a\n" \
+	"  64-bit signed integer.\n" \
+	"- ahocorasick.STORE_FLOAT : The associated value must be a\n" \
+	"  float (or a number convertible to float).\n" \
+	"- ahocorasick.STORE_KEY_ID : No value is associated; each\n" \
+	"  key gets an id, its rank in sorted order of keys, and\n" \
+	"  key_of(id) returns the key.\n" \
+	"- ahocorasick.STORE_MULTI_INTS : A key is associated with\n" \
+	"  one or more 64-bit signed integers, e.g. labels of\n" \
+	"  categories sharing the key. Adding an existing key appends\n" \
+	"  the integer; get returns a tuple of all integers of a key,\n" \
+	"  while iter, iter_spans and find_all report each integer as\n" \
+	"  a separate match.\n" \
+	"\n" \
+	"Values of STORE_BYTES, STORE_INT64, STORE_FLOAT and\n" \
+	"STORE_MULTI_INTS are not kept as Python objects but in a\n" \
+	"contiguous native column; an object is created each time a\n" \
+	"value is returned, thus such automaton takes much less\n" \
+	"memory and is saved and loaded without serializing values.\n" \
 	"\n" \
 	"key_type defines the type of data that can be stored in an\n" \
 	"automaton; it is one of these constants and defines type of\n" \
@@ -92,7 +193,7 @@
 	"the 'in' keyword."
 
 #define automaton_find_all_doc \
-	"find_all(string, callback, [start, [end]])\n" \
+	"find_all(string, callback, [start, [end]], mask=None)\n" \
 	"\n" \
 	"Perform the Aho-Corasick search procedure using the provided\n" \
 	"input string and iterate over the matching tuples\n" \
@@ -107,9 +208,27 @@
 	"The start and end optional arguments can be used to limit\n" \
 	"the search to an input string slice as in string[start:end].\n" \
 	"\n" \
+	"The mask keyword argument limits matches as in iter.\n" \
+	"\n" \
 	"Equivalent to a loop on iter() calling a callable at each\n" \
 	"iteration."
 
+#define automaton_find_all_spans_doc \
+	"find_all_spans(string, callback, [start, [end]], mask=None)\n" \
+	"\n" \
+	"Perform the Aho-Corasick search procedure using the provided\n" \
+	"input string and invoke the callback callable with three\n" \
+	"positional arguments (start_index, end_index, value) for\n" \
+	"each key found in string, as iter_spans reports them.\n" \
+	"\n" \
+	"The start and end optional arguments can be used to limit\n" \
+	"the search to an input string slice as in string[start:end].\n" \
+	"\n" \
+	"The mask keyword argument limits matches as in iter.\n" \
+	"\n" \
+	"Equivalent to a loop on iter_spans() calling a callable at\n" \
+	"each iteration."
+
 #define automaton_get_doc \
 	"get(key[, default])\n" \
 	"\n" \
@@ -133,7 +252,17 @@
 	"- sizeof_node - size of single node in bytes\n" \
 	"- total_size - total size of trie in bytes (about\n" \
 	"  nodes_count * size_of node + links_count * size of\n" \
-	"  pointer)."
+	"  pointer).\n" \
+	"- engine - engine used by searching, one of\n" \
+	"  ahocorasick.ENGINE_* constants (see make_automaton).\n" \
+	"- alphabet_size - number of distinct letters of keys, known\n" \
+	"  after make_automaton; 0 when letters can't be classified\n" \
+	"  (integer keys out of range of code points).\n" \
+	"- cache_size - number of entries of the cache of transitions\n" \
+	"  (see make_automaton), 0 when there's no cache.\n" \
+	"- cache_hits, cache_misses - number of transitions found in\n" \
+	"  the cache and resolved anew; the hit rate is cache_hits /\n" \
+	"  (cache_hits + cache_misses)."
 
 #define automaton_items_doc \
 	"items([prefix, [wildcard, [how]]])\n" \
@@ -143,7 +272,7 @@
 	"arguments as in the keys() method."
 
 #define automaton_iter_doc \
-	"iter(string, [start, [end]], ignore_white_space=False)\n" \
+	"iter(string, [start, [end]], ignore_white_space=False, mask=None)\n" \
 	"\n" \
 	"Perform the Aho-Corasick search procedure using the provided\n" \
 	"input string.\n" \
@@ -158,7 +287,15 @@
 	"the search to an input string slice as in string[start:end].\n" \
 	"\n" \
 	"The ignore_white_space optional arguments can be used to\n" \
-	"ignore white spaces from input string."
+	"ignore white spaces from input string.\n" \
+	"\n" \
+	"The mask keyword argument limits matches to keys having any\n" \
+	"category in common with it, see add_word. For each state of\n" \
+	"the automaton the categories of all keys recognized there\n" \
+	"are precomputed, thus states without a requested key are\n" \
+	"skipped at the cost of a single lookup. Masks of states are\n" \
+	"computed by the first search after the automaton has\n" \
+	"changed."
 
 #define automaton_iter_long_doc \
 	"iter_long(string, [start, [end]])\n" \
@@ -170,10 +307,61 @@
 	"found in string where:\n" \
 	"- end_index is the end index in the input string where a\n" \
 	"  trie key string was found.\n" \
+	"- value is the value associated with the found key string;\n" \
+	"  for STORE_MULTI_INTS it is a tuple of all integers of the\n" \
+	"  key.\n" \
+	"\n" \
+	"The start and ``end optional arguments can be used to limit\n" \
+	"the search to an input string slice as in string[start:end]."
+
+#define automaton_iter_spans_doc \
+	"iter_spans(string, [start, [end]], mask=None)\n" \
+	"\n" \
+	"Perform the Aho-Corasick search procedure using the provided\n" \
+	"input string, like iter, and return an iterator of tuples\n" \
+	"(start_index, end_index, value) for keys found in string,\n" \
+	"where:\n" \
+	"- start_index is the index of the first character of a found\n" \
+	"  key, i.e. end_index - len(key) + 1.\n" \
+	"- end_index is the end index in the input string where a\n" \
+	"  trie key string was found, as reported by iter.\n" \
 	"- value is the value associated with the found key string.\n" \
 	"\n" \
+	"Thus string[start_index:end_index + 1] is the found key.\n" \
+	"Each node of the trie records its depth when a key is added,\n" \
+	"the key doesn't have to be stored as a value nor looked up.\n" \
+	"\n" \
 	"The start and end optional arguments can be used to limit\n" \
-	"the search to an input string slice as in string[start:end]."
+	"the search to an input string slice as in string[start:end].\n" \
+	"The returned iterator can be fed with next chunks of data\n" \
+	"with its set() method; then indices refer to the whole\n" \
+	"stream, and a key may start in a previous chunk.\n" \
+	"\n" \
+	"The mask keyword argument limits matches as in iter.\n" \
+	"\n" \
+	"Raise AttributeError if the automaton is minimized: merged\n" \
+	"nodes may be reached by keys of different lengths."
+
+#define automaton_key_of_doc \
+	"key_of(id) -> key\n" \
+	"\n" \
+	"Return the key having given id in an automaton created with\n" \
+	"STORE_KEY_ID. Such automaton associates each key with its\n" \
+	"rank in sorted order of all keys, 0 .. len(automaton) - 1;\n" \
+	"get, iter, iter_long, find_all, values and items report\n" \
+	"these ids.\n" \
+	"\n" \
+	"The ids are assigned by make_automaton, which also builds a\n" \
+	"table of all keys concatenated in order of ids. key_of\n" \
+	"restores a key from this table, thus matched keys don't have\n" \
+	"to be stored as values. Iterating over all keys, i.e. keys()\n" \
+	"without arguments, also reads the table and returns keys in\n" \
+	"sorted order.\n" \
+	"\n" \
+	"Raise AttributeError if the automaton was created with\n" \
+	"another store or make_automaton was not called after the\n" \
+	"last modification, and IndexError if there's no key with\n" \
+	"such id."
 
 #define automaton_keys_doc \
 	"keys([prefix, [wildcard, [how]]])\n" \
@@ -206,12 +394,52 @@
 	"exists in the trie."
 
 #define automaton_make_automaton_doc \
-	"make_automaton()\n" \
+	"make_automaton([engine, [cache]])\n" \
 	"\n" \
 	"Finalize and create the Aho-Corasick automaton based on the\n" \
 	"keys already added to the trie. This does not require\n" \
 	"additional memory. After successful creation the\n" \
-	"Automaton.kind attribute is set to ahocorasick.AHOCORASICK."
+	"Automaton.kind attribute is set to ahocorasick.AHOCORASICK.\n" \
+	"\n" \
+	"The optional keyword argument engine selects how searching\n" \
+	"skips positions of the input where no key can start:\n" \
+	"- ahocorasick.ENGINE_AUTO (default) : select an engine from\n" \
+	"  statistics of keys;\n" \
+	"- ahocorasick.ENGINE_TRIE : don't skip anything, check every\n" \
+	"  letter;\n" \
+	"- ahocorasick.ENGINE_LETTERS : skip letters which don't\n" \
+	"  start any key;\n" \
+	"- ahocorasick.ENGINE_BIGRAMS : skip positions where the next\n" \
+	"  two letters don't start any key;\n" \
+	"- ahocorasick.ENGINE_SHIFTS : jump over the text using a Wu-\n" \
+	"  Manber shift table, best when all keys are long.\n" \
+	"\n" \
+	"All engines find the same matches. When an engine can't be\n" \
+	"used for the current keys, the closest one is used instead;\n" \
+	"the engine actually used is reported by get_stats(). The\n" \
+	"engine can be changed by calling make_automaton again, also\n" \
+	"when the automaton is already built; its iterators stay\n" \
+	"valid. A call without engine keeps the engine selected\n" \
+	"before. The engine is not saved with the automaton.\n" \
+	"\n" \
+	"When the root has many edges (e.g. a dictionary of CJK\n" \
+	"words), children of the root are also kept in a two-level\n" \
+	"table indexed by letters, thus falling back to the root\n" \
+	"doesn't scan its edges. Letters absent in keys are\n" \
+	"recognized with a lookup table; they lead straight to the\n" \
+	"root, without following fail links. Both tables are counted\n" \
+	"by __sizeof__.\n" \
+	"\n" \
+	"The optional keyword argument cache is the number of entries\n" \
+	"of a cache of transitions (rounded up to a power of two, at\n" \
+	"most 2**24; by default there's no cache). Searching saves\n" \
+	"there each transition it takes, with the target already\n" \
+	"resolved through fail links, thus a repeated transition is a\n" \
+	"single lookup. It pays off when texts keep taking a limited\n" \
+	"set of transitions and the cache fits in the CPU cache;\n" \
+	"get_stats() reports its hits and misses. Like the engine,\n" \
+	"the cache size is kept by calls without cache (cache=0\n" \
+	"removes the cache) and is not saved with the automaton."
 
 #define automaton_match_doc \
 	"match(key) -> bool\n" \
@@ -224,6 +452,47 @@
 	"or match('example') all return True. But exists() is True\n" \
 	"only when calling exists('example')."
 
+#define automaton_minimize_doc \
+	"minimize()\n" \
+	"\n" \
+	"Merge equivalent nodes of an Aho-Corasick automaton, turning\n" \
+	"the trie into a DAWG-like structure in which common suffixes\n" \
+	"of keys are stored once. Two nodes are merged when they have\n" \
+	"the same fail link and equal outputs, and their children are\n" \
+	"pairwise equivalent; thus searching (iter, iter_long,\n" \
+	"find_all) as well as get, exists, keys, items and values\n" \
+	"return exactly the same results as before.\n" \
+	"\n" \
+	"Outputs are compared by value for STORE_INTS, STORE_LENGTH,\n" \
+	"STORE_BYTES, STORE_INT64 and STORE_FLOAT and by identity for\n" \
+	"STORE_ANY. Minimization pays off when many keys share\n" \
+	"values, for instance when all values are None, True or a\n" \
+	"small set of category objects; with STORE_LENGTH keys ending\n" \
+	"at different depths never share a node, so the savings are\n" \
+	"small.\n" \
+	"\n" \
+	"The method can be called only after make_automaton. A\n" \
+	"minimized automaton is read-only: add_word, add_words,\n" \
+	"remove_word and pop raise AttributeError. Call clear to\n" \
+	"reuse the object. The Automaton.minimized attribute is then\n" \
+	"True. Calling minimize() invalidates all iterators."
+
+#define automaton_optimize_doc \
+	"optimize(sample_texts)\n" \
+	"\n" \
+	"Search the iterable sample_texts and lay out the automaton\n" \
+	"by the profile. Edges of each node are reordered, the most\n" \
+	"often taken first, thus a transition usually checks a single\n" \
+	"edge. Then the automaton is compacted (see compact()) with\n" \
+	"nodes placed in order of their frequency, the hottest nodes\n" \
+	"sharing cache lines.\n" \
+	"\n" \
+	"Samples should resemble the searched texts; the result of\n" \
+	"searching doesn't depend on them. The order of keys(),\n" \
+	"values() and items() may change, ids of STORE_KEY_ID keys\n" \
+	"are kept. Raise AttributeError if make_automaton() hasn't\n" \
+	"been called. Calling optimize() invalidates all iterators."
+
 #define automaton_pop_doc \
 	"pop(word)\n" \
 	"\n" \
@@ -236,14 +505,33 @@
 	"Remove given word from a trie. Return True if words was\n" \
 	"found, False otherwise."
 
+#define automaton_save_bytes_doc \
+	"save_bytes([serializer], compact=False, values_list=False) => bytes\n" \
+	"\n" \
+	"Return content of automaton as a bytes object, in the same\n" \
+	"format as save writes to a file. Serializer is required only\n" \
+	"when automaton store type is STORE_ANY, see save."
+
 #define automaton_save_doc \
-	"save(path, serializer)\n" \
+	"save(path, serializer, compact=False, values_list=False)\n" \
 	"\n" \
-	"Save content of automaton in an on-disc file.\n" \
+	"Save content of automaton in an on-disc file. Also a\n" \
+	"minimized automaton can be saved.\n" \
 	"\n" \
 	"Serializer is a callable object that is used when automaton\n" \
 	"store type is STORE_ANY. This method converts a python\n" \
-	"object into bytes; it can be pickle.dumps."
+	"object into bytes; it can be pickle.dumps.\n" \
+	"\n" \
+	"If values_list is true, then the serializer is called once,\n" \
+	"with the list of all values, instead of once for each value.\n" \
+	"This is faster when there are many keys; the list must be\n" \
+	"serializable as a whole.\n" \
+	"\n" \
+	"If compact is true, then nodes are written with a variable-\n" \
+	"length encoding: small integers take a single byte, letters\n" \
+	"of a node are stored as differences and children of a plain\n" \
+	"trie are not stored at all. Such files are several times\n" \
+	"smaller and are loaded by load as usual."
 
 #define automaton_search_iter_doc \
 	"This class is not available directly but instances of\n" \
@@ -260,6 +548,86 @@
 	"string being searched are not reset. This allow to search\n" \
 	"for large strings in multiple smaller chunks."
 
+#define automaton_search_many_doc \
+	"search_many(strings, [interleave]) -> list\n" \
+	"\n" \
+	"Perform the Aho-Corasick search procedure in each string of\n" \
+	"the iterable strings. Return a list which contains, for each\n" \
+	"string, a list of tuples (end_index, value) as iter reports\n" \
+	"them.\n" \
+	"\n" \
+	"Up to interleave strings (by default 8, at most 64) are\n" \
+	"searched at once, a letter of each in turn; the automaton's\n" \
+	"nodes for the next letters are prefetched meanwhile. It pays\n" \
+	"off for large automatons, whose nodes are mostly not in\n" \
+	"cache."
+
+#define automaton_set_constructor_doc \
+	"AutomatonSet(automatons)\n" \
+	"\n" \
+	"Create a set of automatons searched together in a single\n" \
+	"pass over the input. automatons is an iterable of Automaton\n" \
+	"objects having the same key type; they may differ in the\n" \
+	"type of values.\n" \
+	"\n" \
+	"Keys of all automatons are merged into one internal Aho-\n" \
+	"Corasick automaton, each key refers to the automatons which\n" \
+	"contain it. Thus the cost of a search does not depend on the\n" \
+	"number of automatons, and the input is converted once.\n" \
+	"\n" \
+	"The merged automaton is built by the first search and\n" \
+	"rebuilt when any of the automatons has changed, i.e. its\n" \
+	"keys were added or removed, or it was converted by\n" \
+	"make_automaton, minimize or compact. Values are read\n" \
+	"directly from the automatons, thus a replaced value is\n" \
+	"reported at once.\n" \
+	"\n" \
+	"The read-only attribute automatons is a tuple of the\n" \
+	"automatons."
+
+#define automaton_set_find_all_doc \
+	"find_all(string, callback, [start, [end]])\n" \
+	"\n" \
+	"Perform the Aho-Corasick search procedure of all automatons\n" \
+	"of the set using the provided input string and invoke the\n" \
+	"callback callable with three positional arguments\n" \
+	"(automaton_index, end_index, value) for each key found in\n" \
+	"string, as iter reports them.\n" \
+	"\n" \
+	"The start and end optional arguments can be used to limit\n" \
+	"the search to an input string slice as in string[start:end].\n" \
+	"\n" \
+	"Equivalent to a loop on iter() calling a callable at each\n" \
+	"iteration."
+
+#define automaton_set_iter_doc \
+	"iter(string, [start, [end]])\n" \
+	"\n" \
+	"Perform the Aho-Corasick search procedure of all automatons\n" \
+	"of the set using the provided input string. Return an\n" \
+	"iterator of tuples (automaton_index, end_index, value)\n" \
+	"where:\n" \
+	"- automaton_index is the index of an automaton in\n" \
+	"  automatons;\n" \
+	"- end_index and value are the same as Automaton.iter\n" \
+	"  reports.\n" \
+	"\n" \
+	"Keys ending at the same index are reported in the order\n" \
+	"Automaton.iter reports them; a key contained in several\n" \
+	"automatons is reported for each of them in order of the\n" \
+	"automatons.\n" \
+	"\n" \
+	"The start and end optional arguments can be used to limit\n" \
+	"the search to an input string slice as in string[start:end].\n" \
+	"\n" \
+	"The iterator becomes invalid when any of the automatons\n" \
+	"changes."
+
+#define automaton_set_search_iter_doc \
+	"This class is not available directly but instances of\n" \
+	"AutomatonSetSearchIter are returned by the iter() method of\n" \
+	"an AutomatonSet."
+
 #define automaton_values_doc \
 	"values([prefix, [wildcard, [how]]])\n" \
 	"\n" \
@@ -273,10 +641,22 @@
 	"that you can find multiple key strings occurrences at once\n" \
 	"in some input text."
 
+#define module_load_bytes_doc \
+	"load_bytes(data, [deserializer]) => Automaton\n" \
+	"\n" \
+	"Load automaton from an object supporting the buffer protocol\n" \
+	"(bytes, bytearray, memoryview, mmap, etc.) that holds data\n" \
+	"returned by save_bytes or a file written by save. Nodes are\n" \
+	"read directly from the buffer, without an intermediate copy.\n" \
+	"Deserializer is required only when automaton store type is\n" \
+	"STORE_ANY, see load."
+
 #define module_load_doc \
 	"load(path, deserializer) => Automaton\n" \
 	"\n" \
 	"Load automaton previously stored on disc using save method.\n" \
 	"\n" \
 	"Deserializer is a callable object which converts bytes back\n" \
-	"into python object; it can be pickle.loads."
+	"into python object; it can be pickle.loads. For files saved\n" \
+	"with values_list=True it is called once and has to return\n" \
+	"the list of values that was passed to the serializer."
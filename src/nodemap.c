@@ -0,0 +1,135 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Hash map from trie nodes to arbitrary pointers implementation.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#include "nodemap.h"
+
+
+static size_t PURE
+nodemap_hash(const TrieNode* key) {
+    // nodes are at least 8-byte aligned, Fibonacci hashing mixes the rest
+    return (size_t)((((uint64_t)(Py_uintptr_t)key) >> 3) * 0x9e3779b97f4a7c15ull >> 17);
+}
+
+
+static bool
+nodemap_alloc(NodeMap* map, size_t capacity) {
+
+    size_t size = 16;
+
+    while (size < 2 * capacity) {
+        size *= 2;
+    }
+
+    map->items = (NodeMapItem*)memory_alloc(size * sizeof(NodeMapItem));
+    if (UNLIKELY(map->items == NULL)) {
+        return false;
+    }
+
+    memset(map->items, 0, size * sizeof(NodeMapItem));
+    map->mask  = size - 1;
+    map->count = 0;
+
+    return true;
+}
+
+
+static bool
+nodemap_init(NodeMap* map, size_t capacity) {
+
+    map->items = NULL;
+    map->mask  = 0;
+    map->count = 0;
+
+    return nodemap_alloc(map, capacity);
+}
+
+
+static void
+nodemap_free(NodeMap* map) {
+
+    memory_safefree(map->items);
+    map->items = NULL;
+    map->mask  = 0;
+    map->count = 0;
+}
+
+
+static NodeMapItem* PURE
+nodemap_get(NodeMap* map, TrieNode* key) {
+
+    size_t index;
+
+    ASSERT(key);
+
+    index = nodemap_hash(key) & map->mask;
+    while (map->items[index].key != NULL) {
+        if (map->items[index].key == key) {
+            return &map->items[index];
+        }
+
+        index = (index + 1) & map->mask;
+    }
+
+    return NULL;
+}
+
+
+static bool
+nodemap_grow(NodeMap* map) {
+
+    NodeMap old = *map;
+    NodeMapItem* item;
+    size_t i;
+
+    if (UNLIKELY(!nodemap_alloc(map, old.mask + 1))) {
+        *map = old;
+        return false;
+    }
+
+    for (i=0; i <= old.mask; i++) {
+        if (old.items[i].key != NULL) {
+            item = nodemap_put(map, old.items[i].key);
+            ASSERT(item);
+            item->value = old.items[i].value;
+        }
+    }
+
+    memory_free(old.items);
+    return true;
+}
+
+
+static NodeMapItem*
+nodemap_put(NodeMap* map, TrieNode* key) {
+
+    size_t index;
+
+    ASSERT(key);
+
+    if (UNLIKELY(2 * (map->count + 1) > map->mask + 1)) {
+        if (UNLIKELY(!nodemap_grow(map))) {
+            return NULL;
+        }
+    }
+
+    index = nodemap_hash(key) & map->mask;
+    while (map->items[index].key != NULL) {
+        if (map->items[index].key == key) {
+            return &map->items[index];
+        }
+
+        index = (index + 1) & map->mask;
+    }
+
+    map->items[index].key   = key;
+    map->items[index].value = NULL;
+    map->count += 1;
+
+    return &map->items[index];
+}
@@ -0,0 +1,48 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Hash map from trie nodes to arbitrary pointers declarations.
+
+    Open addressing with linear probing, keys are node addresses.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#ifndef ahocorasick_nodemap_h_included
+#define ahocorasick_nodemap_h_included
+
+#include "common.h"
+#include "trienode.h"
+
+typedef struct NodeMapItem {
+    TrieNode*   key;    ///< NULL marks an empty slot
+    void*       value;
+} NodeMapItem;
+
+
+typedef struct NodeMap {
+    size_t          count;  ///< number of keys
+    size_t          mask;   ///< size of table - 1, size is a power of two
+    NodeMapItem*    items;
+} NodeMap;
+
+
+/** Initialize map able to keep capacity keys without resizing. */
+static bool
+nodemap_init(NodeMap* map, size_t capacity);
+
+/** Release memory. */
+static void
+nodemap_free(NodeMap* map);
+
+/** Returns item for the key or NULL. */
+static NodeMapItem* PURE
+nodemap_get(NodeMap* map, TrieNode* key);
+
+/** Insert key (if not present) and return its item; NULL on memory error.
+    The value of a new item is NULL. */
+static NodeMapItem*
+nodemap_put(NodeMap* map, TrieNode* key);
+
+#endif
@@ -0,0 +1,127 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Map from trie nodes to 64-bit masks implementation.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#include "nodemasks.h"
+
+
+static void
+nodemasks_init(NodeMasks* masks) {
+
+    masks->map.items = NULL;
+    masks->map.mask  = 0;
+    masks->map.count = 0;
+    masks->masks     = NULL;
+    masks->count     = 0;
+    masks->capacity  = 0;
+}
+
+
+static void
+nodemasks_free(NodeMasks* masks) {
+
+    if (masks->map.items != NULL) {
+        nodemap_free(&masks->map);
+    }
+
+    memory_safefree(masks->masks);
+    nodemasks_init(masks);
+}
+
+
+static uint64_t* PURE
+nodemasks_get(const NodeMasks* masks, TrieNode* node) {
+
+    NodeMapItem* item;
+
+    if (masks->count == 0) {
+        return NULL;
+    }
+
+    item = nodemap_get((NodeMap*)&masks->map, node);
+    if (item == NULL) {
+        return NULL;
+    }
+
+    return &masks->masks[(Py_uintptr_t)item->value - 1];
+}
+
+
+static bool
+nodemasks_reserve(NodeMasks* masks, size_t count) {
+
+    uint64_t* tmp;
+    size_t capacity;
+
+    if (masks->map.items == NULL and UNLIKELY(!nodemap_init(&masks->map, count))) {
+        return false;
+    }
+
+    if (masks->capacity - masks->count < count) {
+        capacity = (masks->capacity > 0) ? 2 * masks->capacity : 16;
+        if (capacity < masks->count + count) {
+            capacity = masks->count + count;
+        }
+
+        tmp = (uint64_t*)memory_realloc(masks->masks, capacity * sizeof(uint64_t));
+        if (UNLIKELY(tmp == NULL)) {
+            return false;
+        }
+
+        masks->masks    = tmp;
+        masks->capacity = capacity;
+    }
+
+    // the same condition as in nodemap_put
+    while (2 * (masks->map.count + count) > masks->map.mask + 1) {
+        if (UNLIKELY(!nodemap_grow(&masks->map))) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static uint64_t*
+nodemasks_put(NodeMasks* masks, TrieNode* node) {
+
+    NodeMapItem* item;
+
+    if (UNLIKELY(!nodemasks_reserve(masks, 1))) {
+        return NULL;
+    }
+
+    item = nodemap_put(&masks->map, node);
+    if (UNLIKELY(item == NULL)) {
+        return NULL;
+    }
+
+    // values are indices + 1, a new item has NULL
+    if (item->value == NULL) {
+        masks->masks[masks->count] = 0;
+        masks->count += 1;
+        item->value = (void*)(Py_uintptr_t)masks->count;
+    }
+
+    return &masks->masks[(Py_uintptr_t)item->value - 1];
+}
+
+
+static size_t
+nodemasks_memory(const NodeMasks* masks) {
+
+    size_t size;
+
+    size = masks->capacity * sizeof(uint64_t);
+    if (masks->map.items != NULL) {
+        size += (masks->map.mask + 1) * sizeof(NodeMapItem);
+    }
+
+    return size;
+}
@@ -0,0 +1,52 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Map from trie nodes to 64-bit masks declarations.
+
+    Masks are kept in an array, the node map keeps indices in the
+    array, thus masks are 64-bit on every platform. An empty map
+    doesn't allocate memory.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#ifndef ahocorasick_nodemasks_h_included
+#define ahocorasick_nodemasks_h_included
+
+#include "common.h"
+#include "nodemap.h"
+
+typedef struct NodeMasks {
+    NodeMap     map;        ///< node => index in masks + 1; items are NULL when empty
+    uint64_t*   masks;
+    size_t      count;      ///< number of masks
+    size_t      capacity;   ///< allocated masks
+} NodeMasks;
+
+
+/** Initialize an empty map. */
+static void
+nodemasks_init(NodeMasks* masks);
+
+/** Release memory. */
+static void
+nodemasks_free(NodeMasks* masks);
+
+/** Returns pointer to the mask of a node or NULL. */
+static uint64_t* PURE
+nodemasks_get(const NodeMasks* masks, TrieNode* node);
+
+/** Make sure that masks of count new nodes can be put without memory allocation. */
+static bool
+nodemasks_reserve(NodeMasks* masks, size_t count);
+
+/** Returns pointer to the mask of a node, a new mask is 0; NULL on memory error. */
+static uint64_t*
+nodemasks_put(NodeMasks* masks, TrieNode* node);
+
+/** Returns the number of allocated bytes. */
+static size_t
+nodemasks_memory(const NodeMasks* masks);
+
+#endif
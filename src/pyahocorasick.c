@@ -14,10 +14,16 @@
 #include "slist.h"
 #include "trienode.h"
 #include "trie.h"
+#include "nodemap.h"
+#include "nodemasks.h"
+#include "valuetable.h"
+#include "valuecolumn.h"
 #include "Automaton.h"
 #include "AutomatonSearchIter.h"
 #include "AutomatonSearchIterLong.h"
 #include "AutomatonItemsIter.h"
+#include "AutomatonSet.h"
+#include "AutomatonSetSearchIter.h"
 #include "inline_doc.h"
 #include "custompickle/load/module_automaton_load.h"
 
@@ -25,11 +31,17 @@
 #include "utils.c"
 #include "trienode.c"
 #include "trie.c"
+#include "nodemap.c"
+#include "nodemasks.c"
+#include "valuetable.c"
+#include "valuecolumn.c"
 #include "slist.c"
 #include "Automaton.c"
 #include "AutomatonItemsIter.c"
 #include "AutomatonSearchIter.c"
 #include "AutomatonSearchIterLong.c"
+#include "AutomatonSet.c"
+#include "AutomatonSetSearchIter.c"
 #ifdef PYCALLS_INJECT_FAULTS
 #include "pycallfault/pycallfault.c"
 #endif
@@ -40,6 +52,7 @@ static
 PyMethodDef
 ahocorasick_module_methods[] = {
     {"load", module_automaton_load, METH_VARARGS, module_load_doc},
+    {"load_bytes", module_automaton_load_bytes, METH_VARARGS, module_load_bytes_doc},
 
     {NULL, NULL, 0, NULL}
 };
@@ -110,6 +123,13 @@ init_function(void) {
     else
         PyModule_AddObject(module, "Automaton", (PyObject*)&automaton_type);
 
+    if (PyType_Ready(&automaton_set_type) < 0) {
+        Py_DECREF(module);
+        init_return(NULL);
+    }
+    else
+        PyModule_AddObject(module, "AutomatonSet", (PyObject*)&automaton_set_type);
+
 #define add_enum_const(name) PyModule_AddIntConstant(module, #name, name)
     add_enum_const(TRIE);
     add_enum_const(AHOCORASICK);
@@ -118,6 +138,11 @@ init_function(void) {
     add_enum_const(STORE_LENGTH);
     add_enum_const(STORE_INTS);
     add_enum_const(STORE_ANY);
+    add_enum_const(STORE_BYTES);
+    add_enum_const(STORE_INT64);
+    add_enum_const(STORE_FLOAT);
+    add_enum_const(STORE_KEY_ID);
+    add_enum_const(STORE_MULTI_INTS);
 
     add_enum_const(KEY_STRING);
     add_enum_const(KEY_SEQUENCE);
@@ -125,6 +150,12 @@ init_function(void) {
     add_enum_const(MATCH_EXACT_LENGTH);
     add_enum_const(MATCH_AT_MOST_PREFIX);
     add_enum_const(MATCH_AT_LEAST_PREFIX);
+
+    add_enum_const(ENGINE_AUTO);
+    add_enum_const(ENGINE_TRIE);
+    add_enum_const(ENGINE_LETTERS);
+    add_enum_const(ENGINE_BIGRAMS);
+    add_enum_const(ENGINE_SHIFTS);
 #undef add_enum_const
 
 #ifdef AHOCORASICK_UNICODE
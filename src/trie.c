@@ -14,9 +14,23 @@
 static TrieNode*
 trie_add_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_t wordlen, bool* new_word) {
 
+    return trie_add_word_with_path(automaton, word, wordlen, 0, NULL, new_word);
+}
+
+
+static TrieNode*
+trie_add_word_with_path(
+    Automaton* automaton,
+    const TRIE_LETTER_TYPE* word,
+    const size_t wordlen,
+    const size_t prefix,
+    TrieNode** path,
+    bool* new_word
+) {
+
     TrieNode* node;
     TrieNode* child;
-    unsigned i;
+    size_t i;
 
     if (automaton->kind == EMPTY) {
         ASSERT(automaton->root == NULL);
@@ -25,15 +39,23 @@ trie_add_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_t w
             return NULL;
     }
 
-    node = automaton->root;
+    if (path != NULL) {
+        ASSERT(prefix <= wordlen);
+        path[0] = automaton->root;
+        node = path[prefix];
+    } else {
+        ASSERT(prefix == 0);
+        node = automaton->root;
+    }
 
-    for (i=0; i < wordlen; i++) {
+    for (i=prefix; i < wordlen; i++) {
         const TRIE_LETTER_TYPE letter = word[i];
 
         child = trienode_get_next(node, letter);
         if (child == NULL) {
             child = trienode_new(false);
             if (LIKELY(child != NULL)) {
+                child->depth = trienode_child_depth(node);
                 if (UNLIKELY(trienode_set_next(node, letter, child) == NULL)) {
                     memory_free(child);
                     return NULL;
@@ -47,6 +69,9 @@ trie_add_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_t w
         }
 
         node = child;
+        if (path != NULL) {
+            path[i + 1] = node;
+        }
     }
 
     if (node->eow == false) {
@@ -63,6 +88,26 @@ trie_add_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_t w
 }
 
 
+static void
+trie_free_node(Automaton* automaton, TrieNode* node) {
+
+    const bool pooled_edges = automaton->edges_pool != NULL
+                          and node->next >= automaton->edges_pool
+                          and node->next < automaton->edges_pool + automaton->edges_pool_size;
+
+    if (node->n > 0 and !pooled_edges) {
+        memory_free(node->next);
+    }
+
+    node->n    = 0;
+    node->next = NULL;
+
+    if (automaton->pool == NULL or node < automaton->pool or node >= automaton->pool + automaton->pool_size) {
+        memory_free(node);
+    }
+}
+
+
 static PyObject*
 trie_remove_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_t wordlen) {
 
@@ -101,7 +146,10 @@ trie_remove_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_
         return NULL;
     }
 
-    object = node->output.object;
+    object = automaton_build_value(automaton, node);
+    if (UNLIKELY(object == NULL)) {
+        return NULL;
+    }
 
     if (trienode_is_leaf(node)) {
         // Remove a linear list that starts at the last_multiway node
@@ -112,22 +160,25 @@ trie_remove_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_
         ASSERT(node != NULL);
 
         if (UNLIKELY(trienode_unset_next_pointer(last_multiway, node) == MEMORY_ERROR)) {
+            Py_DECREF(object);
             PyErr_NoMemory();
             return NULL;
         }
 
-        // 2. Free the tail (reference to value from the last element was already saved)
+        // 2. Free the tail (the value of the last element was already saved)
         for (i = last_multiway_index + 1; i < wordlen; i++) {
             tmp = trienode_get_next(node, word[i]);
             ASSERT(tmp->n <= 1);
-            trienode_free(node);
+            trie_free_node(automaton, node);
             node = tmp;
         }
 
-        trienode_free(node);
+        automaton_remove_value(automaton, node);
+        trie_free_node(automaton, node);
 
     } else {
         // just unmark the terminating node
+        automaton_remove_value(automaton, node);
         node->eow = false;
     }
 
@@ -174,25 +225,6 @@ trie_longest(TrieNode* root, const TRIE_LETTER_TYPE* word, const size_t wordlen)
 }
 
 
-static TrieNode* PURE
-ahocorasick_next(TrieNode* node, TrieNode* root, const TRIE_LETTER_TYPE letter) {
-    TrieNode* next = node;
-    TrieNode* tmp;
-
-    while (next) {
-        tmp = trienode_get_next(next, letter);
-        if (tmp)
-            // found link
-            return tmp;
-        else
-            // or go back through fail edges
-            next = next->fail;
-    }
-
-    // or return root node
-    return root;
-}
-
 static int
 trie_traverse_aux(
     TrieNode* node,
@@ -225,6 +257,19 @@ trie_traverse(
 }
 
 
+static int
+trie_set_depth_aux(TrieNode* node, const int depth, void* extra) {
+    node->depth = ((unsigned)depth < TRIENODE_MAX_DEPTH) ? (unsigned)depth : TRIENODE_MAX_DEPTH;
+    return 1;
+}
+
+
+static void
+trie_set_depths(TrieNode* root) {
+    trie_traverse(root, trie_set_depth_aux, NULL);
+}
+
+
 size_t PURE
 trienode_get_size(const TrieNode* node) {
     return sizeof(TrieNode) + node->n * sizeof(TrieNode*);
@@ -19,7 +19,29 @@
 static TrieNode*
 trie_add_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_t wordlen, bool* new_word);
 
-/* remove word from a trie, returns associated object if was any */
+/* add new word to a trie, like trie_add_word; path[i] is the node reached
+   after i letters of the word. The first prefix + 1 entries of path must
+   have been filled by a previous call for a word sharing the first prefix
+   letters, the remaining ones are updated */
+static TrieNode*
+trie_add_word_with_path(
+    Automaton* automaton,
+    const TRIE_LETTER_TYPE* word,
+    const size_t wordlen,
+    const size_t prefix,
+    TrieNode** path,
+    bool* new_word
+);
+
+/* free node; memory of a node that belongs to the automaton's pool,
+   or of edges that belong to the edges pool, is released along with
+   the pool */
+static void
+trie_free_node(Automaton* automaton, TrieNode* node);
+
+/* remove word from a trie, returns a new reference to the associated
+   value (a new object unless the store is STORE_ANY) or NULL
+   if the word wasn't there */
 static PyObject*
 trie_remove_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_t wordlen);
 
@@ -27,11 +49,6 @@ trie_remove_word(Automaton* automaton, const TRIE_LETTER_TYPE* word, const size_
 static TrieNode* PURE
 trie_find(TrieNode* root, const TRIE_LETTER_TYPE* word, const size_t wordlen);
 
-/* returns node linked by edge labeled with letter including paths going
-   through fail links */
-static TrieNode* PURE
-ahocorasick_next(TrieNode* node, TrieNode* root, const TRIE_LETTER_TYPE letter);
-
 typedef int (*trie_traverse_callback)(TrieNode* node, const int depth, void* extra);
 
 /* traverse trie in DFS order, for each node callback is called
@@ -43,6 +60,11 @@ trie_traverse(
     void *extra
 );
 
+/* sets depth of all nodes of a trie (not a minimized DAG), used when
+   nodes are restored from a format that doesn't keep depths */
+static void
+trie_set_depths(TrieNode* root);
+
 /* returns total size of node and it's internal structures */
 size_t PURE
 trienode_get_size(const TrieNode* node);
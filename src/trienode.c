@@ -14,12 +14,12 @@ static TrieNode*
 trienode_new(const char eow) {
     TrieNode* node = (TrieNode*)memory_alloc(sizeof(TrieNode));
     if (node) {
-        node->output.integer = 0;
-        node->output.object = NULL;
+        node->output = 0;
         node->fail      = NULL;
 
         node->n     = 0;
         node->eow       = eow;
+        node->depth = 0;
         node->next  = NULL;
     }
 
@@ -157,7 +157,8 @@ void trienode_dump_layout() {
     field_dump(TrieNode, output);
     field_dump(TrieNode, fail);
     field_dump(TrieNode, n);
-    field_dump(TrieNode, eow);
+    // eow and depth are bit fields sharing a word right after n
+    printf("- %-12s: %d %d\n", "eow, depth", (int)sizeof(uint32_t), (int)(field_ofs(TrieNode, n) + field_size(TrieNode, n)));
     field_dump(TrieNode, next);
 
     printf("Pair (size=%lu):\n", sizeof(Pair));
@@ -183,7 +184,7 @@ trienode_dump_to_file(TrieNode* node, FILE* f) {
 
     fprintf(f, "node %p\n", node);
     if (node->eow)
-        fprintf(f, "- eow [%p]\n", node->output.object);
+        fprintf(f, "- eow [%lu]\n", (unsigned long)node->output);
 
     fprintf(f, "- fail: %p\n", node->fail);
     if (node->n > 0) {
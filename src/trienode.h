@@ -26,10 +26,7 @@ typedef struct Pair {
 
 /* links to children nodes are stored in dynamic table */
 typedef struct TrieNode {
-    union {
-        PyObject*   object;     ///< valid when kind = STORE_ANY
-        Py_uintptr_t integer;   ///< valid when kind in [STORE_LENGTH, STORE_INTS]
-    } output; ///< output function, valid when eow is true
+    Py_uintptr_t        output; ///< output function, valid when eow is true: a value (STORE_LENGTH, STORE_INTS) or an index in the automaton's value table (STORE_ANY)
     struct TrieNode*    fail;   ///< fail node
 
 #if TRIE_LETTER_SIZE == 1
@@ -37,11 +34,18 @@ typedef struct TrieNode {
 #else
     uint32_t            n;      ///< length of next
 #endif
-    uint8_t             eow;    ///< end of word marker
+    uint32_t            eow:8;  ///< end of word marker
+    uint32_t            depth:24; ///< length of the path from the root, saturated at TRIENODE_MAX_DEPTH; fills the padding after eow
     Pair*               next;   ///< table of letters and associated next pointers
 } TrieNode;
 
 
+#define TRIENODE_MAX_DEPTH ((1u << 24) - 1)
+
+/* depth of a child of given node */
+#define trienode_child_depth(node) ((node)->depth < TRIENODE_MAX_DEPTH ? (node)->depth + 1u : TRIENODE_MAX_DEPTH)
+
+
 typedef enum {
     MEMORY_ERROR,
     TRUE,
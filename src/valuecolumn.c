@@ -0,0 +1,282 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Column of native values associated with keys (STORE_BYTES,
+    STORE_INT64, STORE_FLOAT) implementation.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#include "valuecolumn.h"
+
+
+static void
+valuecolumn_init(ValueColumn* column, bool bytes) {
+
+    column->items         = NULL;
+    column->lengths       = NULL;
+    column->size          = 0;
+    column->capacity      = 0;
+    column->free          = VALUECOLUMN_NONE;
+    column->count         = 0;
+
+    column->data          = NULL;
+    column->data_size     = 0;
+    column->data_capacity = 0;
+    column->garbage       = 0;
+
+    column->bytes         = bytes;
+}
+
+
+static bool
+valuecolumn_reserve_slots(ValueColumn* column, size_t count) {
+
+    uint64_t* items;
+    uint32_t* lengths;
+    size_t capacity;
+
+    // free slots are also available
+    if (column->capacity - column->count >= count) {
+        return true;
+    }
+
+    capacity = (column->capacity > 0) ? 2 * column->capacity : 16;
+    if (capacity < column->count + count) {
+        capacity = column->count + count;
+    }
+
+    items = (uint64_t*)memory_realloc(column->items, capacity * sizeof(uint64_t));
+    if (UNLIKELY(items == NULL)) {
+        return false;
+    }
+
+    column->items = items;
+
+    if (column->bytes) {
+        lengths = (uint32_t*)memory_realloc(column->lengths, capacity * sizeof(uint32_t));
+        if (UNLIKELY(lengths == NULL)) {
+            // the larger items array is fine, capacity is not changed
+            return false;
+        }
+
+        column->lengths = lengths;
+    }
+
+    column->capacity = capacity;
+
+    return true;
+}
+
+
+static bool
+valuecolumn_reserve_data(ValueColumn* column, size_t length) {
+
+    char* data;
+    size_t live;
+    size_t capacity;
+    size_t offset;
+    size_t i;
+
+    if (column->data_size + length <= column->data_capacity) {
+        return true;
+    }
+
+    live = column->data_size - column->garbage;
+    if (column->garbage > live) {
+        // mostly removed values: copy live values into a new arena
+        capacity = 2 * (live + length);
+        data = (char*)memory_alloc(capacity);
+        if (UNLIKELY(data == NULL)) {
+            return false;
+        }
+
+        offset = 0;
+        for (i=0; i < column->size; i++) {
+            if (column->lengths[i] != VALUECOLUMN_FREE) {
+                memcpy(data + offset, column->data + column->items[i], column->lengths[i]);
+                column->items[i] = offset;
+                offset += column->lengths[i];
+            }
+        }
+
+        memory_safefree(column->data);
+        column->data_size = offset;
+        column->garbage   = 0;
+    } else {
+        capacity = (column->data_capacity > 0) ? 2 * column->data_capacity : 1024;
+        if (capacity < column->data_size + length) {
+            capacity = column->data_size + length;
+        }
+
+        data = (char*)memory_realloc(column->data, capacity);
+        if (UNLIKELY(data == NULL)) {
+            return false;
+        }
+    }
+
+    column->data          = data;
+    column->data_capacity = capacity;
+
+    return true;
+}
+
+
+static bool
+valuecolumn_reserve(ValueColumn* column, size_t count, size_t length) {
+
+    if (UNLIKELY(!valuecolumn_reserve_slots(column, count))) {
+        return false;
+    }
+
+    return !column->bytes or valuecolumn_reserve_data(column, length);
+}
+
+
+static size_t
+valuecolumn_acquire_slot(ValueColumn* column) {
+
+    size_t index;
+
+    ASSERT(column->count < column->capacity);
+
+    if (column->free != VALUECOLUMN_NONE) {
+        index = column->free;
+        column->free = (size_t)column->items[index];
+    } else {
+        index = column->size;
+        column->size += 1;
+    }
+
+    column->count += 1;
+
+    return index;
+}
+
+
+static void
+valuecolumn_add(ValueColumn* column, uint64_t value, size_t* index) {
+
+    ASSERT(!column->bytes);
+
+    *index = valuecolumn_acquire_slot(column);
+    column->items[*index] = value;
+}
+
+
+static void
+valuecolumn_store_bytes(ValueColumn* column, size_t index, const char* data, size_t length) {
+
+    ASSERT(length <= VALUECOLUMN_MAX_LENGTH);
+    ASSERT(column->data_size + length <= column->data_capacity);
+
+    if (length > 0) {
+        memcpy(column->data + column->data_size, data, length);
+    }
+
+    column->items[index]   = column->data_size;
+    column->lengths[index] = (uint32_t)length;
+    column->data_size     += length;
+}
+
+
+static void
+valuecolumn_add_bytes(ValueColumn* column, const char* data, size_t length, size_t* index) {
+
+    ASSERT(column->bytes);
+
+    *index = valuecolumn_acquire_slot(column);
+    valuecolumn_store_bytes(column, *index, data, length);
+}
+
+
+static void
+valuecolumn_replace(ValueColumn* column, size_t index, uint64_t value) {
+
+    ASSERT(!column->bytes);
+    ASSERT(index < column->size);
+
+    column->items[index] = value;
+}
+
+
+static void
+valuecolumn_replace_bytes(ValueColumn* column, size_t index, const char* data, size_t length) {
+
+    ASSERT(column->bytes);
+    ASSERT(index < column->size and column->lengths[index] != VALUECOLUMN_FREE);
+
+    column->garbage += column->lengths[index];
+    valuecolumn_store_bytes(column, index, data, length);
+}
+
+
+static void
+valuecolumn_append_bytes(ValueColumn* column, size_t index, const char* data, size_t length) {
+
+    const size_t old = column->lengths[index];
+
+    ASSERT(column->bytes);
+    ASSERT(index < column->size and column->lengths[index] != VALUECOLUMN_FREE);
+    ASSERT(old + length <= VALUECOLUMN_MAX_LENGTH);
+    ASSERT(column->data_size + old + length <= column->data_capacity);
+
+    if (column->items[index] + old == column->data_size) {
+        // the last string in the arena grows in place
+        memcpy(column->data + column->data_size, data, length);
+        column->data_size += length;
+    } else {
+        // the old string is copied to the end of the arena, like a replaced one
+        memmove(column->data + column->data_size, column->data + column->items[index], old);
+        memcpy(column->data + column->data_size + old, data, length);
+
+        column->garbage      += old;
+        column->items[index]  = column->data_size;
+        column->data_size    += old + length;
+    }
+
+    column->lengths[index] = (uint32_t)(old + length);
+}
+
+
+static void
+valuecolumn_remove(ValueColumn* column, size_t index) {
+
+    ASSERT(index < column->size);
+
+    if (column->bytes) {
+        ASSERT(column->lengths[index] != VALUECOLUMN_FREE);
+        column->garbage += column->lengths[index];
+        column->lengths[index] = VALUECOLUMN_FREE;
+    }
+
+    column->items[index] = column->free;
+    column->free   = index;
+    column->count -= 1;
+}
+
+
+static size_t
+valuecolumn_memory(const ValueColumn* column) {
+
+    size_t size;
+
+    size = column->capacity * sizeof(uint64_t) + column->data_capacity;
+    if (column->bytes) {
+        size += column->capacity * sizeof(uint32_t);
+    }
+
+    return size;
+}
+
+
+static void
+valuecolumn_clear(ValueColumn* column) {
+
+    memory_safefree(column->items);
+    memory_safefree(column->lengths);
+    memory_safefree(column->data);
+
+    valuecolumn_init(column, column->bytes);
+}
@@ -0,0 +1,94 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Column of native values associated with keys (STORE_BYTES,
+    STORE_INT64, STORE_FLOAT) declarations.
+
+    Integers and floats are kept as 64-bit words, byte strings are
+    kept in a single arena; a node keeps only an index in the column.
+    Python objects are created when a value is returned. Slots of
+    removed values are reused, the arena is compacted when more than
+    a half of it is occupied by removed values.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#ifndef ahocorasick_valuecolumn_h_included
+#define ahocorasick_valuecolumn_h_included
+
+#include "common.h"
+
+typedef struct ValueColumn {
+    uint64_t*   items;          ///< values or, for byte strings, offsets in data; a free slot keeps the next free slot
+    uint32_t*   lengths;        ///< lengths of byte strings, VALUECOLUMN_FREE marks a free slot
+    size_t      size;           ///< number of used and free slots
+    size_t      capacity;       ///< number of allocated slots
+    size_t      free;           ///< the first free slot or VALUECOLUMN_NONE
+    size_t      count;          ///< number of values
+
+    char*       data;           ///< arena of byte strings
+    size_t      data_size;      ///< used bytes of the arena
+    size_t      data_capacity;  ///< allocated bytes of the arena
+    size_t      garbage;        ///< bytes of the arena occupied by removed values
+
+    bool        bytes;          ///< values are byte strings
+} ValueColumn;
+
+#define VALUECOLUMN_NONE ((size_t)-1)
+#define VALUECOLUMN_FREE ((uint32_t)-1)
+#define VALUECOLUMN_MAX_LENGTH ((size_t)VALUECOLUMN_FREE - 1)
+
+/** Returns the value (a 64-bit word) with given index. */
+#define valuecolumn_get(column, index) ((column)->items[index])
+
+/** Returns pointer to the byte string with given index. */
+#define valuecolumn_get_bytes(column, index) ((column)->data + (column)->items[index])
+
+/** Returns length of the byte string with given index. */
+#define valuecolumn_get_length(column, index) ((size_t)(column)->lengths[index])
+
+
+/** Initialize an empty column. */
+static void
+valuecolumn_init(ValueColumn* column, bool bytes);
+
+/** Make sure that next count values having in total length bytes
+    can be added or replaced without memory allocation. */
+static bool
+valuecolumn_reserve(ValueColumn* column, size_t count, size_t length);
+
+/** Add a 64-bit value and store its index; space must be reserved. */
+static void
+valuecolumn_add(ValueColumn* column, uint64_t value, size_t* index);
+
+/** Add a byte string and store its index; space must be reserved. */
+static void
+valuecolumn_add_bytes(ValueColumn* column, const char* data, size_t length, size_t* index);
+
+/** Replace a 64-bit value with given index. */
+static void
+valuecolumn_replace(ValueColumn* column, size_t index, uint64_t value);
+
+/** Replace a byte string with given index; space must be reserved. */
+static void
+valuecolumn_replace_bytes(ValueColumn* column, size_t index, const char* data, size_t length);
+
+/** Append a byte string to the byte string with given index; space
+    for both must be reserved. */
+static void
+valuecolumn_append_bytes(ValueColumn* column, size_t index, const char* data, size_t length);
+
+/** Remove value with given index. */
+static void
+valuecolumn_remove(ValueColumn* column, size_t index);
+
+/** Returns the number of allocated bytes. */
+static size_t
+valuecolumn_memory(const ValueColumn* column);
+
+/** Release all values and memory. */
+static void
+valuecolumn_clear(ValueColumn* column);
+
+#endif
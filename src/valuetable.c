@@ -0,0 +1,134 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Table of python objects associated with keys (STORE_ANY) implementation.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#include "valuetable.h"
+
+// objects are aligned, thus the lowest bit marks a free slot
+#define valuetable_is_free(object) (((Py_uintptr_t)(object)) & 1)
+#define valuetable_encode_free(index) ((PyObject*)(((Py_uintptr_t)(index) << 1) | 1))
+#define valuetable_decode_free(object) ((size_t)(((Py_uintptr_t)(object)) >> 1))
+
+
+static void
+valuetable_init(ValueTable* table) {
+
+    table->items    = NULL;
+    table->size     = 0;
+    table->capacity = 0;
+    table->free     = VALUETABLE_NONE;
+    table->count    = 0;
+}
+
+
+static bool
+valuetable_reserve(ValueTable* table, size_t count) {
+
+    PyObject** items;
+    size_t capacity;
+
+    // free slots are also available
+    if (table->capacity - table->count >= count) {
+        return true;
+    }
+
+    capacity = (table->capacity > 0) ? 2 * table->capacity : 16;
+    if (capacity < table->count + count) {
+        capacity = table->count + count;
+    }
+
+    items = (PyObject**)memory_realloc(table->items, capacity * sizeof(PyObject*));
+    if (UNLIKELY(items == NULL)) {
+        return false;
+    }
+
+    table->items    = items;
+    table->capacity = capacity;
+
+    return true;
+}
+
+
+static bool
+valuetable_add(ValueTable* table, PyObject* value, size_t* index) {
+
+    if (UNLIKELY(!valuetable_reserve(table, 1))) {
+        return false;
+    }
+
+    if (table->free != VALUETABLE_NONE) {
+        *index = table->free;
+        table->free = valuetable_decode_free(table->items[*index]);
+    } else {
+        *index = table->size;
+        table->size += 1;
+    }
+
+    Py_INCREF(value);
+    table->items[*index] = value;
+    table->count += 1;
+
+    return true;
+}
+
+
+static void
+valuetable_replace(ValueTable* table, size_t index, PyObject* value) {
+
+    PyObject* old;
+
+    ASSERT(index < table->size and !valuetable_is_free(table->items[index]));
+
+    old = table->items[index];
+    Py_INCREF(value);
+    table->items[index] = value;
+    Py_DECREF(old);
+}
+
+
+static PyObject*
+valuetable_remove(ValueTable* table, size_t index) {
+
+    PyObject* value;
+
+    ASSERT(index < table->size and !valuetable_is_free(table->items[index]));
+
+    value = table->items[index];
+    table->items[index] = valuetable_encode_free(table->free);
+    table->free   = index;
+    table->count -= 1;
+
+    return value;
+}
+
+
+static void
+valuetable_clear(ValueTable* table) {
+
+    PyObject** items;
+    size_t size;
+    size_t i;
+
+    // destructors of values might run arbitrary code, the table
+    // must be already empty then
+    items = table->items;
+    size  = table->size;
+    valuetable_init(table);
+
+    for (i=0; i < size; i++) {
+        if (!valuetable_is_free(items[i])) {
+            Py_DECREF(items[i]);
+        }
+    }
+
+    memory_safefree(items);
+}
+
+#undef valuetable_is_free
+#undef valuetable_encode_free
+#undef valuetable_decode_free
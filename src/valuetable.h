@@ -0,0 +1,57 @@
+/*
+    This is part of pyahocorasick Python module.
+
+    Table of python objects associated with keys (STORE_ANY) declarations.
+
+    A node keeps only an index in the table, thus nodes are plain data:
+    they can be copied, saved or shared without touching reference
+    counters. Slots of removed values are reused.
+
+    Author    : Wojciech Muła, wojciech_mula@poczta.onet.pl
+    WWW       : http://0x80.pl
+    License   : BSD-3-Clause (see LICENSE)
+*/
+#ifndef ahocorasick_valuetable_h_included
+#define ahocorasick_valuetable_h_included
+
+#include "common.h"
+
+typedef struct ValueTable {
+    PyObject**  items;      ///< values; a free slot keeps a tagged index of the next free slot
+    size_t      size;       ///< number of used and free slots
+    size_t      capacity;   ///< number of allocated slots
+    size_t      free;       ///< the first free slot or VALUETABLE_NONE
+    size_t      count;      ///< number of values
+} ValueTable;
+
+#define VALUETABLE_NONE (((size_t)-1) >> 1)
+
+/** Returns borrowed reference to the value with given index. */
+#define valuetable_get(table, index) ((table)->items[index])
+
+
+/** Initialize an empty table. */
+static void
+valuetable_init(ValueTable* table);
+
+/** Make sure that next count values can be added without memory allocation. */
+static bool
+valuetable_reserve(ValueTable* table, size_t count);
+
+/** Add value (a new reference is taken) and store its index; false on memory error. */
+static bool
+valuetable_add(ValueTable* table, PyObject* value, size_t* index);
+
+/** Replace value with given index, the old value is released. */
+static void
+valuetable_replace(ValueTable* table, size_t index, PyObject* value);
+
+/** Remove value with given index, the table's reference is passed to the caller. */
+static PyObject*
+valuetable_remove(ValueTable* table, size_t index);
+
+/** Release all values and memory. */
+static void
+valuetable_clear(ValueTable* table);
+
+#endif
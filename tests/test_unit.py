@@ -190,7 +190,12 @@ class TestTrieMethods(TestTrieStorePyObjectsBase):
             'sizeof_node': platform_dependent,
             'nodes_count': 25,
             'words_count': 5,
-            'links_count': 24
+            'links_count': 24,
+            'engine': ahocorasick.ENGINE_TRIE,
+            'alphabet_size': 0,
+            'cache_size': 0,
+            'cache_hits': 0,
+            'cache_misses': 0
         }
 
         s = A.get_stats()
@@ -207,9 +212,11 @@ class TestTrieMethods(TestTrieStorePyObjectsBase):
         s = self.A.get_stats()
         self.assertTrue(len(s) > 0)
         for key in s:
-            if key != "sizeof_node":
+            if key not in ("sizeof_node", "engine"):
                 self.assertEqual(s[key], 0)
 
+        self.assertEqual(s["engine"], ahocorasick.ENGINE_TRIE)
+
 
 class TestTrieRemoveWord(TestTrieStorePyObjectsBase):
 
@@ -296,6 +303,72 @@ class TestTrieRemoveWord(TestTrieStorePyObjectsBase):
         self.assertEqual(ahocorasick.TRIE, A.kind)
 
 
+class TestTrieAddWords(TestCase):
+
+    def test_add_words_same_as_add_word(self):
+        words = "he she his hers h a ab abc b bc she he".split()
+        pairs = [(conv(w), i) for i, w in enumerate(words)]
+
+        A = ahocorasick.Automaton()
+        self.assertEqual(10, A.add_words(pairs))
+
+        B = ahocorasick.Automaton()
+        for key, value in pairs:
+            B.add_word(key, value)
+
+        self.assertEqual(len(B), len(A))
+        self.assertEqual(sorted(B.items()), sorted(A.items()))
+        self.assertEqual(B.get_stats(), A.get_stats())
+        self.assertEqual(ahocorasick.TRIE, A.kind)
+
+    def test_add_words_store_ints_default_values(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        A.add_word(conv("zoo"))
+        self.assertEqual(3, A.add_words([conv("cat"), (conv("dog"), 42), conv("bee"), (conv("cat"), 7)]))
+
+        self.assertEqual(1, A.get(conv("zoo")))
+        self.assertEqual(7, A.get(conv("cat")))
+        self.assertEqual(42, A.get(conv("dog")))
+        self.assertEqual(4, A.get(conv("bee")))
+
+    def test_add_words_store_ints_key_sequence(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS, ahocorasick.KEY_SEQUENCE)
+        self.assertEqual(2, A.add_words([((1, 2), 3), ((1, 2, 3), 4)]))
+        self.assertEqual(3, A.get((1, 2)))
+        self.assertEqual(4, A.get((1, 2, 3)))
+
+        # a bare key would be ambiguous with a pair
+        for item in [(1, 2, 3), (4, 5)]:
+            with self.assertRaises(TypeError):
+                A.add_words([item])
+
+        self.assertEqual(2, len(A))
+
+    def test_add_words_store_length(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_LENGTH)
+        self.assertEqual(3, A.add_words(conv(w) for w in ["cat", "", "horse", "a"]))
+
+        self.assertEqual(3, A.get(conv("cat")))
+        self.assertEqual(5, A.get(conv("horse")))
+        self.assertEqual(1, A.get(conv("a")))
+
+    def test_add_words_invalid_item_does_not_modify(self):
+        A = ahocorasick.Automaton()
+        with self.assertRaisesRegex(TypeError, "A \\(key, value\\) tuple is expected."):
+            A.add_words([(conv("cat"), 1), conv("dog")])
+
+        self.assertEqual(ahocorasick.EMPTY, A.kind)
+        self.assertEqual(0, len(A))
+
+    def test_add_words_invalidates_iterators(self):
+        A = ahocorasick.Automaton()
+        A.add_word(conv("cat"), 1)
+        it = A.keys()
+        A.add_words([(conv("dog"), 2)])
+        with self.assertRaises(ValueError):
+            next(it)
+
+
 class TestTriePop(TestTrieStorePyObjectsBase):
 
     def test_pop_from_empty_trie(self):
@@ -317,6 +390,15 @@ class TestTriePop(TestTrieStorePyObjectsBase):
             expected_len -= 1
             self.assertEqual(expected_len, len(A))
 
+    def test_pop_ints(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        A.add_word(conv("he"), 0)
+        A.add_word(conv("her"), 42)
+
+        self.assertTrue(A.remove_word(conv("he")))
+        self.assertEqual(42, A.pop(conv("her")))
+        self.assertEqual(0, len(A))
+
     def test_pop_inexisting_word(self):
         A = self.A
 
@@ -878,6 +960,217 @@ class TestAutomatonIterInvalidate(TestAutomatonBase):
         with self.assertRaises(ValueError):
             w = next(it)
 
+    def test_find_all_callback_modifies_automaton(self):
+        for compact in [False, True]:
+            for modify in [lambda A: A.add_word(conv("xyz"), "xyz"), lambda A: A.remove_word(conv("she"))]:
+                self.A = ahocorasick.Automaton()
+                A = self.add_words_and_make_automaton()
+                if compact:
+                    A.compact()
+
+                calls = []
+                def callback(*match):
+                    calls.append(match)
+                    modify(A)
+
+                with self.assertRaisesRegex(ValueError, "changed"):
+                    A.find_all(conv(self.string), callback)
+
+                self.assertEqual(len(calls), 1)
+
+                A.make_automaton()
+                with self.assertRaisesRegex(ValueError, "changed"):
+                    A.find_all_spans(conv(self.string), lambda *match: A.add_word(conv("spans"), "spans"))
+
+
+class TestMinimize(TestAutomatonBase):
+
+    def make_automatons(self, words, store=ahocorasick.STORE_ANY):
+        value = None if store == ahocorasick.STORE_ANY else 1
+        result = []
+        for i in range(2):
+            A = ahocorasick.Automaton(store)
+            for word in words:
+                A.add_word(conv(word), value if store != ahocorasick.STORE_LENGTH else None)
+
+            A.make_automaton()
+            result.append(A)
+
+        result[1].minimize()
+        return result
+
+    def test_minimize_requires_automaton(self):
+        A = self.add_words()
+        with self.assertRaises(AttributeError):
+            A.minimize()
+
+    def test_search_results_are_unchanged(self):
+        import random
+        rnd = random.Random(42)
+        for store in [ahocorasick.STORE_ANY, ahocorasick.STORE_INTS, ahocorasick.STORE_LENGTH]:
+            words = set()
+            while len(words) < 300:
+                words.add(''.join(rnd.choice("abc") for _ in range(rnd.randint(1, 8))))
+
+            A, M = self.make_automatons(words, store)
+            self.assertTrue(M.minimized)
+            self.assertLessEqual(M.get_stats()["nodes_count"], A.get_stats()["nodes_count"])
+            self.assertEqual(len(A), len(M))
+            self.assertEqual(sorted(A.items()), sorted(M.items()))
+
+            for _ in range(20):
+                text = conv(''.join(rnd.choice("abcd") for _ in range(200)))
+                self.assertEqual(list(A.iter(text)), list(M.iter(text)))
+                self.assertEqual(list(A.iter_long(text)), list(M.iter_long(text)))
+
+    def test_suffixes_are_shared(self):
+        A, M = self.make_automatons(["creation", "nation", "station"])
+
+        self.assertEqual(22, A.get_stats()["nodes_count"])
+        self.assertEqual(10, M.get_stats()["nodes_count"])
+        self.assertEqual(3, M.get_stats()["words_count"])
+        self.assertEqual(len(M.dump()[0]), M.get_stats()["nodes_count"])
+        self.assertEqual(M.get(conv("nation")), None)
+        self.assertFalse(conv("ration") in M)
+
+    def test_minimized_is_read_only(self):
+        A, M = self.make_automatons(self.words)
+        with self.assertRaises(AttributeError):
+            M.add_word(conv("hi"), None)
+        with self.assertRaises(AttributeError):
+            M.add_words([(conv("hi"), None)])
+        with self.assertRaises(AttributeError):
+            M.remove_word(conv("he"))
+        with self.assertRaises(AttributeError):
+            M.pop(conv("he"))
+
+        self.assertFalse(M.make_automaton())
+
+    def test_pickle(self):
+        A, M = self.make_automatons(self.words)
+        B = pickle.loads(pickle.dumps(M))
+
+        self.assertTrue(B.minimized)
+        self.assertEqual(M.get_stats()["nodes_count"], B.get_stats()["nodes_count"])
+        self.assertEqual(list(A.iter(conv(self.string))), list(B.iter(conv(self.string))))
+
+    def test_clear(self):
+        A, M = self.make_automatons(self.words)
+
+        it = M.iter(conv(self.string))
+        M.clear()
+        self.assertFalse(M.minimized)
+        self.assertEqual(0, len(M))
+        with self.assertRaises(ValueError):
+            next(it)
+
+        M.add_word(conv("he"), 1)
+        self.assertEqual(1, M.get(conv("he")))
+
+
+class TestCompact(TestAutomatonBase):
+
+    def test_search_results_are_unchanged(self):
+        A = self.add_words_and_make_automaton()
+        expected = list(A.iter(conv(self.string)))
+        keys = list(A.keys())
+
+        A.compact()
+
+        self.assertEqual(expected, list(A.iter(conv(self.string))))
+        self.assertEqual(keys, list(A.keys()))
+        self.assertEqual(len(self.words), len(A))
+
+    def test_compact_invalidates_iterators(self):
+        A = self.add_words_and_make_automaton()
+
+        it = A.iter(conv(self.string))
+        A.compact()
+        with self.assertRaises(ValueError):
+            next(it)
+
+    def test_compact_and_modify(self):
+        A = self.add_words_and_make_automaton()
+        A.compact()
+        A.compact()
+
+        self.assertTrue(A.remove_word(conv("hers")))
+        A.add_word(conv("his"), "his")
+        A.make_automaton()
+
+        self.assertEqual(list(A.iter(conv("_hishers_"))), [(3, "his"), (5, "she"), (5, "he"), (6, "her")])
+
+        A.clear()
+        self.assertEqual(0, len(A))
+
+    def test_compact_minimized(self):
+        A = self.add_words_and_make_automaton()
+        expected = list(A.iter(conv(self.string)))
+
+        A.minimize()
+        A.compact()
+
+        self.assertTrue(A.minimized)
+        self.assertEqual(expected, list(A.iter(conv(self.string))))
+
+    def test_compact_empty(self):
+        A = ahocorasick.Automaton()
+        A.compact()
+        self.assertEqual(ahocorasick.EMPTY, A.kind)
+
+    def test_compact_after_removing_keys(self):
+        # fail links of removed nodes are left in the trie
+        A = ahocorasick.Automaton()
+        for word in ["abc", "bc", "c", "xbc"]:
+            A.add_word(conv(word), word)
+
+        A.make_automaton()
+        A.pop(conv("bc"))
+        A.pop(conv("c"))
+        A.compact()
+
+        A.make_automaton()
+        self.assertEqual(list(A.iter(conv("xabc"))), [(3, "abc")])
+
+
+class TestOptimize(TestAutomatonBase):
+
+    def test_search_results_are_unchanged(self):
+        A = self.add_words_and_make_automaton()
+        expected = list(A.iter(conv(self.string)))
+        expected_long = list(A.iter_long(conv(self.string)))
+
+        A.optimize([conv("shes hers"), conv("sssss"), conv("")])
+
+        self.assertEqual(expected, list(A.iter(conv(self.string))))
+        self.assertEqual(expected_long, list(A.iter_long(conv(self.string))))
+        self.assertEqual(sorted(conv(w) for w in self.words), sorted(A.keys()))
+
+    def test_optimize_keeps_key_ids(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_KEY_ID)
+        for word in self.words:
+            A.add_word(conv(word))
+        A.make_automaton()
+        expected = list(A.iter(conv(self.string)))
+
+        A.optimize([conv("zzzs"), conv(self.string)])
+
+        self.assertEqual(expected, list(A.iter(conv(self.string))))
+        self.assertEqual([conv(w) for w in sorted(self.words)], [A.key_of(i) for i in range(len(A))])
+
+    def test_optimize_invalid(self):
+        with self.assertRaises(AttributeError):
+            self.A.optimize([conv("he")])
+
+        A = self.add_words_and_make_automaton()
+        it = A.iter(conv(self.string))
+        with self.assertRaises(TypeError):
+            A.optimize([42])
+
+        A.optimize([])
+        with self.assertRaises(ValueError):
+            next(it)
+
 
 print_dumps = False
 
@@ -935,6 +1228,36 @@ class TestPickle(TestAutomatonBase):
 
         self.compare_automatons(A, B)
 
+    def test_empty_keeps_store_and_key_type(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS, ahocorasick.KEY_SEQUENCE)
+        B = pickle.loads(pickle.dumps(A))
+
+        self.assertEqual(ahocorasick.STORE_INTS, B.store)
+        B.add_word((1, 2, 3), 42)
+        self.assertEqual(42, B.get((1, 2, 3)))
+
+    def test_pickle_does_not_invalidate_iterators(self):
+        A = self.add_words_and_make_automaton()
+        expected = list(A.iter(conv(self.string)))
+
+        it = A.iter(conv(self.string))
+        first = next(it)
+        pickle.dumps(A)
+
+        self.assertEqual(expected, [first] + list(it))
+
+    def test_protocol5_out_of_band(self):
+        A = self.add_words_and_make_automaton()
+
+        buffers = []
+        dump = pickle.dumps(A, protocol=5, buffer_callback=buffers.append)
+        self.assertEqual(1, len(buffers))
+        self.assertLess(len(dump), len(buffers[0].raw()))
+
+        B = pickle.loads(dump, buffers=buffers)
+        self.compare_automatons(A, B)
+        self.assertEqual(list(A.iter(conv(self.string))), list(B.iter(conv(self.string))))
+
     def compare_automatons(self, A, B):
         if print_dumps:
             print([x for x in B.items()])
@@ -1018,6 +1341,21 @@ class TestTrieStoreInts(TestCase):
         with self.assertRaises(TypeError):
             self.A.add_word(conv("xyz"), None)
 
+    def test_pop_large_value(self):
+        value = min(2**40, sys.maxsize)
+        self.A.add_word(conv("xyz"), value)
+        self.assertEqual(self.A.pop(conv("xyz")), value)
+
+    def test_get_large_value(self):
+        value = min(2**40 + 5, sys.maxsize)
+        self.A.add_word(conv("xyz"), value)
+        self.assertEqual(self.A.get(conv("xyz")), value)
+        self.assertEqual(list(self.A.values()), [value])
+        self.assertEqual([v for k, v in self.A.items()], [value])
+
+        self.A.make_automaton()
+        self.assertEqual(list(self.A.iter(conv("_xyz_"))), [(3, value)])
+
     def test_iter(self):
         A = self.A
         for word in self.words:
@@ -1074,6 +1412,718 @@ class TestTrieStoreLengths(TestCase):
             self.assertEqual(len(key), value)
 
 
+class TestTypedStores(TestAutomatonBase):
+    "Test values kept in native columns (STORE_BYTES, STORE_INT64, STORE_FLOAT)"
+
+    stores = [
+        (ahocorasick.STORE_BYTES, [b"", b"value", b"x" * 1000]),
+        (ahocorasick.STORE_INT64, [0, -2**63, 2**63 - 1]),
+        (ahocorasick.STORE_FLOAT, [0.5, -1e300, float("inf")]),
+    ]
+
+    def make_automaton(self, store, values):
+        A = ahocorasick.Automaton(store)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), values[index % len(values)])
+
+        A.make_automaton()
+        return A
+
+    def test_get_and_items(self):
+        for store, values in self.stores:
+            A = self.make_automaton(store, values)
+            for index, word in enumerate(self.words):
+                self.assertEqual(A.get(conv(word)), values[index % len(values)])
+
+            self.assertEqual(A.store, store)
+            self.assertEqual(sorted(A.values()), sorted(value for key, value in A.items()))
+
+    def test_iter_and_find_all(self):
+        for store, values in self.stores:
+            A = self.make_automaton(store, values)
+            C = []
+            A.find_all(conv(self.string), lambda index, value: C.append((index, value)))
+
+            self.assertEqual(C, list(A.iter(conv(self.string))))
+
+    def test_replace_and_remove(self):
+        for store, values in self.stores:
+            A = ahocorasick.Automaton(store)
+            for i in range(1000):
+                A.add_word(conv(str(i)), values[i % 3])
+
+            for i in range(0, 1000, 2):
+                self.assertEqual(A.pop(conv(str(i))), values[i % 3])
+
+            A.add_words((conv(str(i)), values[(i + 1) % 3]) for i in range(1000))
+            for i in range(1000):
+                self.assertEqual(A.get(conv(str(i))), values[(i + 1) % 3])
+
+            self.assertTrue(A.remove_word(conv("1")))
+            self.assertEqual(len(A), 999)
+
+    def test_wrong_values(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_BYTES)
+        with self.assertRaisesRegex(TypeError, "A bytes value is required"):
+            A.add_word(conv("key"), "text")
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_INT64)
+        with self.assertRaisesRegex(TypeError, "An integer value is required"):
+            A.add_word(conv("key"), 1.5)
+
+        with self.assertRaises(OverflowError):
+            A.add_words([(conv("key"), 2**63)])
+
+        with self.assertRaisesRegex(ValueError, "A value object is required"):
+            A.add_word(conv("key"))
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_FLOAT)
+        with self.assertRaises(TypeError):
+            A.add_word(conv("key"), "1.5")
+
+        self.assertEqual(len(A), 0)
+
+    def test_save_load_and_pickle(self):
+        for store, values in self.stores:
+            A = self.make_automaton(store, values)
+            expected = list(A.items())
+
+            for compact in (False, True):
+                B = ahocorasick.load_bytes(A.save_bytes(compact=compact))
+                self.assertEqual(list(B.items()), expected)
+
+            for protocol in range(pickle.HIGHEST_PROTOCOL + 1):
+                B = pickle.loads(pickle.dumps(A, protocol=protocol))
+                self.assertEqual(list(B.items()), expected)
+                self.assertEqual(list(B.iter(conv(self.string))), list(A.iter(conv(self.string))))
+
+            A.minimize()
+            B = ahocorasick.load_bytes(A.save_bytes())
+            self.assertEqual(list(B.items()), expected)
+
+    def test_load_malformed_values(self):
+        A = self.make_automaton(ahocorasick.STORE_BYTES, [b"abc"])
+        data = bytearray(A.save_bytes())
+
+        # values: four lengths followed by four strings
+        offset = data.rfind(b"\x03\x00\x00\x00" * 4 + b"abc" * 4)
+        self.assertGreater(offset, 0)
+        data[offset] = 4
+
+        with self.assertRaisesRegex(ValueError, "malformed values"):
+            ahocorasick.load_bytes(bytes(data))
+
+
+class TestStoreKeyId(TestAutomatonBase):
+    "Test numbering keys (STORE_KEY_ID)"
+
+    def setUp(self):
+        super(TestStoreKeyId, self).setUp()
+        self.A = ahocorasick.Automaton(ahocorasick.STORE_KEY_ID)
+        self.A.add_words([conv(word) for word in self.words])
+        self.A.make_automaton()
+
+    def test_ids_are_ranks(self):
+        A = self.A
+        for index, word in enumerate(sorted(self.words)):
+            self.assertEqual(A.get(conv(word)), index)
+            self.assertEqual(A.key_of(index), conv(word))
+
+        with self.assertRaises(IndexError):
+            A.key_of(len(self.words))
+
+    def test_iter(self):
+        A = self.A
+        L = [(index, A.key_of(id)) for index, id in A.iter(conv(self.string))]
+        self.assertEqual(L, [(index, conv(word)) for index, word in self.correct_positons])
+
+    def test_keys_from_table(self):
+        A = self.A
+        self.assertEqual(list(A.keys()), [conv(word) for word in sorted(self.words)])
+        self.assertEqual(sorted(A.keys(conv("her"))), [conv("her"), conv("hers")])
+
+    def test_ids_after_modification(self):
+        A = self.A
+        A.add_word(conv("a"))
+        with self.assertRaises(AttributeError):
+            A.key_of(0)
+
+        A.make_automaton()
+        self.assertEqual(A.key_of(0), conv("a"))
+        self.assertEqual(A.get(conv("she")), len(self.words))
+
+    def test_save_load_and_pickle(self):
+        A = self.A
+        for B in [pickle.loads(pickle.dumps(A)), ahocorasick.load_bytes(A.save_bytes(compact=True))]:
+            self.assertEqual(list(B.items()), list(A.items()))
+            self.assertEqual(list(B.keys()), list(A.keys()))
+
+    def test_other_store(self):
+        A = ahocorasick.Automaton()
+        A.add_word(conv("key"), 1)
+        A.make_automaton()
+        with self.assertRaises(AttributeError):
+            A.key_of(0)
+
+
+class TestStoreMultiInts(TestAutomatonBase):
+    "Test keys associated with several integers (STORE_MULTI_INTS)"
+
+    def setUp(self):
+        super(TestStoreMultiInts, self).setUp()
+        self.A = ahocorasick.Automaton(ahocorasick.STORE_MULTI_INTS)
+
+    def test_add_word_appends(self):
+        A = self.A
+        self.assertTrue(A.add_word(conv("he"), 1))
+        self.assertFalse(A.add_word(conv("he"), -2))
+        self.assertEqual(A.add_words([(conv("she"), 3), (conv("he"), 2**40), (conv("she"), 4)]), 1)
+        self.assertEqual(len(A), 2)
+        self.assertEqual(A.get(conv("he")), (1, -2, 2**40))
+        self.assertEqual(A.get(conv("she")), (3, 4))
+
+        with self.assertRaises(TypeError):
+            A.add_word(conv("he"), "label")
+
+    def test_search(self):
+        A = self.A
+        A.add_words([(conv("he"), 1), (conv("she"), 2), (conv("he"), 3)])
+        A.make_automaton()
+        self.assertEqual(list(A.iter(conv("she"))), [(2, 2), (2, 1), (2, 3)])
+        self.assertEqual(list(A.iter_spans(conv("she"))), [(0, 2, 2), (1, 2, 1), (1, 2, 3)])
+
+        L = []
+        A.find_all(conv("she"), lambda index, value: L.append((index, value)))
+        self.assertEqual(L, list(A.iter(conv("she"))))
+
+    def test_remove_and_save(self):
+        A = self.A
+        for i in range(100):
+            A.add_word(conv("key%d" % (i % 7)), i)
+
+        self.assertEqual(A.pop(conv("key0")), tuple(range(0, 100, 7)))
+        A.add_word(conv("key0"), -1)
+
+        items = sorted(A.items())
+        for B in [pickle.loads(pickle.dumps(A)), ahocorasick.load_bytes(A.save_bytes(compact=True))]:
+            self.assertEqual(sorted(B.items()), items)
+
+
+class TestSpans(TestAutomatonBase):
+    "Test iter_spans and find_all_spans"
+
+    def setUp(self):
+        super(TestSpans, self).setUp()
+        self.add_words_and_make_automaton()
+
+    def spans(self):
+        return [(index - len(word) + 1, index, word) for index, word in self.correct_positons]
+
+    def test_iter_spans(self):
+        string = conv(self.string)
+        L = list(self.A.iter_spans(string))
+        self.assertEqual(L, self.spans())
+        for start, end, value in L:
+            self.assertEqual(string[start:end + 1], conv(value))
+
+    def test_find_all_spans(self):
+        L = []
+        self.A.find_all_spans(conv(self.string), lambda *span: L.append(span))
+        self.assertEqual(L, list(self.A.iter_spans(conv(self.string))))
+
+    def test_chunks(self):
+        string = conv(self.string)
+        it = self.A.iter_spans(string[:3])
+        L = list(it)
+        it.set(string[3:])
+        L.extend(it)
+        self.assertEqual(L, list(self.A.iter_spans(string)))
+
+    def test_loaded_and_compacted(self):
+        A = self.A
+        expected = list(A.iter_spans(conv(self.string)))
+        for B in [pickle.loads(pickle.dumps(A)), ahocorasick.load_bytes(A.save_bytes(pickle.dumps, compact=True), pickle.loads)]:
+            self.assertEqual(list(B.iter_spans(conv(self.string))), expected)
+
+        A.compact()
+        self.assertEqual(list(A.iter_spans(conv(self.string))), expected)
+
+    def test_minimized(self):
+        self.A.minimize()
+        with self.assertRaises(AttributeError):
+            self.A.iter_spans(conv(self.string))
+
+        with self.assertRaises(AttributeError):
+            self.A.find_all_spans(conv(self.string), print)
+
+
+class TestMasks(TestAutomatonBase):
+    "Test filtering matches by category masks"
+
+    def setUp(self):
+        super(TestMasks, self).setUp()
+        A = self.A
+        A.add_word(conv("he"), "he", mask=1)
+        A.add_word(conv("she"), "she", mask=2)
+        A.add_word(conv("she"), "she", mask=8)
+        A.add_word(conv("hers"), "hers")
+        A.add_words([(conv("his"), "his"), (conv("is"), "is")], mask=4)
+        A.make_automaton()
+        self.string = conv("ushers this")
+
+    def expected(self, mask):
+        masks = {"he": 1, "she": 2 | 8, "his": 4, "is": 4}
+        return [(index, value) for index, value in self.A.iter(self.string)
+                if masks.get(value, mask) & mask]
+
+    def test_iter_and_find_all(self):
+        A = self.A
+        for mask in [1, 2, 3, 4, 8, 16, 2**64 - 1]:
+            self.assertEqual(list(A.iter(self.string, mask=mask)), self.expected(mask))
+
+            L = []
+            A.find_all(self.string, lambda index, value: L.append((index, value)), mask=mask)
+            self.assertEqual(L, self.expected(mask))
+
+            spans = [(end - len(value) + 1, end, value) for end, value in self.expected(mask)]
+            self.assertEqual(list(A.iter_spans(self.string, mask=mask)), spans)
+
+            L = []
+            A.find_all_spans(self.string, lambda *span: L.append(span), mask=mask)
+            self.assertEqual(L, spans)
+
+    def test_invalid_mask(self):
+        for mask in [0, -1, 2**64, conv("mask")]:
+            with self.assertRaises((TypeError, ValueError, OverflowError)):
+                self.A.iter(self.string, mask=mask)
+
+            with self.assertRaises((TypeError, ValueError, OverflowError)):
+                self.A.add_word(conv("key"), 1, mask=mask)
+
+        with self.assertRaises(TypeError):
+            self.A.find_all(self.string, print, bits=1)
+
+        self.assertFalse(conv("key") in self.A)
+
+    def test_remove_word(self):
+        A = self.A
+        A.remove_word(conv("he"))
+        A.add_word(conv("he"), "he")
+        A.make_automaton()
+        self.assertEqual(list(A.iter(self.string, mask=4)), [(3, "he"), (5, "hers"), (10, "his"), (10, "is")])
+
+    def test_remove_all_masked_words(self):
+        A = self.A
+        for word in ["he", "she", "his"]:
+            A.remove_word(conv(word))
+        A.pop(conv("is"))
+        A.make_automaton()
+
+        # masks of removed keys aren't saved
+        B = ahocorasick.Automaton()
+        B.add_word(conv("hers"), "hers")
+        B.make_automaton()
+        self.assertEqual(A.save_bytes(pickle.dumps), B.save_bytes(pickle.dumps))
+        self.assertEqual(list(A.iter(self.string, mask=1)), [(5, "hers")])
+
+    def test_compact_minimize_and_save(self):
+        A = self.A
+        expected = [list(A.iter(self.string, mask=mask)) for mask in [1, 2, 4]]
+
+        B = pickle.loads(pickle.dumps(A))
+        C = ahocorasick.load_bytes(A.save_bytes(pickle.dumps, compact=True), pickle.loads)
+        A.compact()
+        D = ahocorasick.load_bytes(A.save_bytes(pickle.dumps), pickle.loads)
+        D.minimize()
+        for X in [A, B, C, D]:
+            self.assertEqual([list(X.iter(self.string, mask=mask)) for mask in [1, 2, 4]], expected)
+
+
+    def test_compact_and_add_words(self):
+        # nodes of the pool and nodes added later keep masks apart
+        A = self.A
+        A.compact()
+        A.add_word(conv("this"), "this", mask=16)
+        A.add_word(conv("hi"), "hi", mask=1)
+        A.make_automaton()
+
+        masks = {"he": 1, "she": 2 | 8, "his": 4, "is": 4, "this": 16, "hi": 1}
+        for mask in [1, 2, 4, 16, 32]:
+            expected = [(index, value) for index, value in A.iter(self.string)
+                        if masks.get(value, mask) & mask]
+            self.assertEqual(list(A.iter(self.string, mask=mask)), expected)
+
+class TestRootSkip(TestCase):
+    "Test that skipping positions in the root state doesn't lose matches"
+
+    def naive(self, words, string):
+        return sorted((i + len(word) - 1, word) for word in words
+                      for i in range(len(string)) if string.startswith(word, i))
+
+    def test_random(self):
+        import random
+        rnd = random.Random(42)
+        words = set("".join(rnd.choice("abcd") for _ in range(rnd.randint(1, 4))) for _ in range(20))
+        A = ahocorasick.Automaton()
+        for word in words:
+            A.add_word(conv(word), word)
+
+        A.make_automaton()
+        for _ in range(20):
+            string = "".join(rnd.choice("abcdxyz ") for _ in range(200))
+            L = [(end, word) for end, word in A.iter(conv(string))]
+            self.assertEqual(sorted(L), self.naive(words, string))
+
+            R = []
+            A.find_all(conv(string), lambda end, word: R.append((end, word)))
+            self.assertEqual(R, L)
+
+            it = A.iter(conv(""))
+            it.set(conv(string[:100]))
+            chunks = list(it)
+            it.set(conv(string[100:]))
+            self.assertEqual(chunks + list(it), L)
+
+    def test_letters_sharing_lowest_byte(self):
+        if not ahocorasick.unicode:
+            return
+
+        A = ahocorasick.Automaton()
+        A.add_word("\u0161a", 1)
+        A.make_automaton()
+        self.assertEqual(list(A.iter("aa\u0161a\u0261a")), [(3, 1)])
+
+    def test_first_two_letters(self):
+        A = ahocorasick.Automaton()
+        A.add_words([(conv("x"), "x"), (conv("abc"), "abc"), (conv("bd"), "bd")])
+        A.make_automaton()
+
+        string = conv("ab abd xbd")
+        expected = [(5, "bd"), (7, "x"), (9, "bd")]
+        self.assertEqual(list(A.iter(string)), expected)
+
+        # keys spanning over chunks
+        it = A.iter(conv(""))
+        it.set(conv("aab"))
+        self.assertEqual(list(it), [])
+        it.set(conv("cbx"))
+        self.assertEqual(list(it), [(3, "abc"), (5, "x")])
+
+    def test_engines(self):
+        import random
+        rnd = random.Random(11)
+        engines = [ahocorasick.ENGINE_TRIE, ahocorasick.ENGINE_LETTERS,
+                   ahocorasick.ENGINE_BIGRAMS, ahocorasick.ENGINE_SHIFTS]
+
+        words = set("".join(rnd.choice("abc") for _ in range(rnd.randint(3, 10))) for _ in range(10))
+        string = "".join(rnd.choice("abcx") for _ in range(500))
+        expected = self.naive(words, string)
+
+        A = ahocorasick.Automaton()
+        for word in words:
+            A.add_word(conv(word), word)
+
+        A.make_automaton(engine=ahocorasick.ENGINE_AUTO)
+        self.assertEqual(A.get_stats()["engine"], ahocorasick.ENGINE_BIGRAMS)
+        for engine in engines:
+            A.make_automaton(engine=engine)
+            self.assertEqual(A.get_stats()["engine"], engine)
+            self.assertEqual(sorted(A.iter(conv(string))), expected)
+
+        with self.assertRaises(ValueError):
+            A.make_automaton(engine=-1)
+
+    def test_engine_selection(self):
+        A = ahocorasick.Automaton()
+        A.add_word(conv("a" * 10), 1)
+        A.make_automaton()
+        self.assertEqual(A.get_stats()["engine"], ahocorasick.ENGINE_SHIFTS)
+
+        A.add_word(conv("ab"), 2)
+        A.make_automaton()
+        self.assertEqual(A.get_stats()["engine"], ahocorasick.ENGINE_BIGRAMS)
+
+        # the shortest key doesn't fit a block of the shift table
+        A.make_automaton(engine=ahocorasick.ENGINE_SHIFTS)
+        self.assertEqual(A.get_stats()["engine"], ahocorasick.ENGINE_BIGRAMS)
+
+    def test_engine_is_kept(self):
+        A = ahocorasick.Automaton()
+        A.add_words([(conv("he"), 1), (conv("she"), 2)])
+        A.make_automaton(engine=ahocorasick.ENGINE_LETTERS)
+
+        A.add_word(conv("hers"), 3)
+        A.make_automaton()
+        self.assertEqual(A.get_stats()["engine"], ahocorasick.ENGINE_LETTERS)
+
+        # changing settings of a built automaton keeps iterators valid
+        it = A.iter(conv("ushers"))
+        self.assertEqual(next(it), (3, 2))
+        self.assertFalse(A.make_automaton(engine=ahocorasick.ENGINE_TRIE, cache=16))
+        self.assertEqual(list(it), [(3, 1), (5, 3)])
+        self.assertEqual(A.get_stats()["engine"], ahocorasick.ENGINE_TRIE)
+
+    def test_long_keys(self):
+        import random
+        rnd = random.Random(7)
+        words = set("".join(rnd.choice("abc") for _ in range(rnd.randint(8, 12))) for _ in range(10))
+        A = ahocorasick.Automaton()
+        for word in words:
+            A.add_word(conv(word), word)
+
+        A.make_automaton()
+        for _ in range(20):
+            string = "".join(rnd.choice("abcx") for _ in range(500))
+            string += rnd.choice(sorted(words))
+            L = [(end, word) for end, word in A.iter(conv(string))]
+            self.assertEqual(sorted(L), self.naive(words, string))
+
+            R = []
+            A.find_all(conv(string), lambda end, word: R.append((end, word)))
+            self.assertEqual(R, L)
+
+            it = A.iter(conv(""))
+            it.set(conv(string[:255]))
+            chunks = list(it)
+            it.set(conv(string[255:]))
+            self.assertEqual(chunks + list(it), L)
+
+    def test_wide_root(self):
+        # the root has enough edges to get the root table
+        import random
+        rnd = random.Random(5)
+        if ahocorasick.unicode:
+            letters = [chr(0x4e00 + i) for i in range(300)] + ["a", "\U0001f600"]
+            words = set("".join(rnd.choice(letters) for _ in range(rnd.randint(1, 3))) for _ in range(500))
+            A = ahocorasick.Automaton()
+            for word in words:
+                A.add_word(word, word)
+
+            A.make_automaton()
+            string = "".join(rnd.choice(letters + ["b", "\u4e00\u0100"]) for _ in range(2000))
+            self.assertEqual(sorted(A.iter(string)), self.naive(words, string))
+            self.assertEqual(A.search_many([string])[0], list(A.iter(string)))
+
+        # integer letters may be outside of the table
+        maxletter = 0xffffffff if ahocorasick.unicode else 0xffff
+        A = ahocorasick.Automaton(ahocorasick.STORE_ANY, ahocorasick.KEY_SEQUENCE)
+        for i in range(64):
+            A.add_word((i * 1000 % (maxletter + 1), 1), i)
+        A.add_word((maxletter, 2), "max")
+        A.make_automaton()
+
+        self.assertEqual(list(A.iter((5, maxletter, 2, 63000 % (maxletter + 1), 1))), [(2, "max"), (4, 63)])
+
+
+    def test_letters_absent_in_keys(self):
+        A = ahocorasick.Automaton()
+        A.add_words([(conv("abc"), "abc"), (conv("bcd"), "bcd"), (conv("cx"), "cx")])
+        self.assertEqual(A.get_stats()["alphabet_size"], 0)
+
+        A.make_automaton()
+        self.assertEqual(A.get_stats()["alphabet_size"], 5)
+
+        # a letter absent in keys breaks partial matches
+        string = conv("abzcd abcx bcd-abcd")
+        self.assertEqual(list(A.iter(string)), [(8, "abc"), (9, "cx"), (13, "bcd"), (17, "abc"), (18, "bcd")])
+
+        it = A.iter(conv(""))
+        it.set(conv("ab"))
+        self.assertEqual(list(it), [])
+        it.set(conv("cx"))
+        self.assertEqual(list(it), [(2, "abc"), (3, "cx")])
+
+    def test_letters_of_minimized(self):
+        # nodes shared by keys are classified once
+        A = ahocorasick.Automaton(ahocorasick.STORE_LENGTH)
+        for word in ["abcd", "xbcd", "ybcd", "zbcd", "bcd"]:
+            A.add_word(conv(word))
+
+        A.make_automaton()
+        string = conv("abcd xbcd-wbcd")
+        expected = list(A.iter(string))
+
+        A.minimize()
+        self.assertEqual(list(A.iter(string)), expected)
+        self.assertEqual(A.get_stats()["alphabet_size"], 7)
+
+
+class TestTransitionCache(TestCase):
+    "Test searching with the cache of transitions"
+
+    def test_same_as_without_cache(self):
+        import random
+        rnd = random.Random(3)
+        words = set("".join(rnd.choice("abcd") for _ in range(rnd.randint(1, 5))) for _ in range(30))
+        strings = ["".join(rnd.choice("abcdxy") for _ in range(300)) for _ in range(10)]
+
+        A = ahocorasick.Automaton()
+        for word in words:
+            A.add_word(conv(word), word)
+
+        A.make_automaton()
+        expected = [list(A.iter(conv(string))) for string in strings]
+
+        # a tiny cache has many collisions
+        for size in (1, 4, 1000):
+            A.make_automaton(cache=size)
+            self.assertEqual([list(A.iter(conv(string))) for string in strings], expected)
+            self.assertEqual(A.search_many([conv(string) for string in strings]), expected)
+
+            R = []
+            A.find_all(conv(strings[0]), lambda end, word: R.append((end, word)))
+            self.assertEqual(R, expected[0])
+
+    def test_stats(self):
+        A = ahocorasick.Automaton()
+        A.add_words([(conv("he"), 1), (conv("she"), 2), (conv("hers"), 3)])
+        A.make_automaton(cache=1000)
+
+        s = A.get_stats()
+        self.assertEqual((s["cache_size"], s["cache_hits"], s["cache_misses"]), (1024, 0, 0))
+
+        list(A.iter(conv("ushershe")))
+        s = A.get_stats()
+        self.assertTrue(s["cache_misses"] > 0)
+
+        # the same transitions are taken again; entries are indexed by addresses
+        # of nodes, thus two transitions may collide
+        list(A.iter(conv("ushershe")))
+        t = A.get_stats()
+        self.assertEqual(t["cache_hits"] + t["cache_misses"], 2 * (s["cache_hits"] + s["cache_misses"]))
+        self.assertTrue(t["cache_hits"] > s["cache_hits"])
+
+        # the cache is emptied when the automaton changes and released without a size
+        A.add_word(conv("his"), 4)
+        A.make_automaton()
+        self.assertEqual(A.get_stats()["cache_hits"], 0)
+        self.assertEqual(A.get_stats()["cache_size"], 1024)
+        A.make_automaton(cache=0)
+        self.assertEqual(A.get_stats()["cache_size"], 0)
+
+        with self.assertRaises(ValueError):
+            A.make_automaton(cache=-1)
+
+
+class TestSearchMany(TestCase):
+    "Test searching several strings at once"
+
+    def test_same_as_iter(self):
+        import random
+        rnd = random.Random(5)
+        words = set("".join(rnd.choice("abcd") for _ in range(rnd.randint(1, 5))) for _ in range(30))
+        strings = ["".join(rnd.choice("abcdx") for _ in range(rnd.randint(0, 100))) for _ in range(20)]
+
+        A = ahocorasick.Automaton()
+        for word in words:
+            A.add_word(conv(word), word)
+
+        A.make_automaton()
+        expected = [list(A.iter(conv(string))) for string in strings]
+        for interleave in (1, 3, 8, 64):
+            self.assertEqual(A.search_many([conv(s) for s in strings], interleave=interleave), expected)
+
+        self.assertEqual(A.search_many(conv(s) for s in strings), expected)
+        self.assertEqual(A.search_many([]), [])
+
+    def test_multi_ints(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_MULTI_INTS)
+        A.add_words([(conv("he"), 1), (conv("he"), 2), (conv("she"), 3)])
+        A.make_automaton()
+        self.assertEqual(A.search_many([conv("she")]), [[(2, 3), (2, 1), (2, 2)]])
+
+    def test_not_an_automaton(self):
+        A = ahocorasick.Automaton()
+        A.add_word(conv("he"), 1)
+        self.assertEqual(A.search_many([conv("he"), conv("she")]), [[], []])
+
+    def test_errors(self):
+        A = ahocorasick.Automaton()
+        A.add_word(conv("he"), 1)
+        A.make_automaton()
+        with self.assertRaises(ValueError):
+            A.search_many([conv("he")], interleave=0)
+
+        with self.assertRaises(TypeError):
+            A.search_many([conv("he")] * 10 + [None], interleave=2)
+
+
+class TestAutomatonSet(TestCase):
+    "Test searching several automatons at once"
+
+    def setUp(self):
+        self.A = ahocorasick.Automaton()
+        self.A.add_words([(conv("he"), "he"), (conv("hers"), "hers"), (conv("is"), "is")])
+        self.B = ahocorasick.Automaton(ahocorasick.STORE_LENGTH)
+        self.B.add_words([conv("she"), conv("he"), conv("this")])
+        self.C = ahocorasick.Automaton(ahocorasick.STORE_MULTI_INTS)
+        self.C.add_words([(conv("is"), 1), (conv("is"), 2)])
+        self.automatons = [self.A, self.B, self.C]
+        for automaton in self.automatons:
+            automaton.make_automaton()
+
+        self.string = conv("ushers this")
+
+    def test_iter(self):
+        S = ahocorasick.AutomatonSet(self.automatons)
+        self.assertEqual(S.automatons, tuple(self.automatons))
+        L = list(S.iter(self.string))
+        self.assertEqual(L, [
+            (1, 3, 3), (0, 3, "he"), (1, 3, 2), (0, 5, "hers"),
+            (1, 10, 4), (0, 10, "is"), (2, 10, 1), (2, 10, 2),
+        ])
+
+        for index, automaton in enumerate(self.automatons):
+            self.assertEqual([match[1:] for match in L if match[0] == index], list(automaton.iter(self.string)))
+
+        R = []
+        S.find_all(self.string, lambda *match: R.append(match))
+        self.assertEqual(R, L)
+        self.assertEqual(list(S.iter(self.string, 2, 9)), [(0, 3, "he"), (1, 3, 2), (0, 5, "hers")])
+
+    def test_update(self):
+        S = ahocorasick.AutomatonSet(self.automatons)
+        it = S.iter(self.string)
+        next(it)
+
+        self.B.add_word(conv("us"))
+        with self.assertRaises(ValueError):
+            next(it)
+
+        self.A.remove_word(conv("hers"))
+        self.A.add_word(conv("he"), "HE")
+        self.C.minimize()
+        self.assertEqual(list(S.iter(conv("ushe"))), [(1, 1, 2), (1, 3, 3), (0, 3, "HE"), (1, 3, 2)])
+
+    def test_update_other_automaton(self):
+        S = ahocorasick.AutomatonSet(self.automatons)
+        it = S.iter(self.string)
+        self.assertEqual(next(it), (1, 3, 3))
+
+        # changes of automatons outside the set don't invalidate iterators
+        D = ahocorasick.Automaton()
+        D.add_word(conv("us"), "us")
+        self.assertEqual(next(it), (0, 3, "he"))
+
+        self.C.add_word(conv("th"), 3)
+        with self.assertRaises(ValueError):
+            next(it)
+
+    def test_invalid(self):
+        with self.assertRaises(TypeError):
+            ahocorasick.AutomatonSet([self.A, "automaton"])
+
+        with self.assertRaises(ValueError):
+            ahocorasick.AutomatonSet([self.A, ahocorasick.Automaton(ahocorasick.STORE_ANY, ahocorasick.KEY_SEQUENCE)])
+
+        self.assertEqual(list(ahocorasick.AutomatonSet([]).iter(self.string)), [])
+        self.assertEqual(list(ahocorasick.AutomatonSet([ahocorasick.Automaton()]).iter(self.string)), [])
+
+    def test_find_all_callback_modifies_automaton(self):
+        S = ahocorasick.AutomatonSet(self.automatons)
+        with self.assertRaisesRegex(ValueError, "changed"):
+            S.find_all(self.string, lambda *match: self.A.remove_word(conv("hers")))
+
 class TestSizeOf(TestCase):
 
     def setUp(self):
@@ -1471,6 +2521,374 @@ class TestLoadSave(TestAutomatonBase):
 
         self.compare_automatons(A, B)
 
+    def test_save_and_load_minimized(self):
+        A = self.add_words_and_make_automaton();
+        A.minimize()
+
+        A.save(self.path, pickle.dumps)
+        B = ahocorasick.load(self.path, pickle.loads)
+
+        self.assertTrue(B.minimized)
+        self.assertEqual(A.get_stats(), B.get_stats())
+        self.compare_automatons(A, B)
+        self.assertEqual(list(A.iter(conv(self.string))), list(B.iter(conv(self.string))))
+
+    def test_load_and_modify(self):
+        A = self.add_words_and_make_automaton();
+        A.save(self.path, pickle.dumps)
+        B = ahocorasick.load(self.path, pickle.loads)
+
+        for word in ["hers", "she"]:
+            self.assertTrue(A.remove_word(conv(word)))
+            self.assertTrue(B.remove_word(conv(word)))
+
+        for word in ["his", "here"]:
+            A.add_word(conv(word), word)
+            B.add_word(conv(word), word)
+
+        A.make_automaton()
+        B.make_automaton()
+
+        self.compare_automatons(A, B)
+        self.assertEqual(list(A.iter(conv(self.string))), list(B.iter(conv(self.string))))
+
+        B.clear()
+        self.assertEqual(0, len(B))
+
+    def test_save_serializes_each_value(self):
+        A = self.add_words_and_make_automaton();
+        calls = []
+
+        def serializer(value):
+            calls.append(value)
+            return pickle.dumps(value)
+
+        def deserializer(data):
+            calls.append(data)
+            return pickle.loads(data)
+
+        A.save(self.path, serializer)
+        self.assertEqual(sorted(A.values()), sorted(calls))
+
+        del calls[:]
+        B = ahocorasick.load(self.path, deserializer)
+        self.assertEqual(len(A), len(calls))
+        self.compare_automatons(A, B)
+
+    def test_save_serializes_values_at_once(self):
+        A = self.add_words_and_make_automaton();
+        calls = []
+
+        def serializer(values):
+            calls.append(values)
+            return pickle.dumps(values)
+
+        for compact in [False, True]:
+            del calls[:]
+            A.save(self.path, serializer, compact=compact, values_list=True)
+            self.assertEqual(1, len(calls))
+            self.assertEqual(sorted(A.values()), sorted(calls[0]))
+
+            B = ahocorasick.load(self.path, pickle.loads)
+            self.assertEqual(sorted(A.items()), sorted(B.items()))
+
+        B = ahocorasick.load_bytes(A.save_bytes(serializer, values_list=True), pickle.loads)
+        self.compare_automatons(A, B)
+
+    def test_save_and_load_compact(self):
+        A = self.add_words_and_make_automaton();
+
+        A.save(self.path, pickle.dumps, compact=True)
+        B = ahocorasick.load(self.path, pickle.loads)
+
+        self.compare_automatons(A, B)
+        self.assertEqual(list(A.iter(conv(self.string))), list(B.iter(conv(self.string))))
+
+    def test_save_and_load_compact_ints(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for i, word in enumerate("he she her cat car carriage zoo".split()):
+            A.add_word(conv(word), (i - 3) * 1000000007)
+
+        A.save(self.path)
+        size = os.path.getsize(self.path)
+
+        A.save(self.path, compact=True)
+        self.assertLess(os.path.getsize(self.path), size)
+
+        # compact format stores letters sorted, thus the order of keys may differ
+        B = ahocorasick.load(self.path, pickle.loads)
+        self.assertEqual(sorted(A.items()), sorted(B.items()))
+
+    def test_save_and_load_compact_minimized(self):
+        A = self.add_words_and_make_automaton();
+        A.minimize()
+
+        A.save(self.path, pickle.dumps, compact=True)
+        B = ahocorasick.load(self.path, pickle.loads)
+
+        self.assertTrue(B.minimized)
+        self.assertEqual(A.get_stats(), B.get_stats())
+        self.assertEqual(list(A.iter(conv(self.string))), list(B.iter(conv(self.string))))
+
+    def test_save__invalid_keyword(self):
+        A = self.add_words_and_make_automaton();
+        with self.assertRaisesRegex(TypeError, "the only keyword arguments accepted are compact and values_list"):
+            A.save(self.path, pickle.dumps, foo=True)
+
+    def test_load__truncated_file(self):
+        A = self.add_words_and_make_automaton();
+        for compact in [False, True]:
+            A.save(self.path, pickle.dumps, compact=compact)
+
+            with open(self.path, "rb") as f:
+                data = f.read()
+
+            with open(self.path, "wb") as f:
+                f.write(data[:len(data) // 2])
+
+            with self.assertRaises((ValueError, IOError)):
+                ahocorasick.load(self.path, pickle.loads)
+
+    def test_save_bytes_and_load_bytes(self):
+        A = self.add_words_and_make_automaton();
+        for compact in [False, True]:
+            data = A.save_bytes(pickle.dumps, compact=compact)
+            self.assertIsInstance(data, bytes)
+
+            for buffer in [data, bytearray(data), memoryview(data)]:
+                B = ahocorasick.load_bytes(buffer, pickle.loads)
+                self.assertEqual(sorted(A.items()), sorted(B.items()))
+                self.assertEqual(list(A.iter(conv(self.string))), list(B.iter(conv(self.string))))
+
+    def test_save_bytes_is_the_file_format(self):
+        A = self.add_words_and_make_automaton();
+        A.save(self.path, pickle.dumps)
+
+        with open(self.path, "rb") as f:
+            self.assertEqual(f.read(), A.save_bytes(pickle.dumps))
+
+        B = ahocorasick.load(self.path, pickle.loads)
+        self.compare_automatons(A, B)
+
+    def test_save_bytes_ints(self):
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), index)
+
+        B = ahocorasick.load_bytes(A.save_bytes())
+        self.assertEqual(ahocorasick.STORE_INTS, B.store)
+        self.assertEqual(list(A.items()), list(B.items()))
+
+    def test_save_bytes_and_load_bytes__missing_callable(self):
+        A = self.add_words_and_make_automaton();
+        with self.assertRaisesRegex(ValueError, "serializer must be given"):
+            A.save_bytes()
+
+        with self.assertRaisesRegex(ValueError, "deserializer must be given"):
+            ahocorasick.load_bytes(A.save_bytes(pickle.dumps))
+
+    def test_load_bytes__truncated_data(self):
+        A = self.add_words_and_make_automaton();
+        data = A.save_bytes(pickle.dumps)
+        for size in [0, 10, len(data) // 2, len(data) - 1]:
+            with self.assertRaises(ValueError):
+                ahocorasick.load_bytes(data[:size], pickle.loads)
+
+    def test_load_bytes__malformed_counts(self):
+        import struct
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), index)
+
+        A.make_automaton()
+        data = A.save_bytes()
+
+        # the header is followed by the header of the format version 3, then nodes
+        words_count_offset = 32
+        root_n_offset      = 64 + 12
+        self.assertEqual(struct.unpack_from("=Q", data, words_count_offset)[0], len(A))
+        self.assertEqual(struct.unpack_from("=I", data, root_n_offset)[0], len(set(word[0] for word in self.words)))
+
+        for words_count in [0, len(A) - 1, len(A) + 1]:
+            corrupted = bytearray(data)
+            struct.pack_into("=Q", corrupted, words_count_offset, words_count)
+            with self.assertRaisesRegex(ValueError, "keys expected"):
+                ahocorasick.load_bytes(bytes(corrupted))
+
+        for n in [A.get_stats()["nodes_count"], len(data), 0xffffffff]:
+            corrupted = bytearray(data)
+            struct.pack_into("=I", corrupted, root_n_offset, n)
+            with self.assertRaisesRegex(ValueError, "malformed"):
+                ahocorasick.load_bytes(bytes(corrupted))
+
+            with open(self.path, "wb") as f:
+                f.write(corrupted)
+
+            with self.assertRaisesRegex(ValueError, "malformed"):
+                ahocorasick.load(self.path, pickle.loads)
+
+    def test_load_bytes__minimized_cycle(self):
+        import struct
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), index)
+
+        A.make_automaton()
+        A.minimize()
+        data = A.save_bytes()
+        self.assertEqual(list(A.items()), list(ahocorasick.load_bytes(data).items()))
+
+        # nodes are {output, fail, n, eow} followed by n edges {letter, child}
+        letter_size = struct.unpack_from("=I", data, 60)[0]
+        edge_size   = letter_size + 4
+        offset      = 64
+        index       = 0
+        while True:
+            n = struct.unpack_from("=I", data, offset + 12)[0]
+            if index > 0 and n > 0:
+                break
+
+            offset += 17 + n * edge_size
+            index  += 1
+
+        # the first edge of a node leads back to the node
+        corrupted = bytearray(data)
+        struct.pack_into("=I", corrupted, offset + 17 + letter_size, index)
+        with self.assertRaisesRegex(ValueError, "cycle"):
+            ahocorasick.load_bytes(bytes(corrupted))
+
+    def test_load_bytes__minimized_orphan_node(self):
+        import struct
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), index)
+
+        A.make_automaton()
+        A.minimize()
+        data = A.save_bytes()
+
+        # the first edge of the root leads to the child of the second edge,
+        # thus nothing enters the former child
+        letter_size = struct.unpack_from("=I", data, 60)[0]
+        edges       = 64 + 17
+        first       = struct.unpack_from("=I", data, edges + letter_size)[0]
+        second      = struct.unpack_from("=I", data, edges + 2 * letter_size + 4)[0]
+        self.assertNotEqual(first, second)
+
+        corrupted = bytearray(data)
+        struct.pack_into("=I", corrupted, edges + letter_size, second)
+        with self.assertRaisesRegex(ValueError, "not reachable from the root"):
+            ahocorasick.load_bytes(bytes(corrupted))
+
+    def test_load_bytes__malformed_fail_links(self):
+        import struct
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), index)
+
+        A.make_automaton()
+        plain = A.save_bytes()
+        A.minimize()
+        minimized = A.save_bytes()
+
+        # the fail link of the node following the root: back to the node or none
+        fail_offset = 64 + 17 + struct.unpack_from("=I", plain, 64 + 12)[0] * (struct.unpack_from("=I", plain, 60)[0] + 4) + 8
+        for data, regex in [(plain, "malformed"), (minimized, "fail links")]:
+            for fail in [1, 0xffffffff]:
+                corrupted = bytearray(data)
+                struct.pack_into("=I", corrupted, fail_offset, fail)
+                with self.assertRaisesRegex(ValueError, regex):
+                    ahocorasick.load_bytes(bytes(corrupted))
+
+    def test_load_bytes__plain_trie_shared_child(self):
+        import struct
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), index)
+
+        data = A.save_bytes()
+
+        # children of the root: shared by both edges or swapped; children
+        # of a plain trie must be the next unassigned nodes
+        letter_size = struct.unpack_from("=I", data, 60)[0]
+        edge_size   = letter_size + 4
+        edges       = 64 + 17
+        first       = struct.unpack_from("=I", data, edges + letter_size)[0]
+        second      = struct.unpack_from("=I", data, edges + edge_size + letter_size)[0]
+        for children in [(first, first), (second, first)]:
+            corrupted = bytearray(data)
+            for i, child in enumerate(children):
+                struct.pack_into("=I", corrupted, edges + i * edge_size + letter_size, child)
+
+            with self.assertRaisesRegex(ValueError, "malformed"):
+                ahocorasick.load_bytes(bytes(corrupted))
+
+    def test_load_bytes__malformed_header_and_letters(self):
+        import struct
+
+        A = ahocorasick.Automaton(ahocorasick.STORE_INTS)
+        for index, word in enumerate(self.words):
+            A.add_word(conv(word), index)
+
+        A.make_automaton()
+        data = A.save_bytes()
+
+        # words count is followed by the length of the longest word
+        corrupted = bytearray(data)
+        struct.pack_into("=Q", corrupted, 32, 1 << 40)
+        with self.assertRaisesRegex(ValueError, "malformed"):
+            ahocorasick.load_bytes(bytes(corrupted))
+
+        for longest_word in [0, 1, 1 << 30]:
+            corrupted = bytearray(data)
+            struct.pack_into("=i", corrupted, 40, longest_word)
+            B = ahocorasick.load_bytes(bytes(corrupted))
+            self.assertEqual(B.get_stats()["longest_word"], A.get_stats()["longest_word"])
+            self.assertEqual(sorted(B.keys()), sorted(A.keys()))
+
+        # the first edge of the root leads to a letter not being a code point;
+        # any 16-bit letter is valid
+        if struct.unpack_from("=I", data, 60)[0] != 4:
+            return
+
+        corrupted = bytearray(data)
+        struct.pack_into("=I", corrupted, 64 + 17, 0x110000)
+        with self.assertRaisesRegex(ValueError, "malformed"):
+            ahocorasick.load_bytes(bytes(corrupted))
+
+    def test_load__malformed_values_size(self):
+        import struct
+
+        for store, value in [(ahocorasick.STORE_ANY, "value"), (ahocorasick.STORE_BYTES, b"value")]:
+            A = ahocorasick.Automaton(store)
+            for word in self.words:
+                A.add_word(conv(word), value)
+
+            data = A.save_bytes(pickle.dumps)
+
+            # the size of values follows nodes
+            nodes_count = struct.unpack_from("=Q", data, 48)[0]
+            edge_size   = struct.unpack_from("=I", data, 60)[0] + 4
+            offset      = 64
+            for i in range(nodes_count):
+                offset += 17 + struct.unpack_from("=I", data, offset + 12)[0] * edge_size
+
+            corrupted = bytearray(data)
+            struct.pack_into("=Q", corrupted, offset, 1 << 60)
+            with self.assertRaisesRegex(ValueError, "malformed values"):
+                ahocorasick.load_bytes(bytes(corrupted), pickle.loads)
+
+            with open(self.path, "wb") as f:
+                f.write(corrupted)
+
+            with self.assertRaisesRegex(ValueError, "malformed values"):
+                ahocorasick.load(self.path, pickle.loads)
+
     def compare_automatons(self, A, B):
         if print_dumps:
             print([x for x in B.items()])